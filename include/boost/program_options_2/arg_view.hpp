@@ -7,13 +7,17 @@
 #define BOOST_PROGRAM_OPTIONS_2_ARG_VIEW_HPP
 
 #include <boost/program_options_2/config.hpp>
+#include <boost/program_options_2/detail/special_bytes.hpp>
 
 #include <boost/assert.hpp>
 #include <boost/stl_interfaces/iterator_interface.hpp>
 #include <boost/stl_interfaces/view_interface.hpp>
 
 #include <algorithm>
+#include <bit>
 #include <iterator>
+#include <memory_resource>
+#include <string>
 
 #if defined(_MSC_VER)
 #include <cctype>
@@ -331,6 +335,231 @@ namespace boost { namespace program_options_2 {
             std::string current_;
             iterator first_;
         };
+
+        inline bool response_file_space(char c)
+        {
+            return c == ' ' || ('\t' <= c && c <= '\r');
+        }
+
+        // Tokenizes a response file that is already in memory, following
+        // the same rules as response_file_arg_iter.  Each token is a view of
+        // the buffer, except for a quoted token that contains an escaped
+        // quote or backslash; only such a token is copied, unescaped, into
+        // *current.
+        //
+        // Bytes are classified a block at a time (see special_bytes()), and
+        // the runs of ordinary bytes between the special ones are skipped
+        // (or copied) in bulk.
+        struct response_file_buffer_iter
+            : stl_interfaces::proxy_iterator_interface<
+                  response_file_buffer_iter,
+                  std::input_iterator_tag,
+                  std::string_view>
+        {
+            response_file_buffer_iter() = default;
+
+            response_file_buffer_iter(
+                std::string_view buffer, std::pmr::string & current) :
+                it_(buffer.data()),
+                last_(buffer.data() + buffer.size()),
+                block_(it_),
+                block_last_(it_),
+                current_(&current)
+            {
+                operator++();
+            }
+
+            std::string_view operator*() const { return value_; }
+
+            // True iff the current token was unescaped into *current,
+            // rather than being a view of the buffer.
+            bool copied() const { return copied_; }
+
+            // Uses current, which must have the same contents as *current,
+            // in place of *current from now on.  This lets an iterator that
+            // owns its current string be copied.
+            void rebind(std::pmr::string & current)
+            {
+                if (copied_) {
+                    value_ = std::string_view(
+                        current.data() + (value_.data() - current_->data()),
+                        value_.size());
+                }
+                current_ = &current;
+            }
+
+            response_file_buffer_iter & operator++()
+            {
+                skip();
+                if (it_ == last_) {
+                    just_before_end_ = false;
+                    copied_ = false;
+                    value_ = std::string_view();
+                    return *this;
+                }
+
+                char const * const first = it_;
+                char const * token_last = nullptr;
+                bool in_quotes = false;
+                bool copied = false;
+
+                while (it_ != last_) {
+                    char const * const special = next_special(it_);
+                    if (copied)
+                        current_->append(it_, special);
+                    it_ = special;
+                    if (it_ == last_)
+                        break;
+
+                    char const c = *it_;
+                    if (c == '"') { // unescaped quote
+                        ++it_;
+                        if (copied)
+                            *current_ += c;
+                        in_quotes = !in_quotes;
+                        if (!in_quotes)
+                            break;
+                    } else if (in_quotes && c == '\\') {
+                        ++it_;
+                        if (it_ == last_) {
+                            if (copied)
+                                *current_ += c;
+                        } else {
+                            char const next_c = *it_;
+                            if (next_c == '\\' || next_c == '"') {
+                                if (!copied) {
+                                    current_->assign(first, it_ - 1);
+                                    copied = true;
+                                }
+                            } else if (copied) {
+                                *current_ += c;
+                            }
+                            if (copied)
+                                *current_ += next_c;
+                            ++it_;
+                        }
+                    } else if (!in_quotes && c != '\\') { // whitespace or '#'
+                        token_last = it_++;
+                        break;
+                    } else {
+                        if (copied)
+                            *current_ += c;
+                        ++it_;
+                    }
+                }
+
+                copied_ = copied;
+                if (copied) {
+                    value_ = *current_;
+                } else {
+                    if (!token_last)
+                        token_last = it_;
+                    value_ = std::string_view(first, token_last - first);
+                }
+                if (2u <= value_.size() && value_.front() == '"' &&
+                    value_.back() == '"') {
+                    value_ = value_.substr(1, value_.size() - 2);
+                }
+
+                skip();
+                if (it_ == last_)
+                    just_before_end_ = true;
+                return *this;
+            }
+
+            friend bool operator==(
+                response_file_buffer_iter lhs,
+                response_file_buffer_iter rhs) noexcept
+            {
+                if (lhs.at_end() || rhs.at_end())
+                    return lhs.at_end() == rhs.at_end();
+                return lhs.it_ == rhs.it_ &&
+                       lhs.just_before_end_ == rhs.just_before_end_;
+            }
+
+            using base_type = stl_interfaces::proxy_iterator_interface<
+                response_file_buffer_iter,
+                std::input_iterator_tag,
+                std::string_view>;
+            using base_type::operator++;
+
+        private:
+            bool at_end() const { return it_ == last_ && !just_before_end_; }
+
+            // Returns the first special byte in [p, last_), or last_.  p must
+            // not precede any position previously passed.
+            char const * next_special(char const * p)
+            {
+                for (;;) {
+                    if (block_last_ <= p) {
+                        if (p == last_)
+                            return last_;
+                        auto const n = (std::min)(
+                            last_ - p, detail::special_bytes_block_size);
+                        block_ = p;
+                        block_last_ = p + n;
+                        mask_ = detail::special_bytes(p, n);
+                    }
+                    auto const mask = mask_ >> (p - block_);
+                    if (mask)
+                        return p + std::countr_zero(mask);
+                    p = block_last_;
+                }
+            }
+
+            void skip()
+            {
+                while (it_ != last_) {
+                    char const c = *it_;
+                    if (response_file_space(c)) {
+                        ++it_;
+                    } else if (c == '#') {
+                        // Skip to the end of the line.
+                        ++it_;
+                        while ((it_ = next_special(it_)) != last_ &&
+                               (*it_ < 0xa || 0xd < *it_)) {
+                            ++it_;
+                        }
+                        if (it_ != last_ && *it_ == 0xa)
+                            ++it_;
+                    } else {
+                        break;
+                    }
+                }
+            }
+
+            char const * it_ = nullptr;
+            char const * last_ = nullptr;
+            // The block of bytes that mask_ describes.
+            char const * block_ = nullptr;
+            char const * block_last_ = nullptr;
+            std::uint64_t mask_ = 0;
+            std::pmr::string * current_ = nullptr;
+            std::string_view value_;
+            bool copied_ = false;
+            bool just_before_end_ = false;
+        };
+
+        // A view of the tokens in a response file that is already in memory,
+        // as from a mapped_file.  The buffer must outlive the view, and
+        // every token obtained from it.
+        struct response_file_buffer_arg_view
+            : stl_interfaces::view_interface<response_file_buffer_arg_view>
+        {
+            using iterator = response_file_buffer_iter;
+
+            response_file_buffer_arg_view() = default;
+            explicit response_file_buffer_arg_view(std::string_view buffer) :
+                current_(), first_(buffer, current_)
+            {}
+
+            iterator begin() const { return first_; }
+            iterator end() const { return {}; }
+
+        private:
+            std::pmr::string current_;
+            iterator first_;
+        };
     }
 
 }}
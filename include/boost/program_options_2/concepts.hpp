@@ -74,6 +74,17 @@ namespace boost { namespace program_options_2 {
          erased_type<map_value_t<T>> &&
          requires(T t) { t.erase(t.begin()); };
 
+    template<typename T>
+    concept heterogeneous_options_map = options_map<T> &&
+        std::same_as<map_key_t<T>, std::string> &&
+        requires(T t, std::string_view const & s) {
+            { t.find(s) } -> std::same_as<std::ranges::iterator_t<T>>;
+        };
+
+    template<typename T>
+    concept options_storage =
+        options_map<T> || detail::is_typed_options<T>::value;
+
     // clang-format on
 
 }}
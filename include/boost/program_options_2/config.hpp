@@ -17,6 +17,16 @@
     instead. */
 #    define BOOST_PROGRAM_OPTIONS_2_DISABLE_STD_FILESYSTEM
 
+/** On POSIX systems, Boost.ProgramOptions2 memory-maps response files to
+    read them.  If you want to disable this, define this macro, and response
+    files will be read into memory instead. */
+#    define BOOST_PROGRAM_OPTIONS_2_DISABLE_MMAP
+
+/** On Linux, `watched_options` uses inotify to learn when the file it
+    watches may have changed.  If you want to disable this, define this
+    macro, and the file's status will be polled instead. */
+#    define BOOST_PROGRAM_OPTIONS_2_DISABLE_INOTIFY
+
 #endif
 
 #if defined(__cpp_lib_filesystem) &&                                           \
@@ -26,4 +36,42 @@
 #define BOOST_PROGRAM_OPTIONS_2_USE_STD_FILESYSTEM 0
 #endif
 
+#if !defined(_WIN32) && defined(__has_include)
+#if __has_include(<sys/stat.h>) && __has_include(<unistd.h>)
+#define BOOST_PROGRAM_OPTIONS_2_USE_POSIX 1
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_POSIX 0
+#endif
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_POSIX 0
+#endif
+
+#if !defined(_WIN32) && defined(__has_include) &&                              \
+    !defined(BOOST_PROGRAM_OPTIONS_2_DISABLE_MMAP)
+#if __has_include(<sys/mman.h>)
+#define BOOST_PROGRAM_OPTIONS_2_USE_MMAP 1
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_MMAP 0
+#endif
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_MMAP 0
+#endif
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX && __has_include(<sys/mman.h>)
+#define BOOST_PROGRAM_OPTIONS_2_USE_SHARED_MEMORY 1
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_SHARED_MEMORY 0
+#endif
+
+#if defined(__linux__) && defined(__has_include) &&                            \
+    !defined(BOOST_PROGRAM_OPTIONS_2_DISABLE_INOTIFY)
+#if __has_include(<sys/inotify.h>)
+#define BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY 1
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY 0
+#endif
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY 0
+#endif
+
 #endif
@@ -30,7 +30,8 @@ namespace boost { namespace program_options_2 {
              std::equality_comparable_with<DefaultType, ChoiceType>) &&
              ((std::assignable_from<T &, DefaultType>  &&
                std::constructible_from<T, DefaultType>)||
-              detail::insertable_from<T, DefaultType>)
+              detail::insertable_from<T, DefaultType>) &&
+             (!detail::is_value_sink<T>::value)
     detail::option<Kind, T, DefaultType, Required, Choices, ChoiceType, Validator>
     with_default(
         detail::option<
@@ -61,7 +62,8 @@ namespace boost { namespace program_options_2 {
             (DefaultType &&) default_value,
             opt.choices,
             opt.arg_display_name,
-            std::move(opt.validator)};
+            std::move(opt.validator),
+            opt.separator};
     }
 
     /** Takes `opt` and returns a new option that will show up as `name` in
@@ -91,6 +93,105 @@ namespace boost { namespace program_options_2 {
         return opt;
     }
 
+    /** Takes `opt` and returns a new option, each of whose arguments is a
+        list of values delimited by `separator`, like "1,2,3" for a
+        `separator` of ",".  Each value is inserted separately into the
+        option's result, so `opt` must have an insertable result type (like
+        `std::vector<int>`).  Any choices or validator apply to each value
+        individually.  `separator` must be nonempty, and must consist only of
+        ASCII characters. */
+    template<
+        detail::option_kind Kind,
+        typename T,
+        typename Value,
+        detail::required_t Required,
+        int Choices,
+        typename ChoiceType,
+        typename Validator>
+    requires(insertable<T> && !std::same_as<T, std::string>)
+    auto with_separator(
+        detail::option<Kind, T, Value, Required, Choices, ChoiceType, Validator>
+            opt,
+        std::string_view separator)
+    {
+        BOOST_ASSERT(
+            opt.args != 0 &&
+            "A separator for a flag or other option with no arguments will "
+            "never be used.");
+        BOOST_ASSERT(
+            !separator.empty() && detail::ascii(separator) &&
+            "The separator must be a nonempty sequence of ASCII characters.");
+        opt.separator = separator;
+        return opt;
+    }
+
+    /** Takes `opt` and returns an option whose values are passed to `sink`
+        one at a time, as they are parsed, instead of being collected into
+        the option's result.  `sink` must be invocable with a single value,
+        or must be an output iterator for values.  `opt` must have an
+        insertable result type (like `std::vector<std::string_view>`), whose
+        element type is the type of the values passed to `sink`.  This is
+        mostly useful with `remainder()` and with positionals that take
+        `zero_or_more` or `one_or_more` args, when there may be too many
+        values to keep in memory at once.
+
+        The result of the returned option is `no_value`, and nothing is
+        stored for it in an options map.  Any choices, separator, or
+        validator of `opt` apply to each value before it is passed to
+        `sink`.  Note that `sink` is copied along with the option, so it
+        should refer to, rather than contain, any state that is needed after
+        parsing.  Values that are `std::string_view`s are only valid for the
+        duration of the call that passes them to `sink`. */
+    template<
+        detail::option_kind Kind,
+        typename T,
+        detail::required_t Required,
+        int Choices,
+        typename ChoiceType,
+        typename Validator,
+        typename Sink>
+        // clang-format off
+        requires insertable<T> && (!std::same_as<T, std::string>) &&
+            (std::invocable<Sink &, std::ranges::range_value_t<T>> ||
+             std::output_iterator<Sink, std::ranges::range_value_t<T>>)
+    auto with_sink(
+        detail::option<
+            Kind,
+            T,
+            no_value,
+            Required,
+            Choices,
+            ChoiceType,
+            Validator> opt,
+        Sink sink)
+    // clang-format on
+    {
+        BOOST_ASSERT(
+            opt.args != 0 &&
+            "A sink for a flag or other option with no arguments will never "
+            "be used.");
+        using sink_type =
+            detail::value_sink<std::ranges::range_value_t<T>, Sink>;
+        return detail::option<
+            Kind,
+            sink_type,
+            no_value,
+            Required,
+            Choices,
+            ChoiceType,
+            Validator>{
+            opt.names,
+            opt.help_text,
+            opt.action,
+            opt.args,
+            no_value{},
+            opt.choices,
+            opt.arg_display_name,
+            std::move(opt.validator),
+            opt.separator,
+            sink_type{std::move(sink)}};
+    }
+
     /** Takes `opt` and returns an option that will use `validator` to
         validate its arguments during parsing. */
     template<
@@ -0,0 +1,155 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_ATOMIC_FILE_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_ATOMIC_FILE_HPP
+
+#include <boost/program_options_2/config.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // Returns a name for a temporary file next to filename, that is unique
+    // within this process.
+    inline std::string temporary_file_name(std::string_view filename)
+    {
+        static std::atomic<unsigned long> count = 0;
+        std::string retval(filename);
+        retval += ".tmp.";
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+        retval += std::to_string(::getpid());
+        retval += '.';
+#endif
+        retval += std::to_string(count++);
+        return retval;
+    }
+
+    // Writes contents to a temporary file next to filename, and then
+    // renames it to filename.  Readers of filename therefore see either its
+    // old contents or all of contents, and a failure part way through leaves
+    // filename untouched.  Returns false on failure.  Note that this does
+    // not flush the file to disk; it protects against the writer failing,
+    // not against the machine doing so.
+    //
+    // If filename is a symlink, the file it refers to is replaced, and the
+    // link is kept.  If the file already exists, the new one gets its
+    // permissions, and, where the writer is allowed to set them, its owner
+    // and group.
+    inline bool
+    write_file_atomically(std::string_view filename, std::string_view contents)
+    {
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+        std::string target(filename);
+        if (char * const resolved = ::realpath(target.c_str(), nullptr)) {
+            target = resolved;
+            std::free(resolved);
+        }
+
+        std::string tmp;
+        int fd = -1;
+        // Another process with our PID may have left a file behind.
+        for (int i = 0; fd < 0 && i < 16; ++i) {
+            tmp = detail::temporary_file_name(target);
+            fd = ::open(
+                tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            if (fd < 0 && errno != EEXIST)
+                return false;
+        }
+        if (fd < 0)
+            return false;
+
+        // Match the existing file before writing anything, so that the
+        // contents are never readable by anyone who could not read them
+        // before.  The owner is set first, since changing it may clear the
+        // set-user-ID and set-group-ID bits.  Only the owner may be left as
+        // it was, when the writer does not have permission to change it.
+        struct stat st;
+        if (::stat(target.c_str(), &st) == 0) {
+            [[maybe_unused]] int const chowned =
+                ::fchown(fd, st.st_uid, st.st_gid);
+            if (::fchmod(fd, st.st_mode & 07777) != 0) {
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                return false;
+            }
+        }
+
+        bool written = true;
+        char const * first = contents.data();
+        char const * const last = first + contents.size();
+        while (first != last) {
+            auto const n = ::write(fd, first, last - first);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                written = false;
+                break;
+            }
+            first += n;
+        }
+        written = ::close(fd) == 0 && written;
+        if (written && ::rename(tmp.c_str(), target.c_str()) == 0)
+            return true;
+        ::unlink(tmp.c_str());
+        return false;
+#else
+#if BOOST_PROGRAM_OPTIONS_2_USE_STD_FILESYSTEM
+        namespace fs = std::filesystem;
+#else
+        namespace fs = filesystem;
+#endif
+        detail::error_code ec;
+        fs::path target(std::string(filename));
+        auto const resolved = fs::canonical(target, ec);
+        if (!ec)
+            target = resolved;
+        auto const existing = fs::status(target, ec);
+
+        std::string const tmp = detail::temporary_file_name(target.string());
+        {
+            std::ofstream ofs(tmp.c_str(), std::ios_base::binary);
+            if (!ofs)
+                return false;
+            ofs.write(contents.data(), contents.size());
+            ofs.close();
+            if (!ofs) {
+                fs::remove(fs::path(tmp), ec);
+                return false;
+            }
+        }
+        if (fs::exists(existing)) {
+            fs::permissions(fs::path(tmp), existing.permissions(), ec);
+            if (ec) {
+                fs::remove(fs::path(tmp), ec);
+                return false;
+            }
+        }
+        fs::rename(fs::path(tmp), target, ec);
+        if (!ec)
+            return true;
+        fs::remove(fs::path(tmp), ec);
+        return false;
+#endif
+    }
+
+}}}
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_BINARY_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_BINARY_HPP
+
+#include <boost/program_options_2/concepts.hpp>
+#include <boost/program_options_2/detail/parsing.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // The layout of a file written by save_binary_file() is:
+    //
+    //   "PO2B"
+    //   format version           std::uint32_t
+    //   schema fingerprint       std::uint64_t
+    //   for each stored option, in order:
+    //     value length           std::uint64_t (binary_no_value if none)
+    //     value                  (length bytes)
+    //
+    // Every number is in the native byte order, which is part of the
+    // fingerprint.  Within a value, strings and containers are a
+    // std::uint64_t count followed by their elements, an optional is a
+    // one-byte engaged flag followed by its value (if any), and anything
+    // else is its object representation.
+    constexpr std::string_view binary_magic = "PO2B";
+    constexpr std::uint32_t binary_format_version = 1;
+    constexpr std::uint64_t binary_no_value = UINT64_MAX;
+
+    template<typename T>
+    constexpr bool binary_encodable()
+    {
+        if constexpr (is_string<T>::value) {
+            return std::is_trivially_copyable_v<typename T::value_type>;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return true;
+        } else if constexpr (is_optional<T>::value) {
+            return detail::binary_encodable<typename T::value_type>();
+        } else if constexpr (insertable<T>) {
+            return std::default_initializable<T> &&
+                   detail::binary_encodable<std::ranges::range_value_t<T>>();
+        } else {
+            return std::is_trivially_copyable_v<T> &&
+                   std::default_initializable<T> && !std::is_pointer_v<T>;
+        }
+    }
+
+    // True if a T is encoded as its object representation.
+    template<typename T>
+    constexpr bool binary_raw()
+    {
+        return !is_string<T>::value && !std::is_same_v<T, std::string_view> &&
+               !is_optional<T>::value && !insertable<T> &&
+               !std::is_same_v<T, bool>;
+    }
+
+    // True if the elements of a T can all be copied at once.
+    template<typename T>
+    constexpr bool binary_contiguous_raw()
+    {
+        if constexpr (std::ranges::contiguous_range<T>) {
+            return detail::binary_raw<std::ranges::range_value_t<T>>() &&
+                   requires(T & t) { t.resize(0); };
+        } else {
+            return false;
+        }
+    }
+
+    // The smallest number of bytes in which a T can be encoded.
+    template<typename T>
+    constexpr std::size_t binary_min_size()
+    {
+        if constexpr (
+            is_string<T>::value || std::is_same_v<T, std::string_view> ||
+            (insertable<T> && !is_optional<T>::value)) {
+            return sizeof(std::uint64_t);
+        } else if constexpr (is_optional<T>::value) {
+            return 1;
+        } else {
+            return sizeof(T);
+        }
+    }
+
+    // An FNV-1a hash of everything that determines the layout of the values
+    // written by save_binary_file().
+    struct binary_fingerprint
+    {
+        void add_bytes(void const * p, std::size_t n)
+        {
+            auto const bytes = (unsigned char const *)p;
+            for (std::size_t i = 0; i < n; ++i) {
+                value = (value ^ bytes[i]) * 0x100000001b3ull;
+            }
+        }
+        template<typename T>
+        requires std::is_integral_v<T>
+        void add(T x) { add_bytes(&x, sizeof(x)); }
+        void add(std::string_view sv)
+        {
+            add(std::uint64_t(sv.size()));
+            add_bytes(sv.data(), sv.size());
+        }
+
+        std::uint64_t value = 0xcbf29ce484222325ull;
+    };
+
+    // Adds a description of how a T is encoded to fp.  Types that are
+    // encoded the same way get the same description, so that, for
+    // instance, a std::vector<int> can be loaded as a std::set<int>.
+    template<typename T>
+    void add_binary_type(binary_fingerprint & fp)
+    {
+        if constexpr (is_string<T>::value) {
+            fp.add('s');
+            fp.add(sizeof(typename T::value_type));
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            fp.add('v');
+        } else if constexpr (is_optional<T>::value) {
+            fp.add('o');
+            detail::add_binary_type<typename T::value_type>(fp);
+        } else if constexpr (insertable<T>) {
+            fp.add('c');
+            detail::add_binary_type<std::ranges::range_value_t<T>>(fp);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            fp.add('b');
+        } else if constexpr (std::is_floating_point_v<T>) {
+            fp.add('f');
+            fp.add(sizeof(T));
+        } else if constexpr (std::is_integral_v<T>) {
+            fp.add(std::is_signed_v<T> ? 'i' : 'u');
+            fp.add(sizeof(T));
+        } else {
+            fp.add('t');
+            fp.add(sizeof(T));
+            fp.add(alignof(T));
+        }
+    }
+
+    template<typename T>
+    void binary_append(std::string & out, T const & x)
+    {
+        if constexpr (
+            is_string<T>::value || std::is_same_v<T, std::string_view>) {
+            detail::binary_append(out, std::uint64_t(x.size()));
+            out.append((char const *)x.data(), x.size() * sizeof(x[0]));
+        } else if constexpr (is_optional<T>::value) {
+            detail::binary_append(out, (unsigned char)(bool)x);
+            if (x)
+                detail::binary_append(out, *x);
+        } else if constexpr (binary_contiguous_raw<T>()) {
+            detail::binary_append(out, std::uint64_t(std::ranges::size(x)));
+            out.append(
+                (char const *)std::ranges::data(x),
+                std::ranges::size(x) * sizeof(*std::ranges::data(x)));
+        } else if constexpr (insertable<T>) {
+            detail::binary_append(
+                out, std::uint64_t(std::ranges::distance(x)));
+            for (auto const & element : x) {
+                detail::binary_append(out, element);
+            }
+        } else {
+            out.append((char const *)&x, sizeof(x));
+        }
+    }
+
+    // Decodes values written by binary_append(), checking each read against
+    // the end of the input.  A std::string_view refers into the input.
+    struct binary_reader
+    {
+        std::size_t remaining() const { return last - it; }
+
+        template<typename T>
+        bool read(T & x)
+        {
+            if constexpr (
+                is_string<T>::value || std::is_same_v<T, std::string_view>) {
+                using char_type = std::remove_cv_t<
+                    std::remove_reference_t<decltype(x[0])>>;
+                std::uint64_t n = 0;
+                if (!read(n) || remaining() / sizeof(char_type) < n)
+                    return false;
+                if constexpr (std::is_same_v<T, std::string_view>) {
+                    x = std::string_view(it, n);
+                } else {
+                    x.resize(n);
+                    std::memcpy(x.data(), it, n * sizeof(char_type));
+                }
+                it += n * sizeof(char_type);
+                return true;
+            } else if constexpr (is_optional<T>::value) {
+                bool engaged = false;
+                if (!read(engaged))
+                    return false;
+                if (!engaged)
+                    return true;
+                x.emplace();
+                return read(*x);
+            } else if constexpr (binary_contiguous_raw<T>()) {
+                using value_type = std::ranges::range_value_t<T>;
+                std::uint64_t n = 0;
+                if (!read(n) || remaining() / sizeof(value_type) < n)
+                    return false;
+                x.resize(n);
+                std::memcpy(
+                    (void *)std::ranges::data(x), it, n * sizeof(value_type));
+                it += n * sizeof(value_type);
+                return true;
+            } else if constexpr (insertable<T>) {
+                using value_type = std::ranges::range_value_t<T>;
+                std::uint64_t n = 0;
+                if (!read(n) ||
+                    remaining() / detail::binary_min_size<value_type>() < n) {
+                    return false;
+                }
+                if constexpr (requires { x.reserve(n); })
+                    x.reserve(n);
+                for (std::uint64_t i = 0; i < n; ++i) {
+                    value_type element{};
+                    if (!read(element))
+                        return false;
+                    x.insert(x.end(), std::move(element));
+                }
+                return true;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                unsigned char c = 0;
+                if (!read(c) || 1 < c)
+                    return false;
+                x = c;
+                return true;
+            } else {
+                if (remaining() < sizeof(T))
+                    return false;
+                std::memcpy((void *)&x, it, sizeof(T));
+                it += sizeof(T);
+                return true;
+            }
+        }
+
+        char const * it;
+        char const * last;
+    };
+
+}}}
+
+#endif
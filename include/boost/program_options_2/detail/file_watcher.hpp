@@ -0,0 +1,239 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_FILE_WATCHER_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_FILE_WATCHER_HPP
+
+#include <boost/program_options_2/config.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+#include <sys/stat.h>
+#endif
+#if BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // Enough of the status of a file to tell that it has been changed or
+    // replaced.
+    struct file_status
+    {
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+        bool exists = false;
+
+        bool operator==(file_status const &) const = default;
+    };
+
+    inline file_status get_file_status(std::string const & path)
+    {
+        file_status retval;
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0)
+            return retval;
+        retval.device = st.st_dev;
+        retval.inode = st.st_ino;
+        retval.size = st.st_size;
+#if defined(__APPLE__)
+        retval.mtime = st.st_mtimespec.tv_sec * 1000000000ll +
+                       st.st_mtimespec.tv_nsec;
+#else
+        retval.mtime = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+#endif
+#else
+#if BOOST_PROGRAM_OPTIONS_2_USE_STD_FILESYSTEM
+        namespace fs = std::filesystem;
+#else
+        namespace fs = filesystem;
+#endif
+        detail::error_code ec;
+        fs::path const p(path);
+        auto const size = fs::file_size(p, ec);
+        if (ec)
+            return retval;
+        auto const mtime = fs::last_write_time(p, ec);
+        if (ec)
+            return retval;
+        retval.size = size;
+        retval.mtime = mtime.time_since_epoch().count();
+#endif
+        retval.exists = true;
+        return retval;
+    }
+
+    // Calls on_change(), on a thread of its own, whenever the file at path
+    // may have changed, until destroyed.  With inotify, this watches the
+    // directory containing path, so that replacing the file (as by an
+    // atomic rename) is noticed too.  Without it, or if inotify cannot be
+    // used, the status of the file is checked every poll_interval.
+    struct file_watcher
+    {
+        file_watcher(
+            std::string path,
+            std::chrono::milliseconds poll_interval,
+            std::function<void()> on_change) :
+            path_(std::move(path)),
+            poll_interval_(poll_interval),
+            on_change_(std::move(on_change)),
+            status_(detail::get_file_status(path_))
+        {
+            thread_ = std::jthread([this](std::stop_token stop) {
+#if BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY
+                if (watch_with_inotify(stop))
+                    return;
+#endif
+                poll(stop);
+            });
+        }
+
+        ~file_watcher()
+        {
+            thread_.request_stop();
+            cv_.notify_all();
+            // Joins thread_ before the members it uses are destroyed.
+            thread_ = std::jthread();
+        }
+
+        file_watcher(file_watcher const &) = delete;
+        file_watcher & operator=(file_watcher const &) = delete;
+
+    private:
+        // Calls on_change_() if the file's status differs from the last
+        // one seen, or if force is true.
+        void check(bool force)
+        {
+            auto const status = detail::get_file_status(path_);
+            if (!force && status == status_)
+                return;
+            status_ = status;
+            on_change_();
+        }
+
+        void poll(std::stop_token stop)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop.stop_requested()) {
+                cv_.wait_for(lock, stop, poll_interval_, [] { return false; });
+                if (stop.stop_requested())
+                    break;
+                check(false);
+            }
+        }
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_INOTIFY
+        // Returns false if inotify could not be used.
+        bool watch_with_inotify(std::stop_token stop)
+        {
+            auto const slash = path_.rfind('/');
+            std::string const dir =
+                slash == std::string::npos
+                    ? std::string(".")
+                    : (slash == 0 ? std::string("/") : path_.substr(0, slash));
+            std::string const name =
+                slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+            int const fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fd < 0)
+                return false;
+            int const wd = ::inotify_add_watch(
+                fd,
+                dir.c_str(),
+                IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE |
+                    IN_ATTRIB);
+            if (wd < 0) {
+                ::close(fd);
+                return false;
+            }
+
+            // Catches any change made before the watch was added.
+            check(false);
+
+            // Wakes the poll() below when a stop is requested.  The callback
+            // is destroyed (which waits for it to finish, if it is running)
+            // before the pipe is closed.
+            int stop_pipe[2];
+            if (::pipe2(stop_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+                ::close(fd);
+                return false;
+            }
+            {
+                std::stop_callback wake(stop, [&] {
+                    char const c = 0;
+                    [[maybe_unused]] auto const n =
+                        ::write(stop_pipe[1], &c, 1);
+                });
+
+                alignas(inotify_event) char buf[4096];
+                while (!stop.stop_requested()) {
+                    pollfd fds[2] = {
+                        {fd, POLLIN, 0}, {stop_pipe[0], POLLIN, 0}};
+                    if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+                        break;
+                    if (stop.stop_requested())
+                        break;
+                    // An event for the file itself forces a reload, even if
+                    // its status looks the same, since a rewrite within the
+                    // mtime granularity would otherwise go unnoticed.  Any
+                    // other event in the directory (like replacing a symlink
+                    // that leads to the file) is checked against the file's
+                    // status.
+                    bool any_event = false;
+                    bool file_event = false;
+                    for (;;) {
+                        auto const n = ::read(fd, buf, sizeof(buf));
+                        if (n <= 0)
+                            break;
+                        for (char * p = buf; p < buf + n;) {
+                            auto const event = (inotify_event const *)p;
+                            any_event = true;
+                            if (event->len && name == event->name)
+                                file_event = true;
+                            p += sizeof(inotify_event) + event->len;
+                        }
+                    }
+                    if (any_event)
+                        check(file_event);
+                }
+            }
+
+            ::close(stop_pipe[0]);
+            ::close(stop_pipe[1]);
+            ::close(fd);
+            return true;
+        }
+#endif
+
+        std::string path_;
+        std::chrono::milliseconds poll_interval_;
+        std::function<void()> on_change_;
+        file_status status_;
+        std::mutex mutex_;
+        std::condition_variable_any cv_;
+        std::jthread thread_;
+    };
+
+}}}
+
+#endif
@@ -0,0 +1,396 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_JSON_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_JSON_HPP
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    enum struct json_scalar { string, number, boolean, null };
+
+    // Returns the character that "\\c" stands for in a JSON string, or 0
+    // if it is not a valid escape (or is a "\\u" escape).
+    inline char json_unescaped(char c)
+    {
+        switch (c) {
+        case '"': return '"';
+        case '\\': return '\\';
+        case '/': return '/';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        default: return 0;
+        }
+    }
+
+    // Appends s to out as a quoted JSON string.  Bytes outside of ASCII are
+    // copied as-is, so UTF-8 stays UTF-8.
+    inline void json_append_string(std::string & out, std::string_view s)
+    {
+        out += '"';
+        char const * first = s.data();
+        char const * const last = first + s.size();
+        for (char const * it = first; it != last; ++it) {
+            unsigned char const c = *it;
+            if (c != '"' && c != '\\' && 0x20 <= c)
+                continue;
+            out.append(first, it);
+            first = it + 1;
+            out += '\\';
+            switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '\b': out += 'b'; break;
+            case '\f': out += 'f'; break;
+            case '\n': out += 'n'; break;
+            case '\r': out += 'r'; break;
+            case '\t': out += 't'; break;
+            default:
+                out += "u00";
+                out += "0123456789abcdef"[c >> 4];
+                out += "0123456789abcdef"[c & 0xf];
+                break;
+            }
+        }
+        out.append(first, last);
+        out += '"';
+    }
+
+    // Appends x to out as a JSON number, or as true or false for a bool.
+    // Floating point values are written in their shortest round-tripping
+    // form.  Infinities and NaNs, which JSON has no numbers for, are written
+    // as strings that json_reader's users can still convert back.
+    template<typename T>
+    void json_append_number(std::string & out, T x)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += x ? "true" : "false";
+        } else {
+            char buf[64];
+            auto const result = std::to_chars(buf, buf + sizeof(buf), x);
+            std::string_view const sv(buf, result.ptr - buf);
+            if constexpr (std::is_floating_point_v<T>) {
+                if (!std::isfinite(x)) {
+                    detail::json_append_string(out, sv);
+                    return;
+                }
+            }
+            out += sv;
+        }
+    }
+
+    // A single-pass reader for the JSON read by load_json_file().  The top
+    // level must be an object.  For each of its members, the reader calls
+    // handler.key(k), then handler.scalar(text, kind) for each scalar
+    // within the member's value, in order (arrays are flattened), and then
+    // handler.value_end().  The text of a string is unescaped; the text of
+    // any other scalar is exactly as it appears in the input.  Each handler
+    // function returns false to stop reading.  Objects within values are
+    // passed to handler.nested_object(), which is expected to return false.
+    // As an extension, '#' starts a comment that runs to the end of the
+    // line.
+    template<typename Handler>
+    struct json_reader
+    {
+        static constexpr int max_nesting = 512;
+
+        json_reader(std::string_view contents, Handler & handler) :
+            it_(contents.data()),
+            last_(contents.data() + contents.size()),
+            handler_(handler)
+        {}
+
+        // Returns true if the whole input was read.  If reading stopped
+        // because of malformed input, error() is nonempty, and position()
+        // is where the problem was found.  Otherwise, the handler stopped
+        // it.
+        bool read()
+        {
+            skip();
+            if (!eat('{'))
+                return expected("'{'");
+            skip();
+            if (!eat('}')) {
+                bool first_member = true;
+                do {
+                    skip();
+                    if (it_ == last_ || *it_ != '"')
+                        return expected(first_member ? "'}'" : "string");
+                    first_member = false;
+                    std::string_view key;
+                    if (!string(key))
+                        return false;
+                    if (!handler_.key(key))
+                        return false;
+                    skip();
+                    if (!eat(':'))
+                        return expected("':'");
+                    if (!value(1) || !handler_.value_end())
+                        return false;
+                    skip();
+                } while (eat(','));
+                if (!eat('}'))
+                    return expected("'}'");
+            }
+            skip();
+            if (it_ != last_)
+                return expected("end of input");
+            return true;
+        }
+
+        std::string const & error() const { return error_; }
+        char const * position() const { return it_; }
+
+    private:
+        static constexpr std::string_view escape_sequence =
+            "\\uXXXX hexidecimal escape sequence";
+
+        bool value(int depth)
+        {
+            skip();
+            if (it_ == last_)
+                return expected("value");
+            char const c = *it_;
+            if (c == '"') {
+                std::string_view s;
+                return string(s) && handler_.scalar(s, json_scalar::string);
+            } else if (c == '[') {
+                if (max_nesting < depth)
+                    return too_deep();
+                ++it_;
+                skip();
+                if (eat(']'))
+                    return true;
+                do {
+                    if (!value(depth + 1))
+                        return false;
+                    skip();
+                } while (eat(','));
+                if (!eat(']'))
+                    return expected("']'");
+                return true;
+            } else if (c == '{') {
+                if (max_nesting < depth)
+                    return too_deep();
+                return handler_.nested_object();
+            } else if (c == '-' || ('0' <= c && c <= '9')) {
+                return number();
+            } else if (literal("true")) {
+                return handler_.scalar("true", json_scalar::boolean);
+            } else if (literal("false")) {
+                return handler_.scalar("false", json_scalar::boolean);
+            } else if (literal("null")) {
+                return handler_.scalar("null", json_scalar::null);
+            }
+            return expected("value");
+        }
+
+        bool number()
+        {
+            char const * const start = it_;
+            eat('-');
+            if (!eat('0')) {
+                if (!digits())
+                    return expected("number");
+            }
+            if (eat('.') && !digits())
+                return expected("digit");
+            if (it_ != last_ && (*it_ == 'e' || *it_ == 'E')) {
+                ++it_;
+                if (!eat('+'))
+                    eat('-');
+                if (!digits())
+                    return expected("digit");
+            }
+            return handler_.scalar(
+                std::string_view(start, it_ - start), json_scalar::number);
+        }
+
+        bool digits()
+        {
+            char const * const start = it_;
+            while (it_ != last_ && '0' <= *it_ && *it_ <= '9') {
+                ++it_;
+            }
+            return it_ != start;
+        }
+
+        // Reads a string starting at the opening quote.  The result refers
+        // directly into the input when there are no escapes, and into
+        // scratch_ otherwise.
+        bool string(std::string_view & result)
+        {
+            ++it_;
+            char const * const start = it_;
+            while (it_ != last_ && *it_ != '"' && *it_ != '\\' &&
+                   0x20 <= (unsigned char)*it_) {
+                ++it_;
+            }
+            if (it_ != last_ && *it_ == '"') {
+                result = std::string_view(start, it_ - start);
+                ++it_;
+                return true;
+            }
+            scratch_.assign(start, it_);
+            while (it_ != last_ && *it_ != '"') {
+                char const c = *it_;
+                if ((unsigned char)c < 0x20) {
+                    return expected(
+                        "code point (code points <= U+001F must be escaped)");
+                }
+                ++it_;
+                if (c != '\\') {
+                    scratch_ += c;
+                    continue;
+                }
+                if (it_ == last_)
+                    break;
+                if (*it_ != 'u') {
+                    char const unescaped = detail::json_unescaped(*it_);
+                    if (!unescaped) {
+                        return expected(
+                            "'\"', '\\', '/', 'b', 'f', 'n', 'r', or 't'");
+                    }
+                    scratch_ += unescaped;
+                    ++it_;
+                    continue;
+                }
+                ++it_;
+                std::uint32_t cp = 0;
+                if (!hex_4(cp))
+                    return false;
+                if (0xd800 <= cp && cp <= 0xdbff) {
+                    // A UTF-16 surrogate pair.
+                    std::uint32_t low = 0;
+                    if (!eat('\\') || !eat('u'))
+                        return expected(escape_sequence);
+                    if (!hex_4(low))
+                        return false;
+                    if (low < 0xdc00 || 0xdfff < low)
+                        return expected(escape_sequence);
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                } else if (0xdc00 <= cp && cp <= 0xdfff) {
+                    return expected(escape_sequence);
+                }
+                append_utf8(cp);
+            }
+            if (!eat('"'))
+                return expected("'\"'");
+            result = scratch_;
+            return true;
+        }
+
+        bool hex_4(std::uint32_t & cp)
+        {
+            for (int i = 0; i < 4; ++i, ++it_) {
+                if (it_ == last_)
+                    return expected("four hexidecimal digits");
+                char const c = *it_;
+                int digit = 0;
+                if ('0' <= c && c <= '9')
+                    digit = c - '0';
+                else if ('a' <= c && c <= 'f')
+                    digit = c - 'a' + 10;
+                else if ('A' <= c && c <= 'F')
+                    digit = c - 'A' + 10;
+                else
+                    return expected("four hexidecimal digits");
+                cp = cp * 16 + digit;
+            }
+            return true;
+        }
+
+        void append_utf8(std::uint32_t cp)
+        {
+            if (cp < 0x80) {
+                scratch_ += (char)cp;
+            } else if (cp < 0x800) {
+                scratch_ += (char)(0xc0 | (cp >> 6));
+                scratch_ += (char)(0x80 | (cp & 0x3f));
+            } else if (cp < 0x10000) {
+                scratch_ += (char)(0xe0 | (cp >> 12));
+                scratch_ += (char)(0x80 | ((cp >> 6) & 0x3f));
+                scratch_ += (char)(0x80 | (cp & 0x3f));
+            } else {
+                scratch_ += (char)(0xf0 | (cp >> 18));
+                scratch_ += (char)(0x80 | ((cp >> 12) & 0x3f));
+                scratch_ += (char)(0x80 | ((cp >> 6) & 0x3f));
+                scratch_ += (char)(0x80 | (cp & 0x3f));
+            }
+        }
+
+        bool literal(std::string_view lit)
+        {
+            if (std::string_view(it_, last_ - it_).starts_with(lit)) {
+                it_ += lit.size();
+                return true;
+            }
+            return false;
+        }
+
+        bool eat(char c)
+        {
+            if (it_ == last_ || *it_ != c)
+                return false;
+            ++it_;
+            return true;
+        }
+
+        void skip()
+        {
+            while (it_ != last_) {
+                char const c = *it_;
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                    ++it_;
+                } else if (c == '#') {
+                    while (it_ != last_ && *it_ != '\n') {
+                        ++it_;
+                    }
+                } else {
+                    break;
+                }
+            }
+        }
+
+        // Records an error in the form Boost.Parser uses for a failed
+        // expectation.
+        bool expected(std::string_view what)
+        {
+            error_ = "error: Expected ";
+            error_ += what;
+            error_ += " here";
+            if (it_ == last_)
+                error_ += " (end of input)";
+            return false;
+        }
+
+        bool too_deep()
+        {
+            error_ = "error: Exceeded maximum number (" +
+                     std::to_string(max_nesting) +
+                     ") of open arrays and/or objects";
+            return false;
+        }
+
+        char const * it_;
+        char const * last_;
+        Handler & handler_;
+        std::string scratch_;
+        std::string error_;
+    };
+
+}}}
+
+#endif
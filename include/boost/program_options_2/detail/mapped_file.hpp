@@ -0,0 +1,121 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_MAPPED_FILE_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_MAPPED_FILE_HPP
+
+#include <boost/program_options_2/config.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_MMAP
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // The read-only contents of a file.  Large regular files are
+    // memory-mapped where possible; anything else (small files, pipes,
+    // platforms without mmap()) is read into memory instead, allocated from
+    // resource.
+    struct mapped_file
+    {
+        explicit mapped_file(
+            char const * filename,
+            std::pmr::memory_resource * resource =
+                std::pmr::get_default_resource()) :
+            buffer_(resource)
+        {
+#if BOOST_PROGRAM_OPTIONS_2_USE_MMAP
+            int const fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return;
+            open_ = true;
+            struct stat st;
+            // Mapping costs more than reading, for small files.
+            if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+                min_mapped_size <= st.st_size) {
+                auto const size = (std::size_t)st.st_size;
+                void * const p =
+                    ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, size, MADV_SEQUENTIAL);
+                    map_ = p;
+                    map_size_ = size;
+                    contents_ = std::string_view((char const *)p, size);
+                    ::close(fd);
+                    return;
+                }
+            }
+            char buf[4096];
+            for (;;) {
+                auto const n = ::read(fd, buf, sizeof(buf));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0) {
+                    // A directory, say; this is not a file we can read.
+                    open_ = false;
+                    buffer_.clear();
+                    break;
+                }
+                if (n == 0)
+                    break;
+                buffer_.append(buf, n);
+            }
+            contents_ = buffer_;
+            ::close(fd);
+#else
+            std::ifstream ifs(filename, std::ios_base::binary);
+            if (!ifs)
+                return;
+            open_ = true;
+            buffer_.assign(
+                std::istreambuf_iterator<char>(ifs),
+                std::istreambuf_iterator<char>());
+            if (ifs.bad()) {
+                open_ = false;
+                buffer_.clear();
+            }
+            contents_ = buffer_;
+#endif
+        }
+
+        ~mapped_file()
+        {
+#if BOOST_PROGRAM_OPTIONS_2_USE_MMAP
+            if (map_)
+                ::munmap(map_, map_size_);
+#endif
+        }
+
+        mapped_file(mapped_file const &) = delete;
+        mapped_file & operator=(mapped_file const &) = delete;
+
+        bool is_open() const { return open_; }
+        std::string_view contents() const { return contents_; }
+
+    private:
+        static constexpr long min_mapped_size = 1 << 16;
+
+        std::string_view contents_;
+        std::pmr::string buffer_;
+        void * map_ = nullptr;
+        std::size_t map_size_ = 0;
+        bool open_ = false;
+    };
+
+}}}
+
+#endif
@@ -0,0 +1,258 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_NAME_INDEX_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_NAME_INDEX_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/concepts.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <boost/container/small_vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // Where an option lives in an opt-tuple.  option is the index of the
+    // element in the tuple; sub_option is the index of the option within
+    // the flattened options of a mutually exclusive group, or -1 if the
+    // element is not a group.
+    struct option_location
+    {
+        explicit operator bool() const { return 0 <= option; }
+
+        int option = -1;
+        int sub_option = -1;
+        bool counted = false;
+    };
+
+    inline std::size_t name_hash(std::string_view name)
+    {
+        // FNV-1a.
+        std::uint64_t retval = 14695981039346656037ull;
+        for (unsigned char c : name) {
+            retval ^= c;
+            retval *= 1099511628211ull;
+        }
+        return std::size_t(retval);
+    }
+
+    // An open-addressed hash table from each dashed option name to the
+    // location of its option.  It is built once per set of options, so that
+    // matching a command line token against all the options is a single
+    // lookup, instead of a walk over every option's comma-delimited names.
+    struct name_index
+    {
+        name_index() = default;
+
+        std::size_t size() const { return size_; }
+
+        void insert(std::string_view name, option_location loc)
+        {
+            if (name.empty())
+                return;
+            if (table_.size() < 2 * (size_ + 1))
+                grow();
+            auto & e = slot(name);
+            if (e.loc)
+                return; // The first option with a given name wins.
+            e.name = name;
+            e.loc = loc;
+            ++size_;
+            auto const c = (unsigned char)name.front();
+            first_chars_[c / 64] |= std::uint64_t(1) << (c % 64);
+        }
+
+        option_location find(std::string_view name) const
+        {
+            if (!could_contain(name))
+                return {};
+            return slot(name).loc;
+        }
+
+        template<typename Char>
+        option_location find(std::basic_string_view<Char> name) const
+        {
+            if constexpr (std::is_same_v<Char, char>) {
+                return find(std::string_view(name));
+            } else {
+                boost::container::small_vector<char, 64> buf;
+                if (detail::ascii(name)) {
+                    buf.assign(name.begin(), name.end());
+                } else {
+                    auto const utf8 = text::as_utf8(name);
+                    buf.assign(utf8.begin(), utf8.end());
+                }
+                return find(std::string_view(buf.data(), buf.size()));
+            }
+        }
+
+        template<typename Char>
+        bool contains(std::basic_string_view<Char> name) const
+        {
+            return (bool)find(name);
+        }
+
+        // Like find(), but also matches repetitions of a counted flag's
+        // short name, like "-vvv".
+        template<typename Char>
+        option_location find_option(
+            std::basic_string_view<Char> arg,
+            customizable_strings const & strings) const
+        {
+            auto retval = find(arg);
+            if (retval)
+                return retval;
+            auto const prefix_size = strings.short_option_prefix.size();
+            if (arg.size() <= prefix_size + 1 ||
+                !detail::transcoded_starts_with(
+                    arg, strings.short_option_prefix) ||
+                detail::transcoded_starts_with(
+                    arg, strings.long_option_prefix)) {
+                return retval;
+            }
+            auto const c = arg[prefix_size];
+            if (!std::all_of(arg.begin() + prefix_size, arg.end(), [c](auto x) {
+                    return x == c;
+                })) {
+                return retval;
+            }
+            auto const short_name = arg.substr(0, prefix_size + 1);
+            retval = find(short_name);
+            if (!retval.counted)
+                return {};
+            return retval;
+        }
+
+    private:
+        // Most tokens that are not names (values, positionals) can be
+        // rejected by their first character alone, without hashing.
+        bool could_contain(std::string_view name) const
+        {
+            if (name.empty())
+                return false;
+            auto const c = (unsigned char)name.front();
+            return first_chars_[c / 64] & (std::uint64_t(1) << (c % 64));
+        }
+
+        struct entry
+        {
+            std::string_view name;
+            option_location loc;
+        };
+
+        entry & slot(std::string_view name)
+        {
+            return const_cast<entry &>(
+                static_cast<name_index const &>(*this).slot(name));
+        }
+        entry const & slot(std::string_view name) const
+        {
+            std::size_t const mask = table_.size() - 1;
+            std::size_t i = detail::name_hash(name) & mask;
+            while (table_[i].loc && table_[i].name != name) {
+                i = (i + 1) & mask;
+            }
+            return table_[i];
+        }
+
+        void grow()
+        {
+            std::vector<entry> old(table_.empty() ? 16 : table_.size() * 2);
+            old.swap(table_);
+            size_ = 0;
+            for (auto const & e : old) {
+                if (e.loc)
+                    insert(e.name, e.loc);
+            }
+        }
+
+        std::vector<entry> table_;
+        std::size_t size_ = 0;
+        std::uint64_t first_chars_[4] = {};
+    };
+
+    template<typename Option>
+    void
+    add_names(name_index & index, Option const & opt, option_location loc)
+    {
+        if (opt.positional)
+            return;
+        loc.counted = opt.action == action_kind::count;
+        for (auto name : names_view(opt.names)) {
+            index.insert(name, loc);
+        }
+    }
+
+    // Builds an index of the names of the options in opt_tuple, an
+    // opt-tuple as produced by make_opt_tuple().  Commands are not indexed,
+    // since they are parsed in a separate pre-pass.
+    template<typename OptTuple>
+    name_index make_name_index(OptTuple const & opt_tuple)
+    {
+        name_index retval;
+        int i = 0;
+        hana::for_each(opt_tuple, [&](auto const & opt) {
+            using opt_type = std::remove_cvref_t<decltype(opt)>;
+            if constexpr (group_<opt_type>) {
+                if constexpr (opt_type::mutually_exclusive) {
+                    int j = 0;
+                    hana::for_each(
+                        detail::make_opt_tuple(
+                            detail::to_ref_tuple(opt.options)),
+                        [&](auto const & sub_opt) {
+                            detail::add_names(retval, sub_opt, {i, j});
+                            ++j;
+                        });
+                }
+            } else {
+                detail::add_names(retval, opt, {i, -1});
+            }
+            ++i;
+        });
+        return retval;
+    }
+
+    template<typename... Options>
+    void add_all_names(name_index & index, Options const &... opts);
+
+    template<typename Option>
+    void add_all_names_impl(name_index & index, Option const & opt)
+    {
+        if constexpr (group_<Option>) {
+            hana::unpack(opt.options, [&](auto const &... opts) {
+                detail::add_all_names(index, opts...);
+            });
+        } else {
+            detail::add_names(index, opt, {0, -1});
+        }
+    }
+
+    template<typename... Options>
+    void add_all_names(name_index & index, Options const &... opts)
+    {
+        auto dummy = (detail::add_all_names_impl(index, opts), ..., 0);
+        (void)dummy;
+    }
+
+    // Builds an index of the names of every option in opts, including the
+    // options within all groups and commands.  This is used only to answer
+    // the question "Is this a known dashed argument?"; the locations it
+    // contains are meaningless.
+    template<typename... Options>
+    name_index make_known_names_index(Options const &... opts)
+    {
+        name_index retval;
+        detail::add_all_names(retval, opts...);
+        return retval;
+    }
+
+}}}
+
+#endif
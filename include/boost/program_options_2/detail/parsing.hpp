@@ -9,16 +9,70 @@
 #include <boost/program_options_2/concepts.hpp>
 #include <boost/program_options_2/arg_view.hpp>
 #include <boost/program_options_2/options.hpp>
+#include <boost/program_options_2/response_file_buffers.hpp>
+#include <boost/program_options_2/detail/name_index.hpp>
 #include <boost/program_options_2/detail/printing.hpp>
+#include <boost/program_options_2/detail/response_files.hpp>
+#include <boost/program_options_2/detail/thread_pool.hpp>
+#include <boost/program_options_2/detail/token_scan.hpp>
 
 #include <boost/container/flat_map.hpp>
 #include <boost/parser/parser.hpp>
 #include <boost/text/string_utility.hpp>
 #include <boost/type_traits/is_detected.hpp>
 
+#include <charconv>
+#include <memory_resource>
+#include <ranges>
+
 
 namespace boost { namespace program_options_2 { namespace detail {
 
+    // What a parse does when it encounters an error, or the user requests
+    // help or version.  By default, it prints something and exits.
+    struct parse_mode
+    {
+        parse_mode() = default;
+        explicit parse_mode(bool deserializing) : deserializing(deserializing)
+        {}
+        explicit parse_mode(parse_status & status) : status(&status) {}
+
+        bool exits() const { return !deserializing && !status; }
+
+        template<typename Char>
+        void report(
+            parse_option_error error, std::basic_string_view<Char> token) const
+        {
+            if (!status || status->error != parse_option_error::none)
+                return;
+            status->error = error;
+            auto const token_utf8 = text::as_utf8(token);
+            status->token.assign(token_utf8.begin(), token_utf8.end());
+        }
+
+        // When loading options from a file, problems are silently ignored,
+        // and a partial set of positionals is allowed.
+        bool deserializing = false;
+
+        // If non-null, problems are recorded here instead, and the parse
+        // stops.
+        parse_status * status = nullptr;
+
+        // Where the memory the parse uses for its own bookkeeping comes
+        // from.  The results of the parse are not allocated from here.
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource();
+
+        // If non-null, the response files read by the parse are kept here,
+        // so that results that refer to them stay valid after the parse.
+        response_file_buffers * buffers = nullptr;
+
+        // The threads that help read response files, when
+        // customizable_strings::response_file_threads allows.  If null,
+        // default_thread_pool() is used.
+        thread_pool * pool = nullptr;
+    };
+
     template<typename... Options>
     bool no_help_option(Options const &... opts)
     {
@@ -32,7 +86,7 @@ namespace boost { namespace program_options_2 { namespace detail {
         auto const names = names_view(strings.default_help_names);
         for (auto arg : args) {
             for (auto name : names) {
-                if (std::ranges::equal(text::as_utf8(arg), text::as_utf8(name)))
+                if (detail::transcoded_equal(arg, name))
                     return true;
             }
         }
@@ -83,7 +137,8 @@ namespace boost { namespace program_options_2 { namespace detail {
     {
         constexpr bool required_option = Option::positional || Option::required;
         using T = typename Option::type;
-        if constexpr (std::is_same_v<T, void>) {
+        if constexpr (
+            std::is_same_v<T, void> || detail::is_value_sink<T>::value) {
             return no_value{};
         } else if constexpr (required_option) {
             return T{};
@@ -167,6 +222,23 @@ namespace boost { namespace program_options_2 { namespace detail {
     struct is_string<std::basic_string<Char>> : std::true_type
     {};
 
+    // True if a T loaded from some input (a file, say) refers into that
+    // input, instead of holding a copy.
+    template<typename T>
+    constexpr bool refers_to_input_buffer()
+    {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return true;
+        } else if constexpr (is_optional<T>::value) {
+            return detail::refers_to_input_buffer<typename T::value_type>();
+        } else if constexpr (insertable<T> && !is_string<T>::value) {
+            return detail::refers_to_input_buffer<
+                std::ranges::range_value_t<T>>();
+        } else {
+            return false;
+        }
+    }
+
     template<typename Char, typename T>
     auto parser_for()
     {
@@ -267,7 +339,7 @@ namespace boost { namespace program_options_2 { namespace detail {
             if (program_options_2::any_empty(t)) {
                 stored_type temp;
                 detail::assign_or_insert_impl<opt_type, false>(temp, u);
-                t = temp;
+                t = std::move(temp);
             } else {
                 detail::assign_or_insert_impl<opt_type, false>(
                     program_options_2::any_cast<stored_type &>(t), u);
@@ -277,6 +349,51 @@ namespace boost { namespace program_options_2 { namespace detail {
         }
     }
 
+    // Returns what the values parsed for opt go into: result, or, for an
+    // option made by with_sink(), the option's own sink.
+    template<typename Option, typename Result>
+    auto & value_destination(Option const & opt, Result & result)
+    {
+        if constexpr (detail::is_value_sink<typename Option::type>::value)
+            return opt.sink;
+        else
+            return result;
+    }
+
+    template<typename T>
+    void reserve_values_impl(T & t, std::ptrdiff_t n)
+    {
+        if constexpr (is_optional<T>::value) {
+            if (t)
+                detail::reserve_values_impl(*t, n);
+        } else if constexpr (requires { t.reserve(t.capacity()); }) {
+            // Grow geometrically, since an option may appear many times,
+            // each time with a few values.
+            auto const size = t.size() + n;
+            if (t.capacity() < size)
+                t.reserve((std::max)(size, 2 * t.capacity()));
+        } else if constexpr (requires { t.reserve(t.size()); }) {
+            t.reserve((std::max)(t.size() + n, 2 * t.size()));
+        }
+    }
+
+    // Makes room for n more values in t, if t is (or holds) a container
+    // with reserve().  This must only be called after at least one value
+    // has been inserted into t with assign_or_insert<Option>().
+    template<typename Option, typename T>
+    void reserve_values(T & t, std::ptrdiff_t n)
+    {
+        if (n <= 0)
+            return;
+        if constexpr (inserting_into_any<Option, T>::value) {
+            using stored_type = result_map_element_t<Option>;
+            detail::reserve_values_impl(
+                program_options_2::any_cast<stored_type &>(t), n);
+        } else {
+            detail::reserve_values_impl(t, n);
+        }
+    }
+
     template<typename Char, typename Option, typename Attr>
     void validate(
         Option const & opt,
@@ -334,7 +451,7 @@ namespace boost { namespace program_options_2 { namespace detail {
     bool transcoding_compare(T const & t, U const & u)
     {
         if constexpr (detail::string_like<T>() && detail::string_like<U>()) {
-            return std::ranges::equal(text::as_utf32(t), text::as_utf32(u));
+            return detail::transcoded_equal(t, u);
         } else {
             return t == u;
         }
@@ -397,10 +514,183 @@ namespace boost { namespace program_options_2 { namespace detail {
         }
     }
 
+    // The type parser_for<Char, T>() produces for a single arg.
+    template<typename T>
+    auto parsed_type_impl()
+    {
+        if constexpr (is_optional<T>::value) {
+            return detail::parsed_type_impl<typename T::value_type>();
+        } else if constexpr (is_string<T>::value) {
+            return hana::type_c<T>;
+        } else if constexpr (insertable<T>) {
+            return detail::parsed_type_impl<std::ranges::range_value_t<T>>();
+        } else {
+            return hana::type_c<T>;
+        }
+    }
+    template<typename T>
+    using parsed_type_t = typename decltype(parsed_type_impl<T>())::type;
+
+    // clang-format off
+    template<typename T>
+    concept from_chars_convertible =
+        requires(char const * first, T & value) {
+            std::from_chars(first, first, value);
+        };
+    // clang-format on
+
+    // Returns true if args for opt are converted directly by convert_arg(),
+    // instead of by a Boost.Parser parser.
+    template<typename Char, typename Option>
+    constexpr bool direct_conversion()
+    {
+        using T = parsed_type_t<std::conditional_t<
+            detail::has_choices<Option>(),
+            typename Option::choice_type,
+            typename Option::type>>;
+        return std::is_same_v<Char, char> &&
+               (std::is_same_v<T, bool> || from_chars_convertible<T> ||
+                std::is_same_v<T, std::string> ||
+                std::is_same_v<T, std::string_view>);
+    }
+
+    // Converts all of arg to value.  This accepts exactly what the
+    // corresponding parser from parser_for() accepts.
+    template<typename T>
+    bool convert_arg(std::string_view arg, T & value)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (arg == "true") {
+                value = true;
+                return true;
+            }
+            if (arg == "false") {
+                value = false;
+                return true;
+            }
+            return false;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            value.assign(arg.begin(), arg.end());
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            value = arg;
+            return true;
+        } else {
+            char const * first = arg.data();
+            char const * const last = first + arg.size();
+            // Unlike std::from_chars(), Boost.Parser accepts a leading '+'
+            // for signed and floating point values.
+            if constexpr (std::is_signed_v<T> || std::is_floating_point_v<T>) {
+                if (first != last && *first == '+') {
+                    ++first;
+                    if (first != last && *first == '-')
+                        return false;
+                }
+            }
+            auto const result = std::from_chars(first, last, value);
+            return result.ec == std::errc() && result.ptr == last;
+        }
+    }
+
+    // Parses arg into result, doing exactly what the semantic action from
+    // parse_action_for() does.
+    template<typename Char, typename Option, typename Result>
+    bool parse_arg_directly(
+        std::string_view arg,
+        Option const & opt,
+        Result & result,
+        parse_option_error & error,
+        std::basic_string_view<Char> & validation_error)
+    {
+        if constexpr (detail::has_choices<Option>()) {
+            parsed_type_t<typename Option::choice_type> attr{};
+            if (!detail::convert_arg(arg, attr))
+                return false;
+            auto pred = [&attr](auto const & choice) {
+                return detail::transcoding_compare(choice, attr);
+            };
+            if (std::ranges::find_if(opt.choices, pred) == opt.choices.end()) {
+                error = parse_option_error::no_such_choice;
+                return false;
+            }
+            detail::assign_or_insert<Option>(result, attr);
+        } else {
+            parsed_type_t<typename Option::type> attr{};
+            if (!detail::convert_arg(arg, attr))
+                return false;
+            detail::validate(opt, attr, validation_error);
+            detail::assign_or_insert<Option>(result, attr);
+        }
+        return true;
+    }
+
+    // Returns a callable that parses a single arg for opt into result.  The
+    // built-in types are converted directly; Boost.Parser is only used for
+    // all other types.
+    template<typename Char, typename Option, typename Result>
+    auto arg_parser_for(
+        Option const & opt,
+        Result & result,
+        parse_option_error & error,
+        std::basic_string_view<Char> & validation_error)
+    {
+        if constexpr (detail::direct_conversion<Char, Option>()) {
+            return [&opt, &result, &error, &validation_error](
+                       auto const & arg) {
+                return detail::parse_arg_directly(
+                    detail::make_string_view(arg),
+                    opt,
+                    result,
+                    error,
+                    validation_error);
+            };
+        } else {
+            return [parser = detail::parser_for<Char>(
+                        opt, result, error, validation_error)](
+                       auto const & arg) { return parser::parse(arg, parser); };
+        }
+    }
+
+    template<typename Char, typename F>
+    bool for_each_delimited_impl(
+        std::basic_string_view<Char> arg,
+        std::basic_string_view<Char> separator,
+        F & f)
+    {
+        while (true) {
+            auto const pos = arg.find(separator);
+            if (pos == arg.npos)
+                return f(arg);
+            if (!f(arg.substr(0, pos)))
+                return false;
+            arg.remove_prefix(pos + separator.size());
+        }
+    }
+
+    // Calls f on each separator-delimited element of arg, in order, and
+    // stops at the first element for which f returns false.  The search for
+    // each separator is basic_string_view::find(), which finds candidates
+    // with char_traits::find() -- that is, with memchr() or wmemchr().
+    template<typename Char, typename F>
+    bool for_each_delimited(
+        std::basic_string_view<Char> arg, std::string_view separator, F && f)
+    {
+        if constexpr (std::is_same_v<Char, char>) {
+            return detail::for_each_delimited_impl(arg, separator, f);
+        } else {
+            // The separator is ASCII, so it can be widened code unit by code
+            // unit.
+            std::basic_string<Char> const wide_separator(
+                separator.begin(), separator.end());
+            return detail::for_each_delimited_impl(
+                arg, std::basic_string_view<Char>(wide_separator), f);
+        }
+    }
+
     template<typename Char, typename HelpOption, typename... Options>
     void handle_help_option(
         customizable_strings const & strings,
-        bool deserializing,
+        parse_mode mode,
         std::basic_string_view<Char> argv0,
         std::basic_string_view<Char> program_desc,
         std::basic_ostream<Char> & os,
@@ -408,8 +698,11 @@ namespace boost { namespace program_options_2 { namespace detail {
         HelpOption const & help_opt,
         Options const &... opts)
     {
-        if (deserializing)
+        if (!mode.exits()) {
+            if (mode.status)
+                mode.status->help_requested = true;
             return;
+        }
         if constexpr (std::invocable<typename HelpOption::value_type>) {
             os << text::as_utf8(help_opt.default_value());
 #ifdef BOOST_PROGRAM_OPTIONS_2_TESTING
@@ -432,10 +725,13 @@ namespace boost { namespace program_options_2 { namespace detail {
 
     template<typename Char, typename Option>
     void handle_version_option(
-        bool deserializing, std::basic_ostream<Char> & os, Option const & opt)
+        parse_mode mode, std::basic_ostream<Char> & os, Option const & opt)
     {
-        if (deserializing)
+        if (!mode.exits()) {
+            if (mode.status)
+                mode.status->version_requested = true;
             return;
+        }
         if constexpr (std::is_same_v<
                           typename Option::value_type,
                           std::string_view>) {
@@ -450,17 +746,20 @@ namespace boost { namespace program_options_2 { namespace detail {
     template<typename Char, typename... Options>
     void handle_validation_error(
         customizable_strings const & strings,
-        bool deserializing,
+        parse_mode mode,
         std::basic_string_view<Char> argv0,
         std::basic_string_view<Char> program_desc,
         std::basic_ostream<Char> & os,
         bool no_help,
         std::basic_string_view<Char> error,
+        std::basic_string_view<Char> arg,
         parse_contexts_vec const & parse_contexts,
         Options const &... opts)
     {
-        if (deserializing)
+        if (!mode.exits()) {
+            mode.report(parse_option_error::validation_error, arg);
             return;
+        }
         os << text::as_utf8(error);
         os << '\n';
         detail::print_help_and_exit(
@@ -478,8 +777,7 @@ namespace boost { namespace program_options_2 { namespace detail {
     bool matches_view(std::basic_string_view<Char> arg, names_view names)
     {
         if (std::ranges::find_if(names, [&](auto name) {
-                return std::ranges::equal(
-                    text::as_utf8(arg), text::as_utf8(name));
+                return detail::transcoded_equal(arg, name);
             }) != names.end()) {
             return true;
         }
@@ -494,43 +792,12 @@ namespace boost { namespace program_options_2 { namespace detail {
     }
 
     template<typename Char>
-    struct known_dashed_argument_impl
-    {
-        template<typename... Options>
-        bool operator()(Options const &... opts)
-        {
-            if (!detail::leading_dash(arg, strings))
-                return false;
-            return (single(opts) || ...);
-        }
-
-        template<typename Option>
-        bool single(Option const & opt)
-        {
-            if constexpr (group_<Option>)
-                return hana::unpack(opt.options, *this);
-            else
-                return detail::matches_names(arg, opt.names);
-        }
-
-        std::basic_string_view<Char> arg;
-        customizable_strings const & strings;
-    };
-
-    // TODO: This should maybe use a trie (pending perf testing, of course).
-    template<typename StringView, typename... Options>
-    bool known_dashed_argument(
-        StringView arg,
-        customizable_strings const & strings,
-        Options const &... opts)
-    {
-        known_dashed_argument_impl impl{detail::make_string_view(arg), strings};
-        return impl(opts...);
-    }
-
-    template<typename Char>
-    using exclusives_map =
-        boost::container::flat_map<int, std::basic_string<Char>>;
+    using exclusives_map = boost::container::flat_map<
+        int,
+        std::pmr::basic_string<Char>,
+        std::less<int>,
+        std::pmr::polymorphic_allocator<
+            std::pair<int, std::pmr::basic_string<Char>>>>;
 
     template<
         typename Char,
@@ -540,7 +807,7 @@ namespace boost { namespace program_options_2 { namespace detail {
         typename... Options>
     parse_option_result parse_option(
         customizable_strings const & strings,
-        bool deserializing,
+        parse_mode mode,
         std::basic_string_view<Char> argv0,
         std::basic_string_view<Char> program_desc,
         std::basic_ostream<Char> & os,
@@ -552,6 +819,7 @@ namespace boost { namespace program_options_2 { namespace detail {
         int & next_positional,
         exclusives_map<Char> & exclusives_seen,
         int exclusives_group,
+        name_index const & known_names,
         parse_contexts_vec const & parse_contexts,
         Options const &... opts)
     {
@@ -563,14 +831,21 @@ namespace boost { namespace program_options_2 { namespace detail {
             if (opt.action == action_kind::count) {
                 // Special case: parse the repetitions of a counted flag
                 // differently.
-                auto short_flag = detail::first_short_name(opt.names, strings);
-                BOOST_ASSERT(short_flag.size() == 2u);
-                if (!first->empty() && first->front() == '-') {
-                    int const count = std::count(
-                        first->begin() + 1, first->end(), short_flag[1]);
-                    if (count + 1 == (int)first->size()) {
+                auto const short_flag =
+                    detail::first_short_name(opt.names, strings);
+                auto const prefix_size = strings.short_option_prefix.size();
+                BOOST_ASSERT(short_flag.size() == prefix_size + 1u);
+                auto const arg = detail::make_string_view(*first);
+                if (detail::dashed_token(first, strings) &&
+                    prefix_size < arg.size()) {
+                    using unit_type = std::make_unsigned_t<Char>;
+                    auto const c = (unsigned char)short_flag[prefix_size];
+                    if (std::all_of(
+                            arg.begin() + prefix_size,
+                            arg.end(),
+                            [c](Char x) { return (unit_type)x == c; })) {
                         if constexpr (std::is_assignable_v<ResultType &, int>) {
-                            result = count;
+                            result = (int)(arg.size() - prefix_size);
                         }
                         ++first;
                         return {parse_option_result::match_keep_parsing};
@@ -578,8 +853,8 @@ namespace boost { namespace program_options_2 { namespace detail {
                 }
             }
 
-            if (!detail::known_dashed_argument(*first, strings, opt))
-                return {};
+            // Note that there is no need to check that *first matches opt
+            // here; the caller only gets here if the name index says so.
 
             if (0 <= exclusives_group) {
                 if (exclusives_seen.count(exclusives_group)) {
@@ -616,15 +891,19 @@ namespace boost { namespace program_options_2 { namespace detail {
             if (opt.action == action_kind::help) {
                 detail::handle_help_option(
                     strings,
-                    deserializing,
+                    mode,
                     argv0,
                     program_desc,
                     os,
                     no_help,
                     opt,
                     opts...);
+                if (mode.status)
+                    return {parse_option_result::stop_parsing};
             } else if (opt.action == action_kind::version) {
-                detail::handle_version_option(deserializing, os, opt);
+                detail::handle_version_option(mode, os, opt);
+                if (mode.status)
+                    return {parse_option_result::stop_parsing};
             }
 
             // Special case: early return after matching a long counted
@@ -662,12 +941,13 @@ namespace boost { namespace program_options_2 { namespace detail {
             [&](std::basic_string_view<Char> validation_error) {
                 detail::handle_validation_error(
                     strings,
-                    deserializing,
+                    mode,
                     argv0,
                     program_desc,
                     os,
                     no_help,
                     validation_error,
+                    detail::make_string_view(*first),
                     parse_contexts,
                     opts...);
             };
@@ -680,8 +960,14 @@ namespace boost { namespace program_options_2 { namespace detail {
                               typename Option::validator_type,
                               no_value>) {
                 validation_result const validation = opt.validator(*first);
-                if (!validation.valid)
+                if (!validation.valid) {
                     handle_validation_error_(validation.error);
+                    if (mode.status) {
+                        return {
+                            parse_option_result::stop_parsing,
+                            parse_option_error::validation_error};
+                    }
+                }
             }
             return {parse_option_result::response_file};
         }
@@ -689,10 +975,17 @@ namespace boost { namespace program_options_2 { namespace detail {
         int reps = 0;
         parse_option_error error = parse_option_error::none;
         std::basic_string_view<Char> validation_error;
-        auto const parser =
-            detail::parser_for<Char>(opt, result, error, validation_error);
-        if (!detail::known_dashed_argument(*first, strings, opts...) &&
-            parser::parse(*first, parser)) {
+        auto & destination = detail::value_destination(opt, result);
+        auto const parse_element = detail::arg_parser_for<Char>(
+            opt, destination, error, validation_error);
+        auto parse_arg = [&](auto const & arg) {
+            if (opt.separator.empty())
+                return parse_element(arg);
+            return detail::for_each_delimited(
+                detail::make_string_view(arg), opt.separator, parse_element);
+        };
+        if (!detail::known_name_token(first, known_names) &&
+            parse_arg(*first)) {
             if (!validation_error.empty()) {
                 handle_validation_error_(validation_error);
                 return {
@@ -701,10 +994,18 @@ namespace boost { namespace program_options_2 { namespace detail {
             }
             ++first;
             ++reps;
+            // Make room for all the values that follow at once, instead of
+            // growing the result one value at a time.
+            if (reps < max_reps) {
+                detail::reserve_values<Option>(
+                    destination,
+                    detail::value_run_length(
+                        first, last, max_reps - reps, known_names));
+            }
             for (; reps < max_reps && first != last &&
-                   !detail::known_dashed_argument(*first, strings, opts...);
+                   !detail::known_name_token(first, known_names);
                  ++reps, ++first) {
-                if (!parser::parse(*first, parser)) {
+                if (!parse_arg(*first)) {
                     if (error == parse_option_error::none)
                         error = parse_option_error::cannot_parse_arg;
                     break;
@@ -722,7 +1023,10 @@ namespace boost { namespace program_options_2 { namespace detail {
         }
 
         if (min_reps <= reps && reps <= max_reps) {
-            next = parse_option_result::match_keep_parsing;
+            // A positional that matched zero args consumed nothing, so it
+            // does not count as a match, though we're done with it.
+            if (reps || !detail::positional(opt, strings))
+                next = parse_option_result::match_keep_parsing;
             if (detail::positional(opt, strings))
                 ++next_positional;
             return {next};
@@ -761,6 +1065,110 @@ namespace boost { namespace program_options_2 { namespace detail {
         return retval;
     }
 
+    template<typename OptTuple>
+    constexpr std::size_t opt_tuple_size =
+        decltype(hana::size(std::declval<OptTuple const &>()))::value;
+
+    template<typename OptTuple, std::size_t I>
+    using opt_tuple_element_t = std::remove_cvref_t<decltype(
+        std::declval<OptTuple const &>()[hana::llong_c<I>])>;
+
+    template<typename OptTuple, std::size_t... Is>
+    constexpr auto positional_indices_impl(std::index_sequence<Is...>)
+    {
+        constexpr bool positional[] = {
+            false, opt_tuple_element_t<OptTuple, Is>::positional...};
+        std::array<int, (std::size_t(0) + ... + positional[Is + 1])> retval{};
+        std::size_t j = 0;
+        for (std::size_t i = 0; i < sizeof...(Is); ++i) {
+            if (positional[i + 1])
+                retval[j++] = i;
+        }
+        return retval;
+    }
+
+    // Returns the indices of the positionals in OptTuple, in order.
+    template<typename OptTuple>
+    constexpr auto positional_indices()
+    {
+        return detail::positional_indices_impl<OptTuple>(
+            std::make_index_sequence<opt_tuple_size<OptTuple>>());
+    }
+
+    template<long long I, typename F>
+    void call_with_index(F const & f)
+    {
+        f(hana::llong_c<I>);
+    }
+
+    template<typename F, std::size_t... Is>
+    void dispatch_impl(int i, F const & f, std::index_sequence<Is...>)
+    {
+        using handler = void (*)(F const &);
+        static constexpr handler handlers[] = {
+            &detail::call_with_index<Is, F>...};
+        handlers[i](f);
+    }
+
+    // Calls f(hana::llong_c<i>), through a table of handlers indexed by i,
+    // instead of testing each possible index in turn.
+    template<std::size_t N, typename F>
+    void dispatch(int i, F const & f)
+    {
+        if constexpr (N != 0u) {
+            BOOST_ASSERT(0 <= i && i < (int)N);
+            detail::dispatch_impl(i, f, std::make_index_sequence<N>());
+        }
+    }
+
+    // Returns true if result_i, an element of a map or of a result tuple,
+    // has no value.
+    template<typename T>
+    bool result_empty(T const & result_i)
+    {
+        if constexpr (is_erased_type<T>::value)
+            return program_options_2::any_empty(result_i);
+        else
+            return !result_i;
+    }
+
+    // Records that the value for the option at index i has just been
+    // assigned through accessor, if accessor's storage keeps track of that
+    // (as a typed_options does).
+    template<typename Accessor, typename I>
+    void note_assigned(Accessor & accessor, I i)
+    {
+        if constexpr (requires { accessor.assigned(i); })
+            accessor.assigned(i);
+    }
+
+    // Gives each option in opt_tuple that has a default, and that got no
+    // value during parsing, its default value.
+    template<typename Accessor, typename OptTuple>
+    void assign_defaults(Accessor & accessor, OptTuple const & opt_tuple)
+    {
+        using namespace hana::literals;
+
+        hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
+            auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
+            using opt_type = std::remove_cvref_t<decltype(opt)>;
+            if constexpr (!is_command<opt_type>::value) {
+                auto & result_i = accessor(opt, i);
+                using result_type = std::remove_cvref_t<decltype(result_i)>;
+                if constexpr (
+                    !opt_type::required && detail::has_default<opt_type>() &&
+                    !std::is_same_v<result_type, no_value>) {
+                    if (detail::result_empty(result_i)) {
+                        detail::assign_or_insert<opt_type>(
+                            result_i, opt.default_value);
+                        detail::note_assigned(accessor, i);
+                    }
+                }
+            }
+            return i_plus_1;
+        });
+    }
+
     template<
         typename Accessor,
         typename Char,
@@ -772,7 +1180,7 @@ namespace boost { namespace program_options_2 { namespace detail {
         Accessor accessor,
         int & next_positional,
         customizable_strings const & strings,
-        bool deserializing,
+        parse_mode mode,
         bool final_parse_step,
         ArgsIter & first,
         ArgsIter last,
@@ -782,48 +1190,58 @@ namespace boost { namespace program_options_2 { namespace detail {
         bool no_help,
         FailFunc const & fail,
         exclusives_map<Char> & exclusives_seen,
-        int exclusives_group,
+        response_file_cache & response_files,
         OptTuple const & opt_tuple,
+        name_index const & names,
+        name_index const & known_names,
         parse_contexts_vec const & parse_contexts,
         Options const &... opts)
     {
-        auto parse_option_ =
-            [&](auto & first, auto last, auto const & opt, auto & result) {
-                return detail::parse_option<Char>(
-                    strings,
-                    deserializing,
-                    argv0,
-                    program_desc,
-                    os,
-                    no_help,
-                    first,
-                    last,
-                    opt,
-                    result,
-                    next_positional,
-                    exclusives_seen,
-                    exclusives_group,
-                    parse_contexts,
-                    opts...);
-            };
+        auto parse_option_ = [&](auto & first,
+                                 auto last,
+                                 auto const & opt,
+                                 auto & result,
+                                 int exclusives_group) {
+            return detail::parse_option<Char>(
+                strings,
+                mode,
+                argv0,
+                program_desc,
+                os,
+                no_help,
+                first,
+                last,
+                opt,
+                result,
+                next_positional,
+                exclusives_seen,
+                exclusives_group,
+                known_names,
+                parse_contexts,
+                opts...);
+        };
 
-        auto process_response_file = [&](auto & sv_it) {
-            auto const arg_utf8 = text::as_utf8(*sv_it);
-            std::string arg(arg_utf8.begin(), arg_utf8.end());
-            if (detail::transcoded_starts_with(
-                    arg, strings.response_file_prefix)) {
-                arg.erase(arg.begin());
+        auto process_response_file = [&](auto & sv_it) -> parse_option_result {
+            auto const path = detail::response_file_path(
+                detail::make_string_view(*sv_it),
+                strings,
+                response_files.resource());
+            auto error = parse_option_error::none;
+            auto * const file = response_files.enter(
+                path.c_str(), strings.max_response_file_depth, error);
+            if (!file) {
+                fail(error, *sv_it);
+                return {parse_option_result::stop_parsing, error};
             }
-            std::ifstream ifs(arg.c_str());
-            ifs.unsetf(ifs.skipws);
-            auto file_args = detail::response_file_arg_view(ifs);
-            auto file_first = file_args.begin();
-            auto const file_last = file_args.end();
-            detail::parse_options_into_impl(
+            response_file_scope const scope(response_files, *file);
+            auto const tokens = file->tokens();
+            auto file_first = tokens.begin();
+            auto const file_last = tokens.end();
+            auto const result = detail::parse_options_into_impl(
                 accessor,
                 next_positional,
                 strings,
-                deserializing,
+                mode,
                 final_parse_step,
                 file_first,
                 file_last,
@@ -833,20 +1251,21 @@ namespace boost { namespace program_options_2 { namespace detail {
                 no_help,
                 fail,
                 exclusives_seen,
-                -1,
+                response_files,
                 opt_tuple,
+                names,
+                known_names,
                 parse_contexts,
                 opts...);
             ++sv_it;
+            return result;
         };
 
-        using namespace hana::literals;
+        constexpr auto positionals = detail::positional_indices<OptTuple>();
 
         while (first != last) {
             // Special case: an arg starting with the response file prefix.
-            if (!strings.response_file_note.empty() &&
-                detail::transcoded_starts_with(
-                    *first, strings.response_file_prefix)) {
+            if (detail::response_file_token(first, strings)) {
                 auto const response_file_opt =
                     program_options_2::response_file("-d", "Dummy.", strings);
                 validation_result const validation =
@@ -855,116 +1274,120 @@ namespace boost { namespace program_options_2 { namespace detail {
                 if (!validation.valid) {
                     detail::handle_validation_error(
                         strings,
-                        deserializing,
+                        mode,
                         argv0,
                         program_desc,
                         os,
                         no_help,
                         validation.error,
+                        detail::make_string_view(*first),
                         parse_contexts,
                         opts...);
                     return {
                         parse_option_result::stop_parsing,
                         parse_option_error::validation_error};
                 }
-                process_response_file(first);
+                auto const file_result = process_response_file(first);
+                if (!file_result)
+                    return file_result;
                 continue;
             }
 
-            auto const initial_first = first;
-            int positional_index = -1;
             parse_option_result parse_result;
+            bool consumed_arg = false;
 
             // Parse a typical option.
-            auto parse_leaf_opt = [&](auto i, auto const & opt) {
-                // Skip this option if it is a positional we've already
-                // processed.
-                if (detail::positional(opt, strings)) {
-                    ++positional_index;
-                    if (positional_index < next_positional)
+            auto parse_leaf_opt =
+                [&](auto i, auto const & opt, int exclusives_group) {
+                    parse_result = parse_option_(
+                        first, last, opt, accessor(opt, i), exclusives_group);
+                    consumed_arg = parse_result.next !=
+                                   parse_option_result::no_match_keep_parsing;
+                    if (consumed_arg && parse_result)
+                        detail::note_assigned(accessor, i);
+
+                    // Special case: if we just parsed a response_file opt
+                    // successfully, process the file.
+                    if (parse_result.next ==
+                        parse_option_result::response_file) {
+                        auto const file_result = process_response_file(first);
+                        if (!file_result)
+                            parse_result = file_result;
                         return;
-                }
-
-                parse_result =
-                    parse_option_(first, last, opt, accessor(opt, i));
-
-                // Special case: if we just parsed a response_file opt
-                // successfully, process the file.
-                if (parse_result.next == parse_option_result::response_file) {
-                    process_response_file(first);
-                    return;
-                }
-
-                if (!parse_result) {
-                    if (parse_result.error ==
-                            parse_option_error::cannot_parse_arg ||
-                        parse_result.error ==
-                            parse_option_error::extra_positional) {
-                        fail(parse_result.error, *first);
-                    } else if (
-                        parse_result.error ==
-                        parse_option_error::no_such_choice) {
-                        fail(parse_result.error, *first, opt_tuple[i].names);
-                    } else if (
-                        parse_result.error ==
-                        parse_option_error::too_many_mutually_exclusives) {
-                        BOOST_ASSERT(0 <= exclusives_group);
-                        fail(
-                            parse_result.error,
-                            exclusives_seen[exclusives_group],
-                            *first);
-                    } else {
-                        fail(parse_result.error, opt_tuple[i].names);
                     }
-                }
-            };
 
-            hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
-                auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
+                    if (!parse_result &&
+                        parse_result.error != parse_option_error::none) {
+                        if (parse_result.error ==
+                                parse_option_error::cannot_parse_arg ||
+                            parse_result.error ==
+                                parse_option_error::extra_positional) {
+                            fail(parse_result.error, *first);
+                        } else if (
+                            parse_result.error ==
+                            parse_option_error::no_such_choice) {
+                            fail(parse_result.error, *first, opt.names);
+                        } else if (
+                            parse_result.error ==
+                            parse_option_error::too_many_mutually_exclusives) {
+                            BOOST_ASSERT(0 <= exclusives_group);
+                            fail(
+                                parse_result.error,
+                                exclusives_seen[exclusives_group],
+                                *first);
+                        } else {
+                            fail(parse_result.error, opt.names);
+                        }
+                    }
+                };
 
-                if (!parse_result)
-                    return i_plus_1;
-
-                using opt_type = std::remove_cvref_t<decltype(opt)>;
-                if constexpr (group_<opt_type>) {
-                    if constexpr (opt.subcommand) {
-                        // Intentionally skipped; commands are parsed in a
-                        // pre-pass.
-                    } else if constexpr (opt.mutually_exclusive) {
-                        parse_result = detail::parse_options_into_impl(
-                            [&](auto const & opt, auto j) -> decltype(auto) {
-                                return accessor(opt, i);
-                            },
-                            next_positional,
-                            strings,
-                            deserializing,
-                            final_parse_step,
-                            first,
-                            last,
-                            argv0,
-                            program_desc,
-                            os,
-                            no_help,
-                            fail,
-                            exclusives_seen,
-                            (int)i,
-                            detail::make_opt_tuple(
-                                detail::to_ref_tuple(opt.options)),
-                            parse_contexts,
-                            opts...);
-                    } else {
-                        parse_leaf_opt(i, opt);
+            // Only a dashed arg can name an option.
+            auto const location =
+                detail::dashed_token(first, strings)
+                    ? names.find_option(detail::make_string_view(*first), strings)
+                    : option_location{};
+            if (location) {
+                // *first names an option; jump straight to it.
+                detail::dispatch<detail::opt_tuple_size<OptTuple>>(
+                    location.option, [&](auto i) {
+                        auto const & opt = opt_tuple[i];
+                        using opt_type = std::remove_cvref_t<decltype(opt)>;
+                        if constexpr (group_<opt_type>) {
+                            if constexpr (opt_type::mutually_exclusive) {
+                                auto const sub_opts = detail::make_opt_tuple(
+                                    detail::to_ref_tuple(opt.options));
+                                detail::dispatch<detail::opt_tuple_size<
+                                    decltype(sub_opts)>>(
+                                    location.sub_option, [&](auto j) {
+                                        parse_leaf_opt(i, sub_opts[j], (int)i);
+                                    });
+                            }
+                        } else {
+                            parse_leaf_opt(i, opt, -1);
+                        }
+                    });
+            } else {
+                // Otherwise, *first can only be the next positional.  A
+                // positional that may appear zero times can match without
+                // consuming anything, so keep going until some positional
+                // consumes *first, or we run out of them.
+                while (next_positional < (int)positionals.size()) {
+                    int const prev_next_positional = next_positional;
+                    detail::dispatch<positionals.size()>(
+                        next_positional, [&](auto p) {
+                            auto const i = hana::llong_c<positionals[p]>;
+                            parse_leaf_opt(i, opt_tuple[i], -1);
+                        });
+                    if (!parse_result || consumed_arg ||
+                        next_positional == prev_next_positional) {
+                        break;
                     }
-                } else {
-                    parse_leaf_opt(i, opt);
                 }
-
-                return i_plus_1;
-            });
+            }
 
             if (!parse_result)
                 return parse_result;
-            if (first == initial_first) {
+            if (!consumed_arg) {
                 if (final_parse_step) {
                     fail(parse_option_error::unknown_arg, *first);
                     return {
@@ -990,7 +1413,7 @@ namespace boost { namespace program_options_2 { namespace detail {
         Accessor accessor,
         int & next_positional,
         customizable_strings const & strings,
-        bool deserializing,
+        parse_mode mode,
         bool final_parse_step,
         std::basic_string_view<Char> argv0,
         ArgsIter & first,
@@ -1000,19 +1423,67 @@ namespace boost { namespace program_options_2 { namespace detail {
         std::basic_ostream<Char> & os,
         bool no_help,
         OptTuple const & opt_tuple,
+        name_index const & names,
+        name_index const & known_names,
         parse_contexts_vec const & parse_contexts,
         Options const &... opts)
     {
-        exclusives_map<Char> exclusives_seen;
+        exclusives_map<Char> exclusives_seen(mode.resource);
+        std::optional<response_file_cache> local_response_files;
+        if (!mode.buffers)
+            local_response_files.emplace(mode.resource);
+        response_file_cache & response_files =
+            mode.buffers ? detail::kept_response_file_cache(*mode.buffers)
+                         : *local_response_files;
 
         if (skip_first)
             ++first;
 
+        if (final_parse_step) {
+            auto flag_arg = [&](auto const & it) {
+                if (!detail::dashed_token(it, strings))
+                    return false;
+                auto const location =
+                    names.find_option(detail::make_string_view(*it), strings);
+                if (!location)
+                    return false;
+                bool retval = false;
+                detail::dispatch<detail::opt_tuple_size<OptTuple>>(
+                    location.option, [&](auto i) {
+                        auto const & opt = opt_tuple[i];
+                        using opt_type = std::remove_cvref_t<decltype(opt)>;
+                        if constexpr (group_<opt_type>) {
+                            if constexpr (opt_type::mutually_exclusive) {
+                                auto const sub_opts = detail::make_opt_tuple(
+                                    detail::to_ref_tuple(opt.options));
+                                detail::dispatch<detail::opt_tuple_size<
+                                    decltype(sub_opts)>>(
+                                    location.sub_option, [&](auto j) {
+                                        retval = sub_opts[j].args == 0;
+                                    });
+                            }
+                        } else {
+                            retval = opt.args == 0;
+                        }
+                    });
+                return retval;
+            };
+            detail::prefetch_response_files(
+                response_files,
+                mode.pool ? *mode.pool : detail::default_thread_pool(),
+                first,
+                last,
+                strings,
+                flag_arg);
+        }
+
         auto fail = [&](parse_option_error error,
                         std::basic_string_view<Char> cl_arg_or_opt_name,
                         std::basic_string_view<Char> opt_name = {}) {
-            if (deserializing)
+            if (!mode.exits()) {
+                mode.report(error, cl_arg_or_opt_name);
                 return;
+            }
             detail::print_parse_error(
                 strings, os, error, cl_arg_or_opt_name, opt_name);
             os << '\n';
@@ -1031,7 +1502,7 @@ namespace boost { namespace program_options_2 { namespace detail {
             accessor,
             next_positional,
             strings,
-            deserializing,
+            mode,
             final_parse_step,
             first,
             last,
@@ -1041,75 +1512,167 @@ namespace boost { namespace program_options_2 { namespace detail {
             no_help,
             fail,
             exclusives_seen,
-            -1,
+            response_files,
             opt_tuple,
+            names,
+            known_names,
             parse_contexts,
             opts...);
         if (!impl_result)
             return impl_result;
 
         // Partial sets of positionals are ok when deserializing.
-        if (!deserializing &&
+        if (!mode.deserializing &&
             next_positional < detail::count_positionals(opt_tuple)) {
-            std::basic_ostringstream<Char> oss;
+            std::basic_ostringstream<
+                Char,
+                std::char_traits<Char>,
+                std::pmr::polymorphic_allocator<Char>>
+                oss(std::ios_base::out, mode.resource);
             detail::print_uppercase(
                 oss,
                 detail::positional_name(opt_tuple, next_positional, strings));
-            fail(parse_option_error::missing_positional, oss.str());
+            fail(parse_option_error::missing_positional, oss.view());
+            return {
+                parse_option_result::stop_parsing,
+                parse_option_error::missing_positional};
         }
 
-        auto empty = [](auto const & result_i) {
-            using type = std::remove_cvref_t<decltype(result_i)>;
-            if constexpr (is_erased_type<type>::value) {
-                return program_options_2::any_empty(result_i);
-            } else {
-                return !result_i;
-            }
-        };
+        detail::assign_defaults(accessor, opt_tuple);
 
-        using namespace hana::literals;
+        return {
+            parse_option_result::match_keep_parsing, parse_option_error::none};
+    }
 
-        hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
-            auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
-            using opt_type = std::remove_cvref_t<decltype(opt)>;
-            if constexpr (!is_command<opt_type>::value) {
-                auto & result_i = accessor(opt, i);
-                using result_type = std::remove_cvref_t<decltype(result_i)>;
-                if constexpr (
-                    !opt_type::required && detail::has_default<opt_type>() &&
-                    !std::is_same_v<result_type, no_value>) {
-                    if (empty(result_i)) {
-                        detail::assign_or_insert<opt_type>(
-                            result_i, opt.default_value);
-                    }
-                }
-            }
-            return i_plus_1;
-        });
+    template<
+        typename Accessor,
+        typename Char,
+        typename ArgsIter,
+        typename OptTuple,
+        typename... Options>
+    parse_option_result parse_options_into(
+        Accessor accessor,
+        int & next_positional,
+        customizable_strings const & strings,
+        parse_mode mode,
+        bool final_parse_step,
+        std::basic_string_view<Char> argv0,
+        ArgsIter & first,
+        ArgsIter last,
+        bool skip_first,
+        std::basic_string_view<Char> program_desc,
+        std::basic_ostream<Char> & os,
+        bool no_help,
+        OptTuple const & opt_tuple,
+        parse_contexts_vec const & parse_contexts,
+        Options const &... opts)
+    {
+        auto const names = detail::make_name_index(opt_tuple);
+        auto const known_names = detail::make_known_names_index(opts...);
+        return detail::parse_options_into(
+            accessor,
+            next_positional,
+            strings,
+            mode,
+            final_parse_step,
+            argv0,
+            first,
+            last,
+            skip_first,
+            program_desc,
+            os,
+            no_help,
+            opt_tuple,
+            names,
+            known_names,
+            parse_contexts,
+            opts...);
+    }
 
-        return {
-            parse_option_result::match_keep_parsing, parse_option_error::none};
+    template<typename OptTuple, std::size_t... Is>
+    auto make_storage_names(
+        OptTuple const & opt_tuple,
+        customizable_strings const & strings,
+        std::index_sequence<Is...>)
+    {
+        auto storage_name = [&](auto const & opt) {
+            if constexpr (group_<std::remove_cvref_t<decltype(opt)>>)
+                return std::string_view();
+            else
+                return program_options_2::storage_name(opt, strings);
+        };
+        return std::array<std::string_view, sizeof...(Is)>{
+            storage_name(opt_tuple[hana::llong_c<Is>])...};
+    }
+
+    // Everything about a set of options that does not depend on the args
+    // being parsed.  This is computed once per parse by parse_command_line(),
+    // but only once ever by a parser.
+    template<typename... Options>
+    struct parse_tables
+    {
+        using opt_tuple_type = decltype(detail::make_opt_tuple(
+            std::declval<Options const &>()...));
+        using result_tuple_type = decltype(detail::make_result_tuple(
+            std::declval<Options const &>()...));
+
+        parse_tables(
+            customizable_strings const & strings, Options const &... opts) :
+            opt_tuple(detail::make_opt_tuple(opts...)),
+            result_tuple(detail::make_result_tuple(opts...)),
+            names(detail::make_name_index(opt_tuple)),
+            known_names(detail::make_known_names_index(opts...)),
+            storage_names(detail::make_storage_names(
+                opt_tuple,
+                strings,
+                std::make_index_sequence<opt_tuple_size<opt_tuple_type>>())),
+            help_names(detail::make_default_help_names_index(strings)),
+            no_help(detail::no_help_option(opts...))
+        {}
+
+        opt_tuple_type opt_tuple;
+        result_tuple_type result_tuple;
+        name_index names;
+        name_index known_names;
+        std::array<std::string_view, opt_tuple_size<opt_tuple_type>>
+            storage_names;
+        name_index help_names;
+        bool no_help;
+    };
+
+    // Classifies each of args once, up front, for use by the rest of the
+    // parse.
+    template<typename Args, typename... Options>
+    auto scan_args(
+        Args const & args,
+        customizable_strings const & strings,
+        parse_tables<Options...> const & tables,
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+    {
+        return detail::scan_args(
+            args, strings, tables.known_names, tables.help_names, resource);
     }
 
     template<typename Char, typename Args, typename... Options>
     auto parse_options_as_tuple(
+        parse_tables<Options...> const & tables,
         customizable_strings const & strings,
+        parse_mode mode,
         Args const & args,
         std::basic_string_view<Char> program_desc,
         std::basic_ostream<Char> & os,
-        bool no_help,
         Options const &... opts)
     {
-        auto result = detail::make_result_tuple(opts...);
+        auto result = tables.result_tuple;
         int next_positional = 0;
-        auto const opt_tuple = detail::make_opt_tuple(opts...);
 
         auto first = args.begin();
         auto const last = args.end();
 
         // This dance is here to support the case where the values returned by
         // args are temporaries -- args may have an underlying proxy iterator.
-        std::basic_string<Char> const argv0_str(first->begin(), first->end());
+        std::pmr::basic_string<Char> const argv0_str(
+            first->begin(), first->end(), mode.resource);
         std::basic_string_view<Char> argv0 = argv0_str;
 
         parse_contexts_vec const parse_contexts;
@@ -1119,7 +1682,7 @@ namespace boost { namespace program_options_2 { namespace detail {
             },
             next_positional,
             strings,
-            false,
+            mode,
             true,
             argv0,
             first,
@@ -1127,63 +1690,221 @@ namespace boost { namespace program_options_2 { namespace detail {
             true,
             program_desc,
             os,
-            no_help,
-            opt_tuple,
+            tables.no_help,
+            tables.opt_tuple,
+            tables.names,
+            tables.known_names,
             parse_contexts,
             opts...);
         return result;
     }
 
-    template<typename Map, typename Key = map_key_t<Map>>
-    struct map_lookup;
+    template<typename Char, typename Args, typename... Options>
+    auto parse_options_as_tuple(
+        customizable_strings const & strings,
+        Args const & args,
+        std::basic_string_view<Char> program_desc,
+        std::basic_ostream<Char> & os,
+        bool no_help,
+        Options const &... opts)
+    {
+        parse_tables<Options...> const tables(strings, opts...);
+        BOOST_ASSERT(tables.no_help == no_help);
+        return detail::parse_options_as_tuple(
+            tables,
+            strings,
+            parse_mode(),
+            detail::scan_args(args, strings, tables),
+            program_desc,
+            os,
+            opts...);
+    }
+
+    template<typename Args, typename... Options>
+    auto try_parse_options_as_tuple(
+        parse_tables<Options...> const & tables,
+        customizable_strings const & strings,
+        Args const & args,
+        thread_pool * pool,
+        Options const &... opts)
+    {
+        using result_tuple_type =
+            typename parse_tables<Options...>::result_tuple_type;
+        parse_result<result_tuple_type> retval;
+        auto const scanned = detail::scan_args(args, strings, tables);
+        if (tables.no_help && scanned.contains_default_help()) {
+            retval.help_requested = true;
+            return retval;
+        }
+        std::ostream null_os(nullptr);
+        parse_mode mode(retval);
+        mode.pool = pool;
+        retval.value = detail::parse_options_as_tuple(
+            tables,
+            strings,
+            mode,
+            scanned,
+            std::string_view(),
+            null_os,
+            opts...);
+        return retval;
+    }
 
-    template<typename Map>
-    struct map_lookup<Map, std::string>
+    template<typename OptTuple>
+    using storage_names_t =
+        std::array<std::string_view, opt_tuple_size<OptTuple>>;
+
+    // Looks up the value for each option in OptTuple in Map.  The storage
+    // names of the options are computed once, on construction, so that a
+    // lookup does no name parsing.  When Map's key is std::string_view, or
+    // Map can find a std::string key by std::string_view (as with
+    // std::less<> or a transparent hash), a lookup of an existing value
+    // does no allocation either.  Otherwise, the key is copied into a
+    // reused std::string first.
+    template<typename Map, typename OptTuple>
+    struct map_lookup
     {
-        map_lookup(Map & m, customizable_strings const & strings) :
-            m_(m), strings_(strings)
+        map_lookup(
+            Map & m,
+            customizable_strings const & strings,
+            OptTuple const & opt_tuple) :
+            m_(m),
+            strings_(strings),
+            names_(detail::make_storage_names(
+                opt_tuple,
+                strings,
+                std::make_index_sequence<opt_tuple_size<OptTuple>>()))
+        {}
+        map_lookup(
+            Map & m,
+            customizable_strings const & strings,
+            storage_names_t<OptTuple> const & names) :
+            m_(m), strings_(strings), names_(names)
         {}
-        template<typename Option>
-        auto find(Option const & opt)
+        template<typename Option, long long I>
+        auto find(Option const & opt, hana::llong<I> i)
         {
-            scratch_ = program_options_2::storage_name(opt, strings_);
-            return m_.find(scratch_);
+            auto const key = name(opt, i);
+            if constexpr (heterogeneous_options_map<std::remove_const_t<Map>>) {
+                return m_.find(key);
+            } else {
+                scratch_ = key;
+                return m_.find(scratch_);
+            }
         }
         template<typename Option, long long I>
-        decltype(auto) operator()(Option const & opt, hana::llong<I>)
+        auto & operator()(Option const & opt, hana::llong<I> i)
+        {
+            auto const key = name(opt, i);
+            if constexpr (std::is_same_v<map_key_t<Map>, std::string_view>) {
+                return m_[key];
+            } else if constexpr (heterogeneous_options_map<Map>) {
+                auto const it = m_.find(key);
+                if (it != m_.end())
+                    return it->second;
+                return m_[std::string(key)];
+            } else {
+                scratch_ = key;
+                return m_[scratch_];
+            }
+        }
+        // Returns the value for opt, or nullptr if it has none.
+        template<typename T, typename Option, long long I>
+        T const * value(Option const & opt, hana::llong<I> i)
         {
-            scratch_ = program_options_2::storage_name(opt, strings_);
-            return m_[scratch_];
+            auto const it = find(opt, i);
+            if (it == m_.end() || program_options_2::any_empty(it->second))
+                return nullptr;
+            return &program_options_2::any_cast<T const &>(it->second);
         }
 
     private:
+        template<typename Option, long long I>
+        std::string_view name(Option const & opt, hana::llong<I>) const
+        {
+            if constexpr (std::is_same_v<
+                              Option,
+                              opt_tuple_element_t<OptTuple, I>>) {
+                return names_[I];
+            } else {
+                // Options within a mutually exclusive group have no
+                // precomputed storage name.
+                return program_options_2::storage_name(opt, strings_);
+            }
+        }
+
         Map & m_;
-        std::string scratch_;
         customizable_strings const & strings_;
+        storage_names_t<OptTuple> names_;
+        std::string scratch_;
     };
 
-    template<typename Map>
-    struct map_lookup<Map, std::string_view>
+    // Like map_lookup, but for a typed_options, in which the value for the
+    // option at index I of the opt-tuple is element I of its values.  A
+    // slot that is not a std::optional always holds a value, so whether it
+    // has been assigned is tracked separately, in the typed_options'
+    // present_ bits.
+    template<typename TypedOptions>
+    struct typed_lookup
     {
-        map_lookup(Map & m, customizable_strings const & strings) :
-            m_(m), strings_(strings)
+        template<typename OptTuple>
+        typed_lookup(
+            TypedOptions & t, customizable_strings const &, OptTuple const &) :
+            t_(t)
         {}
-        template<typename Option>
-        auto find(Option const & opt)
+        template<typename Option, long long I>
+        decltype(auto) operator()(Option const &, hana::llong<I> i)
         {
-            return m_.find(program_options_2::storage_name(opt, strings_));
+            using opt_tuple_type =
+                typename std::remove_const_t<TypedOptions>::opt_tuple_type;
+            static_assert(
+                std::is_same_v<Option, opt_tuple_element_t<opt_tuple_type, I>>,
+                "The options used with a typed_options must be the same "
+                "options that it was made from.");
+            return t_.values[i];
         }
-        template<typename Option, long long I>
-        decltype(auto) operator()(Option const & opt, hana::llong<I>)
+        template<long long I>
+        void assigned(hana::llong<I>) requires(!std::is_const_v<TypedOptions>)
         {
-            return m_[program_options_2::storage_name(opt, strings_)];
+            t_.present_.set(I);
+        }
+        // Returns the value for opt, or nullptr if it has none.
+        template<typename T, typename Option, long long I>
+        T const * value(Option const & opt, hana::llong<I> i)
+        {
+            auto const & result = (*this)(opt, i);
+            using result_type = std::remove_cvref_t<decltype(result)>;
+            if constexpr (std::is_same_v<result_type, no_value>)
+                return nullptr;
+            else if constexpr (is_optional<result_type>::value)
+                return result ? &*result : nullptr;
+            else
+                return t_.present_[I] ? &result : nullptr;
         }
 
     private:
-        Map & m_;
-        customizable_strings const & strings_;
+        TypedOptions & t_;
+    };
+
+    template<typename Storage, typename OptTuple, bool Typed>
+    struct storage_lookup_impl
+    {
+        using type = map_lookup<Storage, OptTuple>;
+    };
+    template<typename Storage, typename OptTuple>
+    struct storage_lookup_impl<Storage, OptTuple, true>
+    {
+        using type = typed_lookup<Storage>;
     };
 
+    // The lookup for the options in OptTuple in Storage, which is an
+    // options map or a typed_options.
+    template<typename Storage, typename OptTuple>
+    using storage_lookup = typename storage_lookup_impl<
+        Storage,
+        OptTuple,
+        is_typed_options<std::remove_const_t<Storage>>::value>::type;
+
     template<typename OptionsMap>
     void parse_into_map_cleanup(OptionsMap & map)
     {
@@ -1201,6 +1922,114 @@ namespace boost { namespace program_options_2 { namespace detail {
         }
     }
 
+    // Removes the empty elements of storage, if it is a map.  A
+    // typed_options has an element for every option, empty or not; instead,
+    // the response file contents its values no longer refer to are
+    // released.
+    template<typename Storage>
+    void storage_cleanup(Storage & storage)
+    {
+        if constexpr (!is_typed_options<Storage>::value) {
+            detail::parse_into_map_cleanup(storage);
+        } else {
+            detail::release_unreferenced_response_files(
+                storage.response_files, storage.values);
+        }
+    }
+
+    template<
+        typename OptionsMap,
+        typename Char,
+        typename Args,
+        typename... Options>
+    parse_option_result parse_options_into_map(
+        parse_tables<Options...> const & tables,
+        OptionsMap & result,
+        customizable_strings const & strings,
+        parse_mode mode,
+        Args const & args,
+        std::basic_string_view<Char> program_desc,
+        std::basic_ostream<Char> & os,
+        Options const &... opts)
+    {
+        if constexpr (is_typed_options<OptionsMap>::value)
+            mode.buffers = &result.response_files;
+        int next_positional = 0;
+
+        auto first = args.begin();
+        auto const last = args.end();
+
+        // This dance is here to support the case where the values returned by
+        // args are temporaries -- args may have an underlying proxy iterator.
+        std::pmr::basic_string<Char> const argv0_str(
+            first->begin(), first->end(), mode.resource);
+        std::basic_string_view<Char> argv0 = argv0_str;
+
+        auto lookup = [&] {
+            if constexpr (is_typed_options<OptionsMap>::value) {
+                return typed_lookup<OptionsMap>(
+                    result, strings, tables.opt_tuple);
+            } else {
+                return map_lookup<
+                    OptionsMap,
+                    typename parse_tables<Options...>::opt_tuple_type>(
+                    result, strings, tables.storage_names);
+            }
+        };
+
+        parse_contexts_vec const parse_contexts;
+        auto const retval = detail::parse_options_into(
+            lookup(),
+            next_positional,
+            strings,
+            mode,
+            true,
+            argv0,
+            first,
+            last,
+            true,
+            program_desc,
+            os,
+            tables.no_help,
+            tables.opt_tuple,
+            tables.names,
+            tables.known_names,
+            parse_contexts,
+            opts...);
+        detail::storage_cleanup(result);
+        return retval;
+    }
+
+    template<typename OptionsMap, typename Args, typename... Options>
+    parse_status try_parse_options_into_map(
+        parse_tables<Options...> const & tables,
+        OptionsMap & result,
+        customizable_strings const & strings,
+        Args const & args,
+        parse_mode mode,
+        Options const &... opts)
+    {
+        parse_status retval;
+        auto const scanned =
+            detail::scan_args(args, strings, tables, mode.resource);
+        if (tables.no_help && scanned.contains_default_help()) {
+            retval.help_requested = true;
+            return retval;
+        }
+        std::ostream null_os(nullptr);
+        mode.status = &retval;
+        detail::parse_options_into_map(
+            tables,
+            result,
+            strings,
+            mode,
+            scanned,
+            std::string_view(),
+            null_os,
+            opts...);
+        return retval;
+    }
+
     template<
         typename OptionsMap,
         typename Char,
@@ -1217,6 +2046,9 @@ namespace boost { namespace program_options_2 { namespace detail {
         bool skip_first,
         Options const &... opts)
     {
+        parse_mode mode(deserializing);
+        if constexpr (is_typed_options<OptionsMap>::value)
+            mode.buffers = &result.response_files;
         int next_positional = 0;
         auto const opt_tuple = detail::make_opt_tuple(opts...);
 
@@ -1225,15 +2057,19 @@ namespace boost { namespace program_options_2 { namespace detail {
 
         // This dance is here to support the case where the values returned by
         // args are temporaries -- args may have an underlying proxy iterator.
-        std::basic_string<Char> const argv0_str(first->begin(), first->end());
+        // args may be empty, as when it is the contents of an empty file.
+        std::pmr::basic_string<Char> argv0_str(mode.resource);
+        if (first != last)
+            argv0_str.assign(first->begin(), first->end());
         std::basic_string_view<Char> argv0 = argv0_str;
 
         parse_contexts_vec const parse_contexts;
         auto const retval = detail::parse_options_into(
-            map_lookup<OptionsMap>(result, strings),
+            storage_lookup<OptionsMap, decltype(opt_tuple)>(
+                result, strings, opt_tuple),
             next_positional,
             strings,
-            deserializing,
+            mode,
             true,
             argv0,
             first,
@@ -1245,231 +2081,395 @@ namespace boost { namespace program_options_2 { namespace detail {
             opt_tuple,
             parse_contexts,
             opts...);
-        detail::parse_into_map_cleanup(result);
+        detail::storage_cleanup(result);
         return retval;
     }
 
 #define BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING 0
 
+    // The names of the commands at each level of a tree of commands, like
+    // parse_tables for options: built once per parse by
+    // parse_command_line(), but only once ever by a parser.  Level 0 holds
+    // the top-level commands, and each command that has subcommands refers
+    // to the level that holds them.  A command's location in its level's
+    // names is the index of the command among the commands of that level.
+    struct command_tables
+    {
+        template<typename... Options>
+        explicit command_tables(
+            customizable_strings const & strings, Options const &... opts);
+
+        struct level
+        {
+            name_index names;
+            // For each command at this level, the level of its
+            // subcommands, or -1 if it has none.
+            std::vector<int> subcommands;
+        };
+
+        std::vector<level> levels;
+    };
+
+    // Everything about a single call to parse_commands() that the parse and
+    // print functions of its cmd_parse_ctxs need.
     template<
+        typename OptionsMap,
         typename Char,
         typename ArgsIter,
-        typename OptionsMap,
-        typename... Options,
-        typename... Options2>
-    parse_option_result parse_commands_in_tuple(
-        OptionsMap & map,
-        customizable_strings const & strings,
-        names_view help_names_view,
-        std::basic_string_view<Char> argv0,
-        ArgsIter & first,
-        ArgsIter last,
-        std::basic_string_view<Char> program_desc,
-        std::basic_ostream<Char> & os,
-        bool no_help,
-        hana::tuple<Options...> const & opt_tuple,
-        parse_contexts_vec & parse_contexts,
-        std::function<void()> & func,
-        Options2 const &... opts)
+        typename... Options>
+    struct command_parse_state
     {
-        if (first == last) {
-            return {
-                parse_option_result::stop_parsing,
-                parse_option_error::expected_command};
+        using map_type = OptionsMap;
+
+        OptionsMap & map;
+        customizable_strings const & strings;
+        parse_mode mode;
+        names_view help_names_view;
+        std::basic_string_view<Char> argv0;
+        ArgsIter & first;
+        ArgsIter last;
+        std::basic_string_view<Char> program_desc;
+        std::basic_ostream<Char> & os;
+        bool no_help;
+        parse_contexts_vec & parse_contexts;
+        hana::tuple<Options const &...> opts;
+        command_tables const & command_names;
+        // The level of command_names that holds the commands to be matched
+        // next.
+        int level = 0;
+        // The invocable of the matched command, and that command.
+        void (*invoke)(void const *, OptionsMap &) = nullptr;
+        void const * invoked_command = nullptr;
+    };
+
+    template<typename... Options>
+    auto command_ptrs(Options const &... opts);
+
+    template<typename Option>
+    auto command_ptrs_impl(Option const & opt)
+    {
+        if constexpr (group_<Option>) {
+            if constexpr (Option::subcommand) {
+                return hana::make_tuple(&opt);
+            } else if constexpr (!Option::mutually_exclusive) {
+                return hana::unpack(opt.options, [](auto const &... opts) {
+                    return detail::command_ptrs(opts...);
+                });
+            } else {
+                return hana::tuple<>{};
+            }
+        } else {
+            return hana::tuple<>{};
         }
+    }
 
-#if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-        std::cout << "parse_commands_in_tuple(): matching arg '" << *first
-                  << "'" << std::endl;
-#endif
+    // Returns pointers to the commands at the level of opts, looking through
+    // any groups that are not commands, as make_opt_tuple() does.  The
+    // pointers refer to the given options, not to copies, so they remain
+    // valid for the whole parse.
+    template<typename... Options>
+    auto command_ptrs(Options const &... opts)
+    {
+        return hana::flatten(
+            hana::make_tuple(detail::command_ptrs_impl(opts)...));
+    }
+
+    template<typename... Options>
+    int add_command_level(command_tables & tables, Options const &... opts)
+    {
+        int const retval = (int)tables.levels.size();
+        tables.levels.emplace_back();
+        auto const commands = detail::command_ptrs(opts...);
+        int i = 0;
+        hana::for_each(commands, [&](auto const * cmd) {
+            for (auto name : names_view(cmd->names)) {
+                tables.levels[retval].names.insert(name, {i, -1});
+            }
+            ++i;
+        });
+        hana::for_each(commands, [&](auto const * cmd) {
+            int const subcommands =
+                hana::unpack(cmd->options, [&](auto const &... sub_opts) {
+                    if constexpr (detail::contains_commands<
+                                      decltype(sub_opts)...>()) {
+                        return detail::add_command_level(tables, sub_opts...);
+                    } else {
+                        return -1;
+                    }
+                });
+            tables.levels[retval].subcommands.push_back(subcommands);
+        });
+        return retval;
+    }
 
-        auto const & arg = *first;
+    template<typename... Options>
+    command_tables::command_tables(
+        customizable_strings const &, Options const &... opts)
+    {
+        detail::add_command_level(*this, opts...);
+    }
 
-        if (detail::matches_view(arg, help_names_view)) {
-#if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-            std::cout << "parse_commands_in_tuple(): "
-                         "detail::print_help_for_command_and_exit()"
-                      << std::endl;
-#endif
+    template<bool ForPrinting, typename Command, typename State>
+    auto context_opt_tuple(State const & state, cmd_parse_ctx const & ctx)
+    {
+        auto opts = [&] {
+            if constexpr (std::is_void_v<Command>) {
+                return state.opts;
+            } else {
+                return detail::to_ref_tuple(
+                    static_cast<Command const *>(ctx.command_)->options);
+            }
+        }();
+        return detail::make_opt_tuple_impl<ForPrinting, false>(
+            std::move(opts));
+    }
+
+    // The cmd_parse_ctx operations for the context of a Command, or for the
+    // top-level context if Command is void.
+
+    template<typename State, typename Command>
+    parse_option_result
+    parse_command_context(cmd_parse_ctx const & ctx, int & next_positional)
+    {
+        auto const & state = *static_cast<State const *>(ctx.state_);
+        auto const opt_tuple =
+            detail::context_opt_tuple<false, Command>(state, ctx);
+        return hana::unpack(state.opts, [&](auto const &... opts) {
+            return detail::parse_options_into(
+                map_lookup<typename State::map_type, decltype(opt_tuple)>(
+                    state.map, state.strings, opt_tuple),
+                next_positional,
+                state.strings,
+                state.mode,
+                !std::is_void_v<Command> && !ctx.has_subcommands_,
+                state.argv0,
+                state.first,
+                state.last,
+                false,
+                state.program_desc,
+                state.os,
+                state.no_help,
+                opt_tuple,
+                state.parse_contexts,
+                opts...);
+        });
+    }
+
+    template<typename State, typename Command>
+    int print_command_synopsis(
+        cmd_parse_ctx const & ctx,
+        std::ostringstream & os,
+        int first_column,
+        int current_width)
+    {
+        auto const & state = *static_cast<State const *>(ctx.state_);
+        hana::for_each(
+            detail::context_opt_tuple<false, Command>(state, ctx),
+            [&](auto const & opt) {
+                current_width = detail::print_option(
+                    state.strings, os, opt, first_column, current_width);
+            });
+        return current_width;
+    }
+
+    template<typename State, typename Command>
+    void print_command_post_synopsis(
+        cmd_parse_ctx const & ctx,
+        bool print_commands,
+        all_printed_sections & printed_sections,
+        int & max_option_length,
+        bool & commands_printed)
+    {
+        auto const & state = *static_cast<State const *>(ctx.state_);
+        hana::for_each(
+            detail::context_opt_tuple<true, Command>(state, ctx),
+            [&](auto const & opt) {
+                detail::print_post_synopsis_option(
+                    state.argv0,
+                    state.strings,
+                    opt,
+                    print_commands,
+                    printed_sections,
+                    max_option_length,
+                    commands_printed);
+            });
+    }
+
+    template<typename State, typename Command>
+    cmd_parse_ctx make_command_context(
+        State const & state,
+        Command const * command,
+        std::string_view name_used,
+        std::string_view help_text,
+        std::string_view commands_synopsis_text,
+        bool has_subcommands)
+    {
+        return {
+            name_used,
+            help_text,
+            &state,
+            command,
+            &detail::parse_command_context<State, Command>,
+            &detail::print_command_synopsis<State, Command>,
+            &detail::print_command_post_synopsis<State, Command>,
+            commands_synopsis_text,
+            has_subcommands};
+    }
+
+    template<typename Command, typename OptionsMap>
+    void invoke_command(void const * command, OptionsMap & map)
+    {
+        auto f = static_cast<Command const *>(command)->func;
+        f(map);
+    }
+
+    template<typename State>
+    parse_option_result help_requested(State & state)
+    {
+        if (!state.mode.exits()) {
+            if (state.mode.status)
+                state.mode.status->help_requested = true;
+            return {parse_option_result::stop_parsing};
+        }
+        hana::unpack(state.opts, [&](auto const &... opts) {
             detail::print_help_and_exit(
                 0,
-                strings,
-                argv0,
-                program_desc,
-                os,
-                no_help,
-                parse_contexts,
+                state.strings,
+                state.argv0,
+                state.program_desc,
+                state.os,
+                state.no_help,
+                state.parse_contexts,
                 opts...);
-        }
+        });
+        return {};
+    }
 
-        bool matched_command = false;
-        parse_option_result child_result;
-        hana::for_each(opt_tuple, [&]<typename Option>(Option const & opt) {
-            if (matched_command)
-                return;
+    template<typename State, typename... Options>
+    parse_option_result
+    parse_commands_in_tuple(State & state, Options const &... opts);
 
-            if constexpr (group_<Option>) {
-                if constexpr (opt.subcommand) {
-#if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-                    std::cout << "parse_commands_in_tuple(): at subcommand '"
-                              << opt.names << "'" << std::endl;
-#endif
-                    if (detail::matches_names(arg, opt.names)) {
-                        matched_command = true;
-                        ++first;
-#if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-                        std::cout << "parse_commands_in_tuple(): it's a match!"
-                                  << std::endl;
-#endif
+    // Pushes the context for the I-th command in commands, which has just
+    // been matched, and continues into its subcommands, if any.
+    template<std::size_t I, typename State, typename Commands>
+    parse_option_result enter_command(State & state, Commands const & commands)
+    {
+        auto const & cmd = *hana::at_c<I>(commands);
+        using command_type = std::remove_cvref_t<decltype(cmd)>;
+
+        std::string_view name_used;
+        for (auto name : names_view(cmd.names)) {
+            if (detail::transcoded_equal(*state.first, name)) {
+                name_used = name;
+                break;
+            }
+        }
+        ++state.first;
 
-                        auto options_tuple = detail::make_opt_tuple(
-                            detail::to_ref_tuple(opt.options));
-                        auto printing_options_tuple =
-                            detail::make_opt_tuple_for_printing(
-                                detail::to_ref_tuple(opt.options));
-                        bool const has_subcommands_ =
-                            detail::contains_commands(options_tuple);
-                        auto const utf_arg = text::as_utf8(arg);
-                        parse_contexts.push_back(
-                            {text::to_string(text::as_utf32(arg)),
-                             opt.help_text,
-                             [&,
-                              argv0,
-                              last,
-                              program_desc,
-                              no_help,
-                              options_tuple,
-                              has_subcommands_](int & next_positional) {
-                                 return detail::parse_options_into(
-                                     map_lookup<OptionsMap>(map, strings),
-                                     next_positional,
-                                     strings,
-                                     false,
-                                     !has_subcommands_,
-                                     argv0,
-                                     first,
-                                     last,
-                                     false,
-                                     program_desc,
-                                     os,
-                                     no_help,
-                                     options_tuple,
-                                     parse_contexts,
-                                     opts...);
-                             },
-                             [&strings, options_tuple](
-                                 std::ostringstream & oss,
-                                 int first_column,
-                                 int current_width) {
-                                 hana::for_each(
-                                     options_tuple, [&](auto const & opt) {
-                                         current_width = detail::print_option(
-                                             strings,
-                                             oss,
-                                             opt,
-                                             first_column,
-                                             current_width);
-                                     });
-                                 return current_width;
-                             },
-                             [argv0,
-                              &strings,
-                              opt_tuple = printing_options_tuple](
-                                 bool print_commands,
-                                 all_printed_sections & printed_sections,
-                                 int & max_option_length,
-                                 bool & commands_printed) {
-                                 hana::for_each(
-                                     opt_tuple, [&](auto const & opt) {
-                                         detail::print_post_synopsis_option(
-                                             argv0,
-                                             strings,
-                                             opt,
-                                             print_commands,
-                                             printed_sections,
-                                             max_option_length,
-                                             commands_printed);
-                                     });
-                             },
-                             has_subcommands_
-                                 ? std::string(
-                                       strings.next_subcommand_placeholder_text)
-                                 : std::string(),
-                             has_subcommands_});
-                        if (parse_contexts.size() == 2u && has_subcommands_) {
-                            // To prevent the top-level context from needed to
-                            // recurse into the first-level commands to
-                            // determine if there are second-level commands,
-                            // we wait until now to use that knowledge to
-                            // adjust the COMMAND... text
-                            parse_contexts[0].commands_synopsis_text_ += ' ';
-                            parse_contexts[0].commands_synopsis_text_ +=
-                                strings.next_subcommand_placeholder_text;
-                        }
+        bool const has_subcommands =
+            hana::unpack(cmd.options, [](auto const &... opts) {
+                return detail::contains_commands<decltype(opts)...>();
+            });
+        state.parse_contexts.push_back(detail::make_command_context(
+            state,
+            &cmd,
+            name_used,
+            cmd.help_text,
+            has_subcommands ? state.strings.next_subcommand_placeholder_text
+                            : std::string_view(),
+            has_subcommands));
+        if (state.parse_contexts.size() == 2u && has_subcommands) {
+            // To prevent the top-level context from needed to recurse into
+            // the first-level commands to determine if there are
+            // second-level commands, we wait until now to use that knowledge
+            // to adjust the COMMAND... text
+            state.parse_contexts[0].nested_commands_ = true;
+        }
 #if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-                        std::cout << "parse_commands_in_tuple(): "
-                                     "parse_contexts.size()="
-                                  << parse_contexts.size() << std::endl;
+        std::cout << "enter_command(): matched '" << name_used
+                  << "'; parse_contexts.size()=" << state.parse_contexts.size()
+                  << std::endl;
 #endif
-                        if constexpr (opt.has_func) {
-                            func = [&map, f = opt.func]() { f(map); };
-                        }
-                        if (!func) {
-                            auto opt_tuple = hana::unpack(
-                                opt.options, [](auto const &... opts2) {
-                                    return detail::make_opt_tuple(opts2...);
-                                });
-                            child_result = detail::parse_commands_in_tuple(
-                                map,
-                                strings,
-                                help_names_view,
-                                argv0,
-                                first,
-                                last,
-                                program_desc,
-                                os,
-                                no_help,
-                                opt_tuple,
-                                parse_contexts,
-                                func,
-                                opts...);
-                        }
-                    }
+
+        if constexpr (command_type::has_func) {
+            state.invoke =
+                &detail::invoke_command<command_type, typename State::map_type>;
+            state.invoked_command = &cmd;
+        }
+        if (state.invoke)
+            return {};
+        state.level =
+            state.command_names.levels[state.level].subcommands[I];
+        return hana::unpack(cmd.options, [&](auto const &... opts) {
+            return detail::parse_commands_in_tuple(state, opts...);
+        });
+    }
+
+    template<typename State, typename Commands, std::size_t... Is>
+    constexpr auto command_dispatch_table(std::index_sequence<Is...>)
+    {
+        using enter_command_fn =
+            parse_option_result (*)(State &, Commands const &);
+        return std::array<enter_command_fn, sizeof...(Is)>{
+            {&detail::enter_command<Is, State, Commands>...}};
+    }
+
+    // Matches the next arg against the commands at the level of opts, with
+    // a single lookup in that level's names in state.command_names, and
+    // enters the matched command through a table of function pointers
+    // generated for this level.
+    template<typename State, typename... Options>
+    parse_option_result
+    parse_commands_in_tuple(State & state, Options const &... opts)
+    {
+        if (state.first == state.last) {
+            return {
+                parse_option_result::stop_parsing,
+                parse_option_error::expected_command};
+        }
+
 #if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-                    else
-                        std::cout << "parse_commands_in_tuple(): no match"
-                                  << std::endl;
+        std::cout << "parse_commands_in_tuple(): matching arg '"
+                  << *state.first << "'" << std::endl;
 #endif
-                }
+
+        if (detail::matches_view(*state.first, state.help_names_view))
+            return detail::help_requested(state);
+
+        bool matched_command = false;
+        parse_option_result child_result;
+        auto const commands = detail::command_ptrs(opts...);
+        using commands_type = std::remove_const_t<decltype(commands)>;
+        constexpr std::size_t num_commands =
+            decltype(hana::length(commands))::value;
+        if constexpr (num_commands != 0u) {
+            BOOST_ASSERT(0 <= state.level);
+            int const match =
+                state.command_names.levels[state.level]
+                    .names.find(detail::make_string_view(*state.first))
+                    .option;
+            if (0 <= match) {
+                static constexpr auto dispatch =
+                    detail::command_dispatch_table<State, commands_type>(
+                        std::make_index_sequence<num_commands>());
+                matched_command = true;
+                child_result = dispatch[match](state, commands);
             }
-        });
+        }
 
         // Special case: if this is the context of a leaf command, and there
         // is no help anywhere in the options, try to match the default help
         // option.
-        if (no_help && !parse_contexts.back().has_subcommands_ &&
-            detail::argv_contains_default_help_flag(
-                strings, std::ranges::subrange(first, last))) {
-#if BOOST_PROGRAM_OPTIONS_2_INSTRUMENT_COMMAND_PARSING
-            std::cout << "parse_commands_in_tuple(): "
-                         "detail::print_help_for_command_and_exit()"
-                      << std::endl;
-#endif
-            detail::print_help_and_exit(
-                0,
-                strings,
-                argv0,
-                program_desc,
-                os,
-                no_help,
-                parse_contexts,
-                opts...);
+        if (state.no_help && !state.parse_contexts.back().has_subcommands_ &&
+            detail::contains_default_help_flag(
+                state.first, state.last, state.strings)) {
+            return detail::help_requested(state);
         }
 
         if (!child_result)
             return child_result;
 
-        if (!matched_command || !func) {
+        if (!matched_command || !state.invoke) {
             return {
                 parse_option_result::stop_parsing,
                 parse_option_error::expected_command};
@@ -1484,16 +2484,16 @@ namespace boost { namespace program_options_2 { namespace detail {
         typename Char,
         typename... Options>
     void parse_commands(
+        command_tables const & command_names,
         OptionsMap & map,
         customizable_strings const & strings,
+        parse_mode mode,
         Args const & args,
         std::basic_string_view<Char> program_desc,
         std::basic_ostream<Char> & os,
         bool skip_first,
         Options const &... opts)
     {
-        auto opt_tuple = detail::make_opt_tuple(opts...);
-
         auto const default_help_names_view =
             names_view(strings.default_help_names);
         auto const opt_names_view = detail::help_option(opts...);
@@ -1501,77 +2501,34 @@ namespace boost { namespace program_options_2 { namespace detail {
             opt_names_view ? *opt_names_view : default_help_names_view;
         bool const no_help = !opt_names_view;
 
-        auto first = args.begin();
-        auto const last = args.end();
+        auto const scanned = detail::scan_args(
+            args,
+            strings,
+            detail::make_known_names_index(opts...),
+            detail::make_default_help_names_index(strings));
+        auto first = scanned.begin();
+        auto const last = scanned.end();
 
         // This dance is here to support the case where the values returned by
         // args are temporaries -- args may have an underlying proxy iterator.
-        std::basic_string<Char> const argv0_str(first->begin(), first->end());
+        std::pmr::basic_string<Char> const argv0_str(
+            first->begin(), first->end(), mode.resource);
         std::basic_string_view<Char> argv0 = argv0_str;
 
         if (skip_first)
             ++first;
 
-        std::function<void()> func;
         parse_contexts_vec parse_contexts;
 
-        auto printing_options_tuple =
-            detail::make_opt_tuple_for_printing(opts...);
-
-        // This is the top-level context, outsided any commands.
-        parse_contexts.push_back(
-            {std::string{},
-             std::string_view{},
-             [&, argv0, last, program_desc, no_help](int & next_positional) {
-                 return detail::parse_options_into(
-                     map_lookup<OptionsMap>(map, strings),
-                     next_positional,
-                     strings,
-                     false,
-                     false,
-                     argv0,
-                     first,
-                     last,
-                     false,
-                     program_desc,
-                     os,
-                     no_help,
-                     opt_tuple,
-                     parse_contexts,
-                     opts...);
-             },
-             [&strings, &opt_tuple](
-                 std::ostringstream & oss,
-                 int first_column,
-                 int current_width) {
-                 hana::for_each(opt_tuple, [&](auto const & opt) {
-                     current_width = detail::print_option(
-                         strings, oss, opt, first_column, current_width);
-                 });
-                 return current_width;
-             },
-             [argv0, &strings, &opt_tuple = printing_options_tuple](
-                 bool print_commands,
-                 all_printed_sections & printed_sections,
-                 int & max_option_length,
-                 bool & commands_printed) {
-                 hana::for_each(opt_tuple, [&](auto const & opt) {
-                     detail::print_post_synopsis_option(
-                         argv0,
-                         strings,
-                         opt,
-                         print_commands,
-                         printed_sections,
-                         max_option_length,
-                         commands_printed);
-                 });
-             },
-             std::string(strings.top_subcommand_placeholder_text),
-             detail::contains_commands<Options...>()});
-
-        parse_option_result parse_result = detail::parse_commands_in_tuple(
+        using state_type = command_parse_state<
+            OptionsMap,
+            Char,
+            std::remove_cvref_t<decltype(first)>,
+            Options...>;
+        state_type state{
             map,
             strings,
+            mode,
             help_names_view,
             argv0,
             first,
@@ -1579,17 +2536,33 @@ namespace boost { namespace program_options_2 { namespace detail {
             program_desc,
             os,
             no_help,
-            opt_tuple,
             parse_contexts,
-            func,
-            opts...);
+            hana::tuple<Options const &...>{opts...},
+            command_names};
 
+        // This is the top-level context, outsided any commands.
+        parse_contexts.push_back(detail::make_command_context(
+            state,
+            (void const *)nullptr,
+            std::string_view(),
+            std::string_view(),
+            strings.top_subcommand_placeholder_text,
+            detail::contains_commands<Options...>()));
+
+        parse_option_result parse_result =
+            detail::parse_commands_in_tuple(state, opts...);
+
+        // state.first refers to first, so any failure is reported with the
+        // arg on which the command parse stopped, if there is one.
         auto fail = [&] {
-            detail::print_parse_error(
-                strings,
-                os,
-                parse_result.error,
-                std::basic_string_view<Char>());
+            std::basic_string_view<Char> token;
+            if (first != last)
+                token = detail::make_string_view(*first);
+            if (!mode.exits()) {
+                mode.report(parse_result.error, token);
+                return;
+            }
+            detail::print_parse_error(strings, os, parse_result.error, token);
             os << '\n';
             detail::print_help_and_exit(
                 1,
@@ -1602,19 +2575,50 @@ namespace boost { namespace program_options_2 { namespace detail {
                 opts...);
         };
 
-        if (!parse_result)
-            fail();
-
-        int next_positional = 0;
-        for (auto const & ctx : parse_contexts) {
-            parse_result = ctx.parse_(next_positional);
-            if (!parse_result)
+        if (!parse_result) {
+            if (parse_result.error != parse_option_error::none)
                 fail();
+        } else {
+            int next_positional = 0;
+            for (auto const & ctx : parse_contexts) {
+                parse_result = ctx.parse(next_positional);
+                // Any error has already been reported by ctx.parse().
+                if (!parse_result)
+                    break;
+            }
         }
 
         detail::parse_into_map_cleanup(map);
         if (parse_result)
-            func();
+            state.invoke(state.invoked_command, map);
+    }
+
+    template<
+        typename OptionsMap,
+        typename Args,
+        typename Char,
+        typename... Options>
+    void parse_commands(
+        OptionsMap & map,
+        customizable_strings const & strings,
+        parse_mode mode,
+        Args const & args,
+        std::basic_string_view<Char> program_desc,
+        std::basic_ostream<Char> & os,
+        bool skip_first,
+        Options const &... opts)
+    {
+        command_tables const command_names(strings, opts...);
+        detail::parse_commands(
+            command_names,
+            map,
+            strings,
+            mode,
+            args,
+            program_desc,
+            os,
+            skip_first,
+            opts...);
     }
 
 }}}
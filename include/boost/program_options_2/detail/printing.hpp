@@ -400,6 +400,8 @@ namespace boost { namespace program_options_2 { namespace detail {
             if (!parse_contexts.back().commands_synopsis_text_.empty())
                 oss << ' ';
             oss << parse_contexts.back().commands_synopsis_text_;
+            if (parse_contexts.back().nested_commands_)
+                oss << ' ' << strings.next_subcommand_placeholder_text;
 
             current_width = detail::print_option_final(
                 os, 0, current_width, max_col_width, std::move(oss));
@@ -408,7 +410,7 @@ namespace boost { namespace program_options_2 { namespace detail {
             if (last_command) {
                 for (auto const & ctx : parse_contexts) {
                     current_width =
-                        ctx.print_synopsis_(os, first_column, current_width);
+                        ctx.print_synopsis(os, first_column, current_width);
                 }
             }
         }
@@ -657,11 +659,11 @@ namespace boost { namespace program_options_2 { namespace detail {
                     commands_printed);
             });
         } else if (parse_contexts.back().has_subcommands_) {
-            parse_contexts.back().print_post_synopsis_(
+            parse_contexts.back().print_post_synopsis(
                 true, printed_sections, max_option_length, commands_printed);
         } else {
             for (auto const & ctx : parse_contexts) {
-                ctx.print_post_synopsis_(
+                ctx.print_post_synopsis(
                     false,
                     printed_sections,
                     max_option_length,
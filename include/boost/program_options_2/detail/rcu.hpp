@@ -0,0 +1,128 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_RCU_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_RCU_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // A pointer to an immutable T, which any number of readers can use
+    // without locking or waiting, and which a writer can replace.  A reader
+    // brackets its use of get() with read_lock() and read_unlock().  A
+    // replaced T is deleted only once every reader that might have seen it
+    // has called read_unlock(), as in userspace RCU: the generation is
+    // flipped twice after the T is replaced, and each time, the readers
+    // that entered under the old generation must leave before the next
+    // flip.  The writer never waits for them; instead, replaced Ts are
+    // retired, and each call to replace() deletes the ones whose readers
+    // have all left, so a reader that holds on to a T only delays its
+    // deletion.
+    template<typename T>
+    struct rcu_ptr
+    {
+        explicit rcu_ptr(std::unique_ptr<T const> p) : ptr_(p.release()) {}
+        ~rcu_ptr()
+        {
+            for (auto const & r : retired_) {
+                delete r.ptr;
+            }
+            delete ptr_.load();
+        }
+
+        rcu_ptr(rcu_ptr const &) = delete;
+        rcu_ptr & operator=(rcu_ptr const &) = delete;
+
+        // Returns the token to pass to read_unlock().
+        unsigned read_lock() const
+        {
+            unsigned const slot = generation_.load() & 1u;
+            readers_[slot].count.fetch_add(1);
+            return slot;
+        }
+        void read_unlock(unsigned slot) const
+        {
+            readers_[slot].count.fetch_sub(1);
+        }
+
+        // Only valid between read_lock() and read_unlock().
+        T const * get() const { return ptr_.load(); }
+
+        // Makes p the current T, and retires the previous one, to be
+        // deleted by a later call once no reader can be using it.  Deletes
+        // any retired T that no reader can still be using.  This never
+        // waits.  Calls must not overlap.
+        void replace(std::unique_ptr<T const> p)
+        {
+            T const * const old = ptr_.exchange(p.release());
+            // A flip begun before the exchange does not count.
+            retired_.push_back(
+                {old, completed_flips_ + (0 <= draining_slot_) + 2});
+            reclaim();
+        }
+
+        // Returns the number of replaced Ts not yet deleted.
+        std::size_t retired() const { return retired_.size(); }
+
+    private:
+        // Flips the generation as many times as it can without waiting for
+        // a reader, then deletes each retired T whose readers have all
+        // left.
+        void reclaim()
+        {
+            for (;;) {
+                if (0 <= draining_slot_) {
+                    if (readers_[draining_slot_].count.load())
+                        break;
+                    draining_slot_ = -1;
+                    ++completed_flips_;
+                }
+                if (std::ranges::all_of(retired_, [this](auto const & r) {
+                        return r.flips_needed <= completed_flips_;
+                    })) {
+                    break;
+                }
+                draining_slot_ = generation_.fetch_add(1) & 1u;
+            }
+            std::erase_if(retired_, [this](auto const & r) {
+                if (completed_flips_ < r.flips_needed)
+                    return false;
+                delete r.ptr;
+                return true;
+            });
+        }
+
+        // Keeps the two counts from sharing a cache line.
+        struct alignas(64) reader_count
+        {
+            std::atomic<std::size_t> count = 0;
+        };
+
+        struct retired_ptr
+        {
+            T const * ptr;
+            std::uint64_t flips_needed;
+        };
+
+        std::atomic<T const *> ptr_;
+        std::atomic<unsigned> generation_ = 0;
+        mutable reader_count readers_[2];
+
+        // Used only by the writer.
+        std::vector<retired_ptr> retired_;
+        std::uint64_t completed_flips_ = 0;
+        int draining_slot_ = -1;
+    };
+
+}}}
+
+#endif
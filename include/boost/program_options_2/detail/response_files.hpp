@@ -0,0 +1,497 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_RESPONSE_FILES_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_RESPONSE_FILES_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/arg_view.hpp>
+#include <boost/program_options_2/detail/mapped_file.hpp>
+#include <boost/program_options_2/detail/thread_pool.hpp>
+#include <boost/program_options_2/detail/token_scan.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+#include <sys/stat.h>
+#endif
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // Identifies a file independently of the path used to name it: by
+    // device and inode where those are available, and otherwise by
+    // canonical path.
+    struct file_id
+    {
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        std::string path;
+
+        auto operator<=>(file_id const &) const = default;
+    };
+
+    inline file_id make_file_id(char const * path)
+    {
+        file_id retval;
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+        struct stat st;
+        if (::stat(path, &st) == 0) {
+            retval.device = st.st_dev;
+            retval.inode = st.st_ino;
+            return retval;
+        }
+#endif
+#if BOOST_PROGRAM_OPTIONS_2_USE_STD_FILESYSTEM
+        namespace fs = std::filesystem;
+#else
+        namespace fs = filesystem;
+#endif
+        detail::error_code ec;
+        auto const canonical = fs::canonical(fs::path(path), ec);
+        retval.path = ec ? path : canonical.string();
+        return retval;
+    }
+
+    // Passes each allocation on to upstream, holding a lock while a
+    // locking_scope is alive, so that the threads of
+    // response_file_cache::prefetch() can share a resource that is not
+    // thread-safe, like a std::pmr::monotonic_buffer_resource.  At any
+    // other time only one thread uses the resource, and no lock is taken.
+    struct locked_resource : std::pmr::memory_resource
+    {
+        explicit locked_resource(std::pmr::memory_resource * upstream) :
+            upstream_(upstream)
+        {}
+
+        std::pmr::memory_resource * upstream() const { return upstream_; }
+
+        // Makes r lock for as long as this lives.  It must be created
+        // before, and destroyed after, the threads that share r.
+        struct locking_scope
+        {
+            explicit locking_scope(locked_resource & r) : r_(r)
+            {
+                r_.locking_ = true;
+            }
+            ~locking_scope() { r_.locking_ = false; }
+
+            locking_scope(locking_scope const &) = delete;
+            locking_scope & operator=(locking_scope const &) = delete;
+
+        private:
+            locked_resource & r_;
+        };
+
+    private:
+        void * do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            if (!locking_)
+                return upstream_->allocate(bytes, alignment);
+            std::lock_guard<std::mutex> lock(mutex_);
+            return upstream_->allocate(bytes, alignment);
+        }
+        void do_deallocate(
+            void * p, std::size_t bytes, std::size_t alignment) override
+        {
+            if (!locking_) {
+                upstream_->deallocate(p, bytes, alignment);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            upstream_->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(
+            std::pmr::memory_resource const & other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource * upstream_;
+        std::mutex mutex_;
+        bool locking_ = false;
+    };
+
+    // Iterates over the tokens of a response file's contents, tokenizing
+    // as it goes, so that no more than one token is held at a time.  Unlike
+    // a response_file_buffer_iter, each iterator owns the string that it
+    // unescapes tokens into, so an iterator may be copied, and the copy
+    // advanced, without disturbing the original.
+    //
+    // If unescaped is non-null, each token that needed unescaping is
+    // instead copied into *unescaped the first time any iterator reaches
+    // it, and refers there, so that it lives as long as *unescaped does.
+    // Since a file's tokens are always the same, the i-th such token of
+    // each later pass reuses the i-th copy.
+    struct response_file_token_iter
+        : stl_interfaces::proxy_iterator_interface<
+              response_file_token_iter,
+              std::forward_iterator_tag,
+              std::string_view>
+    {
+        response_file_token_iter() = default;
+        response_file_token_iter(
+            std::string_view contents,
+            std::pmr::deque<std::pmr::string> * unescaped,
+            std::pmr::memory_resource * resource) :
+            current_(resource), it_(contents, current_), unescaped_(unescaped)
+        {
+            update();
+        }
+
+        response_file_token_iter(response_file_token_iter const & other) :
+            current_(other.current_, other.current_.get_allocator()),
+            it_(other.it_),
+            unescaped_(other.unescaped_),
+            unescaped_index_(other.unescaped_index_),
+            value_(other.value_)
+        {
+            rebind();
+        }
+        response_file_token_iter &
+        operator=(response_file_token_iter const & other)
+        {
+            current_ = other.current_;
+            it_ = other.it_;
+            unescaped_ = other.unescaped_;
+            unescaped_index_ = other.unescaped_index_;
+            value_ = other.value_;
+            rebind();
+            return *this;
+        }
+
+        std::string_view operator*() const { return value_; }
+
+        response_file_token_iter & operator++()
+        {
+            ++it_;
+            update();
+            return *this;
+        }
+
+        friend bool operator==(
+            response_file_token_iter const & lhs,
+            response_file_token_iter const & rhs)
+        {
+            return lhs.it_ == rhs.it_;
+        }
+
+        using base_type = stl_interfaces::proxy_iterator_interface<
+            response_file_token_iter,
+            std::forward_iterator_tag,
+            std::string_view>;
+        using base_type::operator++;
+
+    private:
+        void update()
+        {
+            if (unescaped_ && it_.copied()) {
+                if (unescaped_->size() <= unescaped_index_)
+                    unescaped_->emplace_back(*it_);
+                value_ = (*unescaped_)[unescaped_index_++];
+            } else {
+                value_ = *it_;
+            }
+        }
+
+        void rebind()
+        {
+            it_.rebind(current_);
+            if (!unescaped_ || !it_.copied())
+                value_ = *it_;
+        }
+
+        std::pmr::string current_;
+        response_file_buffer_iter it_;
+        std::pmr::deque<std::pmr::string> * unescaped_ = nullptr;
+        std::size_t unescaped_index_ = 0;
+        std::string_view value_;
+    };
+
+    // A response file read during a parse.  Only the file's contents are
+    // kept; its tokens are produced anew by each pass over tokens().
+    struct cached_response_file
+    {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        explicit cached_response_file(allocator_type alloc = {}) :
+            unescaped(alloc)
+        {}
+
+        void read(char const * path)
+        {
+            file.emplace(path, unescaped.get_allocator().resource());
+        }
+
+        struct token_range
+        {
+            response_file_token_iter begin() const { return first_; }
+            response_file_token_iter end() const { return {}; }
+
+            response_file_token_iter first_;
+        };
+
+        // Returns the tokens of the file.  Tokens that needed no unescaping
+        // refer into file.  The rest refer into unescaped if
+        // keep_unescaped is true, and otherwise only stay valid until the
+        // iterator that produced them is advanced.
+        token_range tokens()
+        {
+            return {response_file_token_iter(
+                file->contents(),
+                keep_unescaped ? &unescaped : nullptr,
+                unescaped.get_allocator().resource())};
+        }
+
+        // Calls f with each buffer that tokens refer into.
+        template<typename F>
+        void for_each_buffer(F const & f) const
+        {
+            if (file)
+                f(file->contents());
+            for (auto const & s : unescaped) {
+                f(std::string_view(s));
+            }
+        }
+
+        std::optional<mapped_file> file;
+        std::pmr::deque<std::pmr::string> unescaped;
+        bool keep_unescaped = false;
+        bool expanding = false;
+    };
+
+    // The response files read during a single parse.  Each file is read
+    // once, however many times it is referred to; later references
+    // tokenize the same contents again, so that the memory a parse uses
+    // does not grow with the number of tokens in its files.  The cache also
+    // knows which files are being expanded, which is all that is needed to
+    // detect a file that refers to itself, and to limit how deeply files
+    // are nested.  All of the cache's memory comes from resource.
+    //
+    // If keep_unescaped is true, the tokens that needed unescaping are
+    // kept too, so that every token stays valid for as long as the cache
+    // does.  A cache kept by a response_file_buffers does this.
+    struct response_file_cache
+    {
+        explicit response_file_cache(
+            std::pmr::memory_resource * resource =
+                std::pmr::get_default_resource(),
+            bool keep_unescaped = false) :
+            resource_(resource),
+            files_(&resource_),
+            keep_unescaped_(keep_unescaped)
+        {}
+
+        response_file_cache(response_file_cache const &) = delete;
+        response_file_cache & operator=(response_file_cache const &) = delete;
+
+        std::pmr::memory_resource * resource() const
+        {
+            return resource_.upstream();
+        }
+
+        // Returns the number of files read.
+        std::size_t size() const { return files_.size(); }
+
+        // Returns true if any file is being expanded.
+        bool expanding() const { return depth_ != 0; }
+
+        // Calls f with each buffer that the tokens of the files read refer
+        // into.
+        template<typename F>
+        void for_each_buffer(F const & f) const
+        {
+            for (auto const & [id, file] : files_) {
+                file.for_each_buffer(f);
+            }
+        }
+
+        // Returns the response file at path, and marks the
+        // file as being expanded, until the matching call to leave().  On
+        // failure (including when max_depth files are already being
+        // expanded, and when the file cannot be read), returns nullptr and
+        // sets error.  A file that cannot be read is not kept.
+        cached_response_file * enter(
+            char const * path, int max_depth, parse_option_error & error)
+        {
+            if (max_depth <= depth_) {
+                error = parse_option_error::response_files_nested_too_deeply;
+                return nullptr;
+            }
+            auto const [it, inserted] =
+                files_.try_emplace(detail::make_file_id(path));
+            if (inserted) {
+                it->second.keep_unescaped = keep_unescaped_;
+                it->second.read(path);
+            } else if (it->second.expanding) {
+                error = parse_option_error::response_file_cycle;
+                return nullptr;
+            }
+            if (!it->second.file->is_open()) {
+                files_.erase(it);
+                error = parse_option_error::cannot_read_response_file;
+                return nullptr;
+            }
+            it->second.expanding = true;
+            ++depth_;
+            return &it->second;
+        }
+
+        void leave(cached_response_file & file)
+        {
+            file.expanding = false;
+            --depth_;
+        }
+
+        // Reads each of the files at paths (a range of
+        // strings) that is not already cached, using up to max_threads
+        // threads: the calling one, and threads of pool.  Since this only
+        // fills in the cache, the results of a parse do not depend on
+        // whether or how this is used.
+        template<typename Paths>
+        void prefetch(Paths const & paths, thread_pool & pool, int max_threads)
+        {
+            std::pmr::vector<std::pair<char const *, cached_response_file *>>
+                work(&resource_);
+            for (auto const & path : paths) {
+                auto const [it, inserted] =
+                    files_.try_emplace(detail::make_file_id(path.c_str()));
+                if (inserted) {
+                    it->second.keep_unescaped = keep_unescaped_;
+                    work.emplace_back(path.c_str(), &it->second);
+                }
+            }
+
+            std::atomic<std::size_t> next = 0;
+            std::exception_ptr exception;
+            std::mutex exception_mutex;
+            auto worker = [&] {
+                try {
+                    for (std::size_t i = next++; i < work.size(); i = next++) {
+                        work[i].second->read(work[i].first);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(exception_mutex);
+                    if (!exception)
+                        exception = std::current_exception();
+                }
+            };
+
+            auto const helpers = (std::min)(
+                (std::size_t)(std::max)(max_threads - 1, 0),
+                work.empty() ? std::size_t(0) : work.size() - 1);
+            if (helpers == 0) {
+                worker();
+            } else {
+                locked_resource::locking_scope const locking(resource_);
+                pool.run(helpers, worker);
+            }
+            if (exception)
+                std::rethrow_exception(exception);
+            std::erase_if(files_, [](auto const & file) {
+                return !file.second.file || !file.second.file->is_open();
+            });
+        }
+
+    private:
+        locked_resource resource_;
+        // A node-based map, so that a file being expanded stays put while
+        // the files it refers to are added.
+        std::pmr::map<file_id, cached_response_file> files_;
+        int depth_ = 0;
+        bool keep_unescaped_ = false;
+    };
+
+    // Calls cache.leave(file) on destruction, for a file returned by
+    // cache.enter().
+    struct response_file_scope
+    {
+        response_file_scope(
+            response_file_cache & cache, cached_response_file & file) :
+            cache_(cache), file_(file)
+        {}
+        ~response_file_scope() { cache_.leave(file_); }
+
+        response_file_scope(response_file_scope const &) = delete;
+        response_file_scope & operator=(response_file_scope const &) = delete;
+
+    private:
+        response_file_cache & cache_;
+        cached_response_file & file_;
+    };
+
+    // Returns the path named by a response file arg, as UTF-8, without its
+    // response file prefix, if any.
+    template<typename Char>
+    std::pmr::string response_file_path(
+        std::basic_string_view<Char> arg,
+        customizable_strings const & strings,
+        std::pmr::memory_resource * resource)
+    {
+        auto const arg_utf8 = text::as_utf8(arg);
+        std::pmr::string retval(arg_utf8.begin(), arg_utf8.end(), resource);
+        if (detail::transcoded_starts_with(
+                retval, strings.response_file_prefix)) {
+            retval.erase(0, strings.response_file_prefix.size());
+        }
+        return retval;
+    }
+
+    // When strings.response_file_threads allows, reads all the response
+    // files named in [first, last) into cache, concurrently, with the help
+    // of pool.  Files referred to from within these files are read later,
+    // as usual.
+    //
+    // Only the response file args that the parse is sure to read are
+    // prefetched, since an arg like "@x" may instead be an option's value,
+    // and reading it could block (if it names a FIFO, say).  Those are the
+    // args at the front of [first, last) that are each either a response
+    // file arg, or an arg for which flag_arg(it) is true -- that is, one
+    // naming an option that takes no args.  Files named after that are read
+    // when the parse reaches them.
+    template<typename Iter, typename FlagArg>
+    void prefetch_response_files(
+        response_file_cache & cache,
+        thread_pool & pool,
+        Iter first,
+        Iter last,
+        customizable_strings const & strings,
+        FlagArg const & flag_arg)
+    {
+        if constexpr (std::forward_iterator<Iter>) {
+            if (strings.response_file_threads <= 1)
+                return;
+            std::pmr::vector<std::pmr::string> paths(cache.resource());
+            for (; first != last; ++first) {
+                if (detail::response_file_token(first, strings)) {
+                    paths.push_back(detail::response_file_path(
+                        detail::make_string_view(*first),
+                        strings,
+                        cache.resource()));
+                } else if (!flag_arg(first)) {
+                    break;
+                }
+            }
+            if (1u < paths.size())
+                cache.prefetch(paths, pool, strings.response_file_threads);
+        }
+    }
+
+}}}
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_SPECIAL_BYTES_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_SPECIAL_BYTES_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define BOOST_PROGRAM_OPTIONS_2_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define BOOST_PROGRAM_OPTIONS_2_USE_SSE2 0
+#endif
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // The bytes that the response file tokenizer must look at individually:
+    // whitespace, quotes, backslashes, and '#'.  Every other byte is just
+    // part of a token.
+    inline bool response_file_special(char c)
+    {
+        return c == ' ' || ('\t' <= c && c <= '\r') || c == '"' ||
+               c == '\\' || c == '#';
+    }
+
+    constexpr std::ptrdiff_t special_bytes_block_size = 64;
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_SSE2
+    inline std::uint32_t special_bytes_16(char const * p)
+    {
+        __m128i const v = _mm_loadu_si128((__m128i const *)p);
+        // c is in ['\t', '\r'] iff (c - '\t') is at most 4, as unsigned.
+        __m128i const offset = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+        __m128i const ws = _mm_cmpeq_epi8(
+            _mm_min_epu8(offset, _mm_set1_epi8(4)), offset);
+        __m128i const special = _mm_or_si128(
+            _mm_or_si128(ws, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))),
+            _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('#'))));
+        return (std::uint32_t)_mm_movemask_epi8(special);
+    }
+#endif
+
+    // Returns a mask in which bit i is set iff p[i] is special, for each i
+    // in [0, n).  n must be at most special_bytes_block_size.
+    inline std::uint64_t special_bytes(char const * p, std::ptrdiff_t n)
+    {
+#if BOOST_PROGRAM_OPTIONS_2_USE_SSE2
+        if (n == special_bytes_block_size) {
+            return std::uint64_t(detail::special_bytes_16(p)) |
+                   std::uint64_t(detail::special_bytes_16(p + 16)) << 16 |
+                   std::uint64_t(detail::special_bytes_16(p + 32)) << 32 |
+                   std::uint64_t(detail::special_bytes_16(p + 48)) << 48;
+        }
+#endif
+        std::uint64_t retval = 0;
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            retval |= std::uint64_t(detail::response_file_special(p[i])) << i;
+        }
+        return retval;
+    }
+
+}}}
+
+#endif
@@ -0,0 +1,136 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_THREAD_POOL_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // Threads that help the calling thread with a job, and then wait for
+    // the next one.  A thread is started the first time it is needed, and
+    // is kept until the pool is destroyed, so that a program that parses
+    // many command lines does not start threads for each one.
+    //
+    // A job is expected to take its work from a queue shared by all the
+    // threads running it, until the queue is empty.  Once the calling
+    // thread's call returns, the work is therefore all taken, and any
+    // helper that has not started the job yet does not start it.  A job
+    // must not throw.
+    struct thread_pool
+    {
+        thread_pool() = default;
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            work_cv_.notify_all();
+            threads_.clear();
+        }
+
+        thread_pool(thread_pool const &) = delete;
+        thread_pool & operator=(thread_pool const &) = delete;
+
+        // Calls f on the calling thread, and on up to helpers threads of the
+        // pool, and returns once every call has returned.  If another thread
+        // is already running a job on the pool, f is called on the calling
+        // thread alone.
+        template<typename F>
+        void run(std::size_t helpers, F const & f)
+        {
+            std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+            if (!run_lock || !helpers) {
+                f();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                while (threads_.size() < helpers) {
+                    threads_.emplace_back([this] { work(); });
+                }
+                job_ = [](void const * f) { (*static_cast<F const *>(f))(); };
+                job_arg_ = &f;
+                wanted_ = helpers;
+                ++generation_;
+            }
+            work_cv_.notify_all();
+
+            f();
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wanted_ = 0;
+            done_cv_.wait(lock, [this] { return running_ == 0; });
+        }
+
+        // Returns the number of threads started so far.
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return threads_.size();
+        }
+
+    private:
+        void work()
+        {
+            std::uint64_t seen = 0;
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                work_cv_.wait(lock, [&] {
+                    return stopping_ || (seen != generation_ && wanted_);
+                });
+                if (stopping_)
+                    return;
+                seen = generation_;
+                --wanted_;
+                ++running_;
+                auto const job = job_;
+                auto const job_arg = job_arg_;
+                lock.unlock();
+                job(job_arg);
+                lock.lock();
+                if (!--running_)
+                    done_cv_.notify_all();
+            }
+        }
+
+        // Held for the whole of a call to run().
+        std::mutex run_mutex_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable work_cv_;
+        std::condition_variable done_cv_;
+        void (*job_)(void const *) = nullptr;
+        void const * job_arg_ = nullptr;
+        // The number of helpers still to start the current job, and the
+        // number running it.
+        std::size_t wanted_ = 0;
+        std::size_t running_ = 0;
+        std::uint64_t generation_ = 0;
+        bool stopping_ = false;
+        // Last, so that the threads are joined before the rest is destroyed.
+        std::vector<std::jthread> threads_;
+    };
+
+    // The pool used by parses that are not given one, such as those done by
+    // parse_command_line().
+    inline thread_pool & default_thread_pool()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+}}}
+
+#endif
@@ -0,0 +1,260 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_DETAIL_TOKEN_SCAN_HPP
+#define BOOST_PROGRAM_OPTIONS_2_DETAIL_TOKEN_SCAN_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/detail/name_index.hpp>
+#include <boost/program_options_2/detail/utility.hpp>
+
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 { namespace detail {
+
+    // The facts about a single command line token that the parsing engine
+    // needs, computed once per token.
+    struct token_info
+    {
+        // Starts with the short or long option prefix.
+        bool dashed : 1;
+        // Starts with the response file prefix.
+        bool response_file : 1;
+        // Is the name of some option, in any group or command.
+        bool known_name : 1;
+        // Is one of the default help names.
+        bool default_help : 1;
+    };
+
+    template<typename Char>
+    token_info classify_token(
+        std::basic_string_view<Char> token,
+        customizable_strings const & strings,
+        name_index const & known_names,
+        name_index const & help_names)
+    {
+        token_info retval{};
+        retval.dashed =
+            detail::transcoded_starts_with(
+                token, strings.short_option_prefix) ||
+            detail::transcoded_starts_with(token, strings.long_option_prefix);
+        retval.response_file =
+            !strings.response_file_note.empty() &&
+            detail::transcoded_starts_with(token, strings.response_file_prefix);
+        // All names of non-positional options are dashed, so only dashed
+        // tokens need to be looked up.
+        if (retval.dashed)
+            retval.known_name = known_names.contains(token);
+        retval.default_help = help_names.contains(token);
+        return retval;
+    }
+
+    // An iterator over a range of args that also steps through the
+    // token_infos computed for them by scan_args().
+    template<typename Iter>
+    struct scanned_iterator
+    {
+        using value_type = std::iter_value_t<Iter>;
+        using difference_type = std::iter_difference_t<Iter>;
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+
+        scanned_iterator() = default;
+        scanned_iterator(Iter it, token_info const * info) :
+            it_(it), info_(info)
+        {}
+
+        decltype(auto) operator*() const { return *it_; }
+        Iter const & operator->() const { return it_; }
+
+        scanned_iterator & operator++()
+        {
+            ++it_;
+            ++info_;
+            return *this;
+        }
+        scanned_iterator operator++(int)
+        {
+            auto retval = *this;
+            ++*this;
+            return retval;
+        }
+
+        token_info const & info() const { return *info_; }
+
+        friend bool
+        operator==(scanned_iterator lhs, scanned_iterator rhs)
+        {
+            return lhs.info_ == rhs.info_;
+        }
+
+    private:
+        Iter it_;
+        token_info const * info_ = nullptr;
+    };
+
+    // A range of args, plus one token_info per arg.  This is produced by a
+    // single pass over the args before parsing, so that the parse itself
+    // never has to rediscover what kind of token it is looking at.
+    template<typename Args>
+    struct scanned_args
+    {
+        using iterator =
+            scanned_iterator<decltype(std::declval<Args const &>().begin())>;
+
+        iterator begin() const { return {args_->begin(), tokens_.data()}; }
+        iterator end() const
+        {
+            return {args_->end(), tokens_.data() + tokens_.size()};
+        }
+
+        bool contains_default_help() const { return contains_default_help_; }
+
+        Args const * args_ = nullptr;
+        std::pmr::vector<token_info> tokens_;
+        bool contains_default_help_ = false;
+    };
+
+    template<typename Args>
+    scanned_args<Args> scan_args(
+        Args const & args,
+        customizable_strings const & strings,
+        name_index const & known_names,
+        name_index const & help_names,
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+    {
+        scanned_args<Args> retval{
+            &args, std::pmr::vector<token_info>(resource)};
+        if constexpr (std::ranges::sized_range<Args const>)
+            retval.tokens_.reserve(std::ranges::size(args));
+        for (auto const & arg : args) {
+            auto const info = detail::classify_token(
+                detail::make_string_view(arg), strings, known_names, help_names);
+            retval.contains_default_help_ |= info.default_help;
+            retval.tokens_.push_back(info);
+        }
+        return retval;
+    }
+
+    // The per-token queries below use the scanned token_info when the
+    // iterator has one, and otherwise (as for args read from a response
+    // file) compute the answer directly.
+
+    template<typename Iter>
+    bool response_file_token(
+        Iter const & it, customizable_strings const & strings)
+    {
+        return !strings.response_file_note.empty() &&
+               detail::transcoded_starts_with(*it, strings.response_file_prefix);
+    }
+    template<typename Iter>
+    bool response_file_token(
+        scanned_iterator<Iter> const & it, customizable_strings const &)
+    {
+        return it.info().response_file;
+    }
+
+    template<typename Iter>
+    bool dashed_token(Iter const & it, customizable_strings const & strings)
+    {
+        return detail::transcoded_starts_with(
+                   *it, strings.short_option_prefix) ||
+               detail::transcoded_starts_with(*it, strings.long_option_prefix);
+    }
+    template<typename Iter>
+    bool
+    dashed_token(scanned_iterator<Iter> const & it, customizable_strings const &)
+    {
+        return it.info().dashed;
+    }
+
+    template<typename Iter>
+    bool known_name_token(Iter const & it, name_index const & known_names)
+    {
+        return known_names.contains(detail::make_string_view(*it));
+    }
+    template<typename Iter>
+    bool known_name_token(scanned_iterator<Iter> const & it, name_index const &)
+    {
+        return it.info().known_name;
+    }
+
+    // Returns the number of args in [first, last), up to max_count, that
+    // precede the next known option name.  Those are the args that may be
+    // values of the option currently being parsed.  For iterators without
+    // a scanned token_info (as for args read from a response file), each
+    // arg is looked up in known_names; if [first, last) cannot be read
+    // twice, this is unknown, and 0 is returned.
+    template<typename Iter>
+    std::ptrdiff_t value_run_length(
+        Iter first, Iter last, int max_count, name_index const & known_names)
+    {
+        std::ptrdiff_t retval = 0;
+        if constexpr (std::forward_iterator<Iter>) {
+            for (; retval < max_count && first != last &&
+                   !detail::known_name_token(first, known_names);
+                 ++first) {
+                ++retval;
+            }
+        }
+        return retval;
+    }
+    template<typename Iter>
+    std::ptrdiff_t value_run_length(
+        scanned_iterator<Iter> first,
+        scanned_iterator<Iter> last,
+        int max_count,
+        name_index const &)
+    {
+        std::ptrdiff_t retval = 0;
+        for (; retval < max_count && first != last && !first.info().known_name;
+             ++first) {
+            ++retval;
+        }
+        return retval;
+    }
+
+    template<typename Iter>
+    bool contains_default_help_flag(
+        Iter first, Iter last, customizable_strings const & strings)
+    {
+        auto const names = names_view(strings.default_help_names);
+        for (; first != last; ++first) {
+            for (auto name : names) {
+                if (detail::transcoded_equal(*first, name))
+                    return true;
+            }
+        }
+        return false;
+    }
+    template<typename Iter>
+    bool contains_default_help_flag(
+        scanned_iterator<Iter> first,
+        scanned_iterator<Iter> last,
+        customizable_strings const &)
+    {
+        for (; first != last; ++first) {
+            if (first.info().default_help)
+                return true;
+        }
+        return false;
+    }
+
+    inline name_index
+    make_default_help_names_index(customizable_strings const & strings)
+    {
+        name_index retval;
+        for (auto name : names_view(strings.default_help_names)) {
+            retval.insert(name, {0, -1});
+        }
+        return retval;
+    }
+
+}}}
+
+#endif
@@ -34,7 +34,9 @@ namespace boost { namespace program_options_2 { namespace detail {
             std::move(opt.default_value),
             opt.choices,
             opt.arg_display_name,
-            std::move(validator)};
+            std::move(validator),
+            opt.separator,
+            std::move(opt.sink)};
     }
 
     template<typename StringView>
@@ -27,9 +27,13 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <algorithm>
 #include <any>
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <ranges>
 #include <string_view>
 #include <type_traits>
 
@@ -58,6 +62,25 @@ namespace boost { namespace program_options_2 {
         nonempty string, it will be printed at the end of the help summary
         text, after a blank line.
 
+        `max_response_file_depth` is not a string, but a limit on how deeply
+        response files may be nested, where a response file named on the
+        command line has depth 1, a response file named in that one has
+        depth 2, and so on.  Parsing fails if this depth is exceeded.
+
+        `response_file_threads` is not a string either.  By default,
+        response files are read one at a time, as the parse reaches them.  If
+        you set it to a value N greater than 1, the response files named
+        directly on the command line (as `@file`) are read before parsing
+        begins, on up to N threads, including the one doing the parse.  Only
+        the ones that are sure to be read are read early: those named before
+        any arg other than a response file or an option that takes no args,
+        since a later `@file` might be the value of an option.  The extra
+        threads are started the first time they are needed, and are reused
+        by later parses; a `parser` has its own, and `parse_command_line()`
+        shares one set among all its calls.  The results of the parse are the
+        same either way.  Since this uses `std::thread`, you may need to link
+        against your platform's threading library.
+
         \note Three of these strings are special: `short_option_prefix`,
         `long_option_prefix`, and `response_file_prefix`.  If you customize
         any of these, you must use the same custom `customizable_strings` when
@@ -91,7 +114,7 @@ namespace boost { namespace program_options_2 {
         std::string_view long_option_prefix = "--";
         std::string_view response_file_prefix = "@";
 
-        std::array<std::string_view, 8> parse_errors = {
+        std::array<std::string_view, 11> parse_errors = {
             {"error: unrecognized argument '{}'",
              "error: wrong number of arguments for '{}'",
              "error: cannot parse argument '{}'",
@@ -100,7 +123,10 @@ namespace boost { namespace program_options_2 {
              "error: one or more missing positional arguments, starting with "
              "'{}'",
              "error: '{}' may not be used with '{}'",
-             "error: expected a command"}};
+             "error: expected a command",
+             "error: response file '{}' refers to itself",
+             "error: response file '{}' is nested too deeply",
+             "error: cannot read response file '{}'"}};
 
         // validation errors
         std::string_view path_not_found = "error: path '{}' not found";
@@ -112,6 +138,9 @@ namespace boost { namespace program_options_2 {
         std::string_view found_directory_not_file =
             "error: '{}' is a directory, but a file was expected";
         std::string_view cannot_read = "error: cannot open '{}' for reading";
+
+        int max_response_file_depth = 64;
+        int response_file_threads = 1;
     };
 
     /** The type that must be returned from any invocable that can be used as
@@ -133,10 +162,16 @@ namespace boost { namespace program_options_2 {
 
     /** A `std::map` of `std::string`s to `std::any`s.  This is a type that
         may be appropriate for parsing options into.  Note that if you parse
-        response files and/or parse UTF-16 command line arguments, this type
-        will not work. */
+        UTF-16 command line arguments, this type will not work.  If you parse
+        response files, it will only work if the parse is given a
+        `response_file_buffers` that outlives the map. */
     using string_view_any_map = std::map<std::string_view, std::any>;
 
+    template<typename... Options>
+    struct typed_options;
+
+    struct response_file_buffers;
+
     /** An invocable that returns true iff the given `any`.  It has built-in
         support for `boost::any` and `std::any`, and uses `tag_invoke` to
         allow users to customize its behavior for their own types. */
@@ -200,6 +235,39 @@ namespace boost { namespace program_options_2 {
             response_file
         };
 
+        // The type of an option made by with_sink().  It is insertable, like
+        // the container it replaces, but it is always empty; each value
+        // inserted into it is passed straight to sink, which is either
+        // invocable with a T or an output iterator for T.
+        template<typename T, typename Sink>
+        struct value_sink
+        {
+            using value_type = T;
+
+            T const * begin() const { return nullptr; }
+            T const * end() const { return nullptr; }
+
+            T const * insert(T const * it, T value) const
+            {
+                if constexpr (std::is_invocable_v<Sink &, T &&>) {
+                    sink(std::move(value));
+                } else {
+                    *sink = std::move(value);
+                    ++sink;
+                }
+                return it;
+            }
+
+            mutable Sink sink;
+        };
+
+        template<typename T>
+        struct is_value_sink : std::false_type
+        {};
+        template<typename T, typename Sink>
+        struct is_value_sink<value_sink<T, Sink>> : std::true_type
+        {};
+
         template<
             option_kind Kind,
             typename T,
@@ -217,6 +285,8 @@ namespace boost { namespace program_options_2 {
                 no_value,
                 ChoiceType>;
             using validator_type = Validator;
+            using sink_type =
+                std::conditional_t<is_value_sink<T>::value, T, no_value>;
 
             constexpr static bool positional = Kind == option_kind::positional;
             constexpr static bool required = Required == required_t::yes;
@@ -230,6 +300,9 @@ namespace boost { namespace program_options_2 {
             std::array<choice_type, num_choices> choices;
             std::string_view arg_display_name;
             mutable validator_type validator;
+            std::string_view separator;
+            // Where the values go, for an option made by with_sink().
+            sink_type sink;
         };
 
         template<typename T>
@@ -314,6 +387,13 @@ namespace boost { namespace program_options_2 {
             Options...>> : std::true_type
         {};
 
+        template<typename T>
+        struct is_typed_options : std::false_type
+        {};
+        template<typename... Options>
+        struct is_typed_options<typed_options<Options...>> : std::true_type
+        {};
+
         template<typename T>
         struct is_command : std::false_type
         {};
@@ -333,13 +413,99 @@ namespace boost { namespace program_options_2 {
             return substr_it == std::end(substr);
         }
 
+        // Returns true iff every code unit in str is ASCII.  For 8-bit code
+        // units, this checks a 64-bit word at a time.
+        template<typename Char>
+        bool ascii(std::basic_string_view<Char> str)
+        {
+            if constexpr (sizeof(Char) == 1) {
+                char const * first = (char const *)str.data();
+                char const * const last = first + str.size();
+                for (; 8 <= last - first; first += 8) {
+                    std::uint64_t word;
+                    std::memcpy(&word, first, 8);
+                    if (word & 0x8080808080808080ull)
+                        return false;
+                }
+                for (; first != last; ++first) {
+                    if ((unsigned char)*first & 0x80)
+                        return false;
+                }
+                return true;
+            } else {
+                return std::all_of(str.begin(), str.end(), [](Char c) {
+                    return (std::make_unsigned_t<Char>)c < 0x80;
+                });
+            }
+        }
+
+        // A sized, contiguous sequence of code units, like a std::string or
+        // std::wstring_view.  Arrays are excluded, since a string literal's
+        // size includes its null terminator.
+        template<typename R>
+        concept code_unit_range = std::ranges::contiguous_range<R> &&
+            std::ranges::sized_range<R> && !std::is_array_v<R> &&
+            std::integral<std::ranges::range_value_t<R>>;
+
+        template<code_unit_range R>
+        auto code_units(R const & r)
+        {
+            return std::basic_string_view<std::ranges::range_value_t<R>>(
+                std::ranges::data(r), std::ranges::size(r));
+        }
+
+        // Compares a and b code unit by code unit.  When either side is
+        // ASCII, this gives the same answer as comparing code points, since
+        // no code unit of a non-ASCII code point is in the ASCII range, in
+        // any UTF encoding.
+        template<typename Char1, typename Char2>
+        bool code_units_equal(
+            std::basic_string_view<Char1> a, std::basic_string_view<Char2> b)
+        {
+            if constexpr (std::is_same_v<Char1, Char2>) {
+                return a == b;
+            } else {
+                return std::ranges::equal(a, b, [](Char1 x, Char2 y) {
+                    return (std::make_unsigned_t<Char1>)x ==
+                           (std::make_unsigned_t<Char2>)y;
+                });
+            }
+        }
+
         template<typename R1, typename R2>
         constexpr bool transcoded_starts_with(R1 const & str, R2 const & substr)
         {
+            if constexpr (code_unit_range<R1> && code_unit_range<R2>) {
+                if (!std::is_constant_evaluated()) {
+                    auto const str_units = detail::code_units(str);
+                    auto const substr_units = detail::code_units(substr);
+                    if (detail::ascii(substr_units)) {
+                        return substr_units.size() <= str_units.size() &&
+                               detail::code_units_equal(
+                                   str_units.substr(0, substr_units.size()),
+                                   substr_units);
+                    }
+                }
+            }
             return detail::starts_with(
                 text::as_utf32(str), text::as_utf32(substr));
         }
 
+        // Compares r1 and r2 as sequences of code points.  r2 is expected
+        // to be the shorter of the two, usually an option name, so it is
+        // the side checked for ASCII first.
+        template<typename R1, typename R2>
+        bool transcoded_equal(R1 const & r1, R2 const & r2)
+        {
+            if constexpr (code_unit_range<R1> && code_unit_range<R2>) {
+                auto const units1 = detail::code_units(r1);
+                auto const units2 = detail::code_units(r2);
+                if (detail::ascii(units2) || detail::ascii(units1))
+                    return detail::code_units_equal(units1, units2);
+            }
+            return std::ranges::equal(text::as_utf32(r1), text::as_utf32(r2));
+        }
+
         // Defined in utility.hpp.
         inline bool
         positional(std::string_view name, customizable_strings const & strings);
@@ -465,6 +631,9 @@ namespace boost { namespace program_options_2 {
             missing_positional,
             too_many_mutually_exclusives,
             expected_command,
+            response_file_cycle,
+            response_files_nested_too_deeply,
+            cannot_read_response_file,
 
             // This one must come last, to match
             // customizable_strings::parse_errors.
@@ -511,16 +680,60 @@ namespace boost { namespace program_options_2 {
         using all_printed_sections = boost::container::
             small_vector<std::pair<std::string, printed_section_vec>, 4>;
 
+        // The context of one level of a command line that uses commands:
+        // the top level, or one of the commands named on the command line.
+        // The parse and print operations are function pointers instantiated
+        // for the command's type; they find the command and the rest of the
+        // parse's state through state_ and command_, so that pushing a
+        // context never allocates.
         struct cmd_parse_ctx
         {
-            std::string name_used_;
+            parse_option_result parse(int & next_positional) const
+            {
+                return parse_(*this, next_positional);
+            }
+            int print_synopsis(
+                std::ostringstream & os,
+                int first_column,
+                int current_width) const
+            {
+                return print_synopsis_(*this, os, first_column, current_width);
+            }
+            void print_post_synopsis(
+                bool print_commands,
+                all_printed_sections & printed_sections,
+                int & max_option_length,
+                bool & commands_printed) const
+            {
+                print_post_synopsis_(
+                    *this,
+                    print_commands,
+                    printed_sections,
+                    max_option_length,
+                    commands_printed);
+            }
+
+            std::string_view name_used_;
             std::string_view help_text_;
-            std::function<parse_option_result(int &)> parse_;
-            std::function<int(std::ostringstream &, int, int)> print_synopsis_;
-            std::function<void(bool, all_printed_sections &, int &, bool &)>
-                print_post_synopsis_;
-            std::string commands_synopsis_text_;
+            void const * state_ = nullptr;
+            // The command, or nullptr for the top-level context.
+            void const * command_ = nullptr;
+            parse_option_result (*parse_)(cmd_parse_ctx const &, int &) =
+                nullptr;
+            int (*print_synopsis_)(
+                cmd_parse_ctx const &, std::ostringstream &, int, int) =
+                nullptr;
+            void (*print_post_synopsis_)(
+                cmd_parse_ctx const &,
+                bool,
+                all_printed_sections &,
+                int &,
+                bool &) = nullptr;
+            std::string_view commands_synopsis_text_;
             bool has_subcommands_ = false;
+            // True if the next subcommand placeholder text should follow
+            // commands_synopsis_text_.
+            bool nested_commands_ = false;
         };
 
         using parse_contexts_vec =
@@ -582,6 +795,47 @@ namespace boost { namespace program_options_2 {
             Validator> const & opt,
         customizable_strings const & strings = customizable_strings{});
 
+    /** The kinds of errors that can occur during a parse. */
+    using parse_option_error = detail::parse_option_error;
+
+    /** The outcome of a call to one of the non-exiting parse functions, like
+        `try_parse_command_line()`.  These functions never print anything and
+        never exit; instead, the first error encountered, or a request for
+        help or version, stops the parse and is reported here. */
+    struct parse_status
+    {
+        /** Returns `true` iff the parse completed without error, and the user
+            did not request help or version. */
+        explicit operator bool() const
+        {
+            return error == parse_option_error::none && !help_requested &&
+                   !version_requested;
+        }
+
+        /** The error that stopped the parse, if any. */
+        parse_option_error error = parse_option_error::none;
+
+        /** The command line arg (or, for some errors, the option name) that
+            caused `error`, as UTF-8.  For `parse_option_error::validation_error`,
+            this is the arg that failed validation. */
+        std::string token;
+
+        /** `true` iff the parse stopped because the user requested help. */
+        bool help_requested = false;
+
+        /** `true` iff the parse stopped because the user requested the
+            version. */
+        bool version_requested = false;
+    };
+
+    /** A `parse_status`, plus the value produced by the parse.  If the parse
+        did not succeed, the value may be partially filled in. */
+    template<typename T>
+    struct parse_result : parse_status
+    {
+        T value;
+    };
+
 }}
 
 #endif
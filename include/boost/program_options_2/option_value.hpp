@@ -0,0 +1,310 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_OPTION_VALUE_HPP
+#define BOOST_PROGRAM_OPTIONS_2_OPTION_VALUE_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <any>
+#include <cstddef>
+#include <map>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 {
+
+    namespace detail {
+        // The operations on a value of one type held in an option_value.
+        // Each type has exactly one of these, so the address of a type's
+        // ops also serves as its tag.  The void * parameters point to an
+        // option_value's storage, which holds either the value itself or a
+        // pointer to it.
+        //
+        // The tables are deliberately not const.  Two types whose
+        // operations compile to the same code (like int and unsigned) have
+        // identical tables, and a linker that folds identical read-only
+        // data (as with /OPT:ICF or --icf=all) could give them one address;
+        // mutable objects are never folded.
+        struct option_value_ops
+        {
+            void (*destroy)(void * storage) noexcept;
+            void (*copy)(void * dst, void const * src);
+            // Moves the value in src into dst, and destroys the one in src.
+            void (*relocate)(void * dst, void * src) noexcept;
+        };
+
+        inline constexpr std::size_t option_value_buffer_size = (std::max)(
+            sizeof(std::string), sizeof(std::vector<std::string>));
+        inline constexpr std::size_t option_value_buffer_alignment =
+            alignof(void *);
+
+        template<typename T>
+        constexpr bool option_value_inline =
+            sizeof(T) <= option_value_buffer_size &&
+            alignof(T) <= option_value_buffer_alignment &&
+            std::is_nothrow_move_constructible_v<T>;
+
+        template<typename T, bool Inline = option_value_inline<T>>
+        struct option_value_ops_for
+        {
+            static void destroy(void * storage) noexcept
+            {
+                static_cast<T *>(storage)->~T();
+            }
+            static void copy(void * dst, void const * src)
+            {
+                ::new (dst) T(*static_cast<T const *>(src));
+            }
+            static void relocate(void * dst, void * src) noexcept
+            {
+                ::new (dst) T(std::move(*static_cast<T *>(src)));
+                static_cast<T *>(src)->~T();
+            }
+
+            static constinit inline option_value_ops value = {
+                &destroy, &copy, &relocate};
+        };
+
+        template<typename T>
+        struct option_value_ops_for<T, false>
+        {
+            static void destroy(void * storage) noexcept
+            {
+                delete *static_cast<T **>(storage);
+            }
+            static void copy(void * dst, void const * src)
+            {
+                *static_cast<T **>(dst) =
+                    new T(**static_cast<T * const *>(src));
+            }
+            static void relocate(void * dst, void * src) noexcept
+            {
+                *static_cast<T **>(dst) = *static_cast<T **>(src);
+            }
+
+            static constinit inline option_value_ops value = {
+                &destroy, &copy, &relocate};
+        };
+    }
+
+    /** A type-erased value, for use as the mapped type of an options map in
+        place of `std::any` or `boost::any`.  Any copyable type may be held,
+        but a value that fits in `inline_size` bytes, and that can be moved
+        without throwing, is held inline, without allocating.  That includes
+        the `std::string`, `std::vector`, and arithmetic values that options
+        produce, and so everything produced by the options in this library
+        except those with user-defined types.
+
+        A held value's type is identified by a tag unique to that type, not
+        by RTTI, so casting to the type an option was declared with (which
+        is what the library does when it reads or writes the option's value
+        in a map) costs a single comparison.  Like `std::any`, `option_value`
+        works with `any_empty` and `any_cast`; a failed `any_cast` throws
+        `std::bad_any_cast`. */
+    struct option_value
+    {
+        /** The number of bytes available for a value held inline. */
+        static constexpr std::size_t inline_size =
+            detail::option_value_buffer_size;
+
+        option_value() noexcept = default;
+
+        option_value(option_value const & other)
+        {
+            if (other.ops_) {
+                other.ops_->copy(&storage_, &other.storage_);
+                ops_ = other.ops_;
+            }
+        }
+
+        option_value(option_value && other) noexcept
+        {
+            take(other);
+        }
+
+        /** Makes an `option_value` that holds a `std::decay_t<T>` made from
+            `x`. */
+        template<typename T>
+        requires(!std::is_same_v<std::remove_cvref_t<T>, option_value>)
+        option_value(T && x)
+        {
+            construct<std::decay_t<T>>((T &&) x);
+        }
+
+        ~option_value() { reset(); }
+
+        option_value & operator=(option_value const & other)
+        {
+            if (this != &other)
+                *this = option_value(other);
+            return *this;
+        }
+
+        option_value & operator=(option_value && other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        /** Replaces the held value, if any, with a `std::decay_t<T>` made
+            from `x`. */
+        template<typename T>
+        requires(!std::is_same_v<std::remove_cvref_t<T>, option_value>)
+        option_value & operator=(T && x)
+        {
+            emplace<std::decay_t<T>>((T &&) x);
+            return *this;
+        }
+
+        /** Replaces the held value, if any, with a `T` made from `args`, and
+            returns a reference to it.  `args` may refer to the held value.
+            If making the `T` throws, `*this` is unchanged. */
+        template<typename T, typename... Args>
+        T & emplace(Args &&... args)
+        {
+            option_value temp;
+            temp.construct<T>((Args &&) args...);
+            reset();
+            take(temp);
+            return *static_cast<T *>(value_ptr<T>());
+        }
+
+        /** Returns true iff `*this` holds a value. */
+        bool has_value() const noexcept { return ops_ != nullptr; }
+
+        /** Destroys the held value, if any. */
+        void reset() noexcept
+        {
+            if (ops_) {
+                ops_->destroy(&storage_);
+                ops_ = nullptr;
+            }
+        }
+
+        /** Returns true iff `*this` holds a `T`. */
+        template<typename T>
+        bool holds() const noexcept
+        {
+            return ops_ == &detail::option_value_ops_for<T>::value;
+        }
+
+        /** Returns a pointer to the held value if it is a `T`, or `nullptr`
+            otherwise. */
+        template<typename T>
+        T * get_if() noexcept
+        {
+            if (!holds<T>())
+                return nullptr;
+            return static_cast<T *>(value_ptr<T>());
+        }
+
+        /** Returns a pointer to the held value if it is a `T`, or `nullptr`
+            otherwise. */
+        template<typename T>
+        T const * get_if() const noexcept
+        {
+            return const_cast<option_value &>(*this).get_if<T>();
+        }
+
+        friend bool
+        tag_invoke(tag_t<any_empty>, option_value const & v) noexcept
+        {
+            return !v.has_value();
+        }
+
+        template<typename T>
+        friend T tag_invoke(tag_t<any_cast<T>>, option_value & v, type_<T>)
+        {
+            return option_value::cast<T>(v);
+        }
+
+        template<typename T>
+        friend T
+        tag_invoke(tag_t<any_cast<T>>, option_value const & v, type_<T>)
+        {
+            static_assert(
+                !std::is_reference_v<T> ||
+                    std::is_const_v<std::remove_reference_t<T>>,
+                "A const option_value cannot be cast to a non-const "
+                "reference.");
+            return option_value::cast<T>(v);
+        }
+
+    private:
+        // Makes the held value; *this must be empty.
+        template<typename T, typename... Args>
+        void construct(Args &&... args)
+        {
+            static_assert(
+                std::is_same_v<T, std::decay_t<T>>,
+                "option_value may only hold non-reference, non-array, "
+                "unqualified types.");
+            static_assert(
+                std::is_copy_constructible_v<T>,
+                "option_value may only hold copyable types.");
+            if constexpr (detail::option_value_inline<T>)
+                ::new (&storage_) T((Args &&) args...);
+            else
+                storage_.ptr = new T((Args &&) args...);
+            ops_ = &detail::option_value_ops_for<T>::value;
+        }
+
+        template<typename T, typename OptionValue>
+        static T cast(OptionValue & v)
+        {
+            using value_type = std::remove_cvref_t<T>;
+            auto * const ptr = v.template get_if<value_type>();
+            if (!ptr)
+                BOOST_THROW_EXCEPTION(std::bad_any_cast());
+            return static_cast<T>(*ptr);
+        }
+
+        template<typename T>
+        void * value_ptr() noexcept
+        {
+            if constexpr (detail::option_value_inline<T>)
+                return &storage_;
+            else
+                return storage_.ptr;
+        }
+
+        void take(option_value & other) noexcept
+        {
+            if (other.ops_) {
+                other.ops_->relocate(&storage_, &other.storage_);
+                ops_ = std::exchange(other.ops_, nullptr);
+            }
+        }
+
+        union storage
+        {
+            void * ptr;
+            alignas(detail::option_value_buffer_alignment) unsigned char
+                buffer[detail::option_value_buffer_size];
+        };
+
+        storage storage_;
+        detail::option_value_ops const * ops_ = nullptr;
+    };
+
+    /** A `std::map` of `std::string`s to `option_value`s.  This is a type
+        appropriate for parsing options into, which, unlike `string_any_map`,
+        does not allocate for each `std::string` or `std::vector` value. */
+    using string_option_value_map = std::map<std::string, option_value>;
+
+}}
+
+#endif
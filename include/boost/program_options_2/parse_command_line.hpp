@@ -44,9 +44,11 @@ namespace boost { namespace program_options_2 {
         BOOST_ASSERT(args.begin() != args.end());
         detail::check_options(strings, opt, opts...);
 
-        bool const no_help = detail::no_help_option(opt, opts...);
+        detail::parse_tables<Option, Options...> const tables(
+            strings, opt, opts...);
+        auto const scanned = detail::scan_args(args, strings, tables);
 
-        if (no_help && detail::argv_contains_default_help_flag(strings, args)) {
+        if (tables.no_help && scanned.contains_default_help()) {
             detail::parse_contexts_vec const parse_contexts;
             detail::print_help_and_exit(
                 0,
@@ -61,7 +63,14 @@ namespace boost { namespace program_options_2 {
         }
 
         return detail::parse_options_as_tuple(
-            strings, args, program_desc, os, no_help, opt, opts...);
+            tables,
+            strings,
+            detail::parse_mode(),
+            scanned,
+            program_desc,
+            os,
+            opt,
+            opts...);
     }
 
     /** Parse `args` for the options `opt, opts...`, and return a tuple that
@@ -150,10 +159,11 @@ namespace boost { namespace program_options_2 {
         entry in `map` is `storage_name(o)`.  If an error occurs, or if the
         user requests help or version, output will be printed to `os` and the
         program will exit. The return code on exit will be `1` if an error
-        occurred, or `0` otherwise. */
+        occurred, or `0` otherwise.  In place of a map, `map` may be a
+        `typed_options` made from `opt, opts...`. */
     template<
         range_of_string_view<char> Args,
-        options_map OptionsMap,
+        options_storage OptionsMap,
         option_or_group Option,
         option_or_group... Options>
     void parse_command_line(
@@ -169,14 +179,27 @@ namespace boost { namespace program_options_2 {
         detail::check_options(strings, opt, opts...);
 
         if constexpr (detail::contains_commands<Option, Options...>()) {
+            static_assert(
+                options_map<OptionsMap>,
+                "Options that contain commands must be parsed into an "
+                "options map.");
             detail::parse_commands(
-                map, strings, args, program_desc, os, true, opt, opts...);
+                map,
+                strings,
+                detail::parse_mode(),
+                args,
+                program_desc,
+                os,
+                true,
+                opt,
+                opts...);
         } else {
-            bool const no_help = detail::no_help_option(opt, opts...);
+            detail::parse_tables<Option, Options...> const tables(
+                strings, opt, opts...);
+            auto const scanned = detail::scan_args(args, strings, tables);
 
             detail::parse_contexts_vec const parse_contexts;
-            if (no_help &&
-                detail::argv_contains_default_help_flag(strings, args)) {
+            if (tables.no_help && scanned.contains_default_help()) {
                 detail::print_help_and_exit(
                     0,
                     strings,
@@ -190,14 +213,13 @@ namespace boost { namespace program_options_2 {
             }
 
             detail::parse_options_into_map(
+                tables,
                 map,
                 strings,
-                false,
-                args,
+                detail::parse_mode(),
+                scanned,
                 program_desc,
                 os,
-                no_help,
-                true,
                 opt,
                 opts...);
         }
@@ -211,7 +233,7 @@ namespace boost { namespace program_options_2 {
         occurred, or `0` otherwise. */
     template<
         range_of_string_view<char> Args,
-        options_map OptionsMap,
+        options_storage OptionsMap,
         option_or_group Option,
         option_or_group... Options>
     void parse_command_line(
@@ -233,7 +255,7 @@ namespace boost { namespace program_options_2 {
         printed to `os` and the program will exit. The return code on exit
         will be `1` if an error occurred, or `0` otherwise. */
     template<
-        options_map OptionsMap,
+        options_storage OptionsMap,
         option_or_group Option,
         option_or_group... Options>
     void parse_command_line(
@@ -257,7 +279,7 @@ namespace boost { namespace program_options_2 {
         printed to `os` and the program will exit. The return code on exit
         will be `1` if an error occurred, or `0` otherwise. */
     template<
-        options_map OptionsMap,
+        options_storage OptionsMap,
         option_or_group Option,
         option_or_group... Options>
     void parse_command_line(
@@ -280,6 +302,183 @@ namespace boost { namespace program_options_2 {
     }
 
 
+    // non-exiting overloads
+
+    /** Parse `args` for the options `opt, opts...`, and return a
+        `parse_result` that contains a tuple of the results of the parse.
+        Each element of tuple corresponds one-to-one to `opt, opts...`
+        (except that grouping is ignored).  Unlike `parse_command_line()`,
+        this function never prints anything, and never exits; if an error
+        occurs, or if the user requests help or version, the parse stops, and
+        the returned `parse_result` says why.  Use `print_help()` to produce
+        the help message, if needed.  The given options must not contain any
+        commands. */
+    template<
+        range_of_string_view<char> Args,
+        option_or_group Option,
+        option_or_group... Options>
+    requires(!detail::contains_commands<Option, Options...>())
+        // clang-format off
+    auto try_parse_command_line(
+        Args const & args,
+        customizable_strings const & strings,
+        Option opt,
+        Options... opts)
+    // clang-format on
+    {
+        BOOST_ASSERT(args.begin() != args.end());
+        detail::check_options(strings, opt, opts...);
+        detail::parse_tables<Option, Options...> const tables(
+            strings, opt, opts...);
+        return detail::try_parse_options_as_tuple(
+            tables, strings, args, nullptr, opt, opts...);
+    }
+
+    /** Parse `args` for the options `opt, opts...`, and return a
+        `parse_result` that contains a tuple of the results of the parse.
+        Each element of tuple corresponds one-to-one to `opt, opts...`
+        (except that grouping is ignored).  Unlike `parse_command_line()`,
+        this function never prints anything, and never exits; if an error
+        occurs, or if the user requests help or version, the parse stops, and
+        the returned `parse_result` says why.  Use `print_help()` to produce
+        the help message, if needed.  The given options must not contain any
+        commands. */
+    template<
+        range_of_string_view<char> Args,
+        option_or_group Option,
+        option_or_group... Options>
+    requires(!detail::contains_commands<Option, Options...>())
+        // clang-format off
+    auto try_parse_command_line(
+        Args const & args,
+        Option opt,
+        Options... opts)
+    // clang-format on
+    {
+        return program_options_2::try_parse_command_line(
+            args, customizable_strings{}, opt, opts...);
+    }
+
+    /** Parse `args` for the options `opt, opts...`, and place the results of
+        the parse in `map`.  For any option `o`, the key for its associated
+        entry in `map` is `storage_name(o)`.  Unlike `parse_command_line()`,
+        this function never prints anything, and never exits; if an error
+        occurs, or if the user requests help or version, the parse stops, and
+        the returned `parse_status` says why.  Use `print_help()` to produce
+        the help message, if needed.  If the options contain commands, the
+        function associated with the matched command is called only if the
+        parse succeeds. */
+    template<
+        range_of_string_view<char> Args,
+        options_storage OptionsMap,
+        option_or_group Option,
+        option_or_group... Options>
+    parse_status try_parse_command_line(
+        Args const & args,
+        OptionsMap & map,
+        customizable_strings const & strings,
+        Option opt,
+        Options... opts)
+    {
+        BOOST_ASSERT(args.begin() != args.end());
+        detail::check_options(strings, opt, opts...);
+
+        if constexpr (detail::contains_commands<Option, Options...>()) {
+            static_assert(
+                options_map<OptionsMap>,
+                "Options that contain commands must be parsed into an "
+                "options map.");
+            parse_status retval;
+            std::ostream null_os(nullptr);
+            detail::parse_commands(
+                map,
+                strings,
+                detail::parse_mode(retval),
+                args,
+                std::string_view(),
+                null_os,
+                true,
+                opt,
+                opts...);
+            return retval;
+        } else {
+            detail::parse_tables<Option, Options...> const tables(
+                strings, opt, opts...);
+            return detail::try_parse_options_into_map(
+                tables,
+                map,
+                strings,
+                args,
+                detail::parse_mode(),
+                opt,
+                opts...);
+        }
+    }
+
+    /** Parse `args` for the options `opt, opts...`, and place the results of
+        the parse in `map`.  For any option `o`, the key for its associated
+        entry in `map` is `storage_name(o)`.  Unlike `parse_command_line()`,
+        this function never prints anything, and never exits; if an error
+        occurs, or if the user requests help or version, the parse stops, and
+        the returned `parse_status` says why.  Use `print_help()` to produce
+        the help message, if needed.  If the options contain commands, the
+        function associated with the matched command is called only if the
+        parse succeeds. */
+    template<
+        range_of_string_view<char> Args,
+        options_storage OptionsMap,
+        option_or_group Option,
+        option_or_group... Options>
+    parse_status try_parse_command_line(
+        Args const & args, OptionsMap & map, Option opt, Options... opts)
+    {
+        return program_options_2::try_parse_command_line(
+            args, map, customizable_strings{}, opt, opts...);
+    }
+
+    /** Prints the help message for the options `opt, opts...` to `os`,
+        exactly as `parse_command_line()` would print it if the user
+        requested help.  `argv0` is used to determine the program name.  For
+        options that contain commands, this is the top-level help message,
+        not the help for any particular command. */
+    template<option_or_group Option, option_or_group... Options>
+    void print_help(
+        std::ostream & os,
+        std::string_view argv0,
+        std::string_view program_desc,
+        customizable_strings const & strings,
+        Option opt,
+        Options... opts)
+    {
+        detail::parse_contexts_vec const parse_contexts;
+        detail::print_help(
+            strings,
+            os,
+            argv0,
+            program_desc,
+            detail::no_help_option(opt, opts...),
+            parse_contexts,
+            opt,
+            opts...);
+    }
+
+    /** Prints the help message for the options `opt, opts...` to `os`,
+        exactly as `parse_command_line()` would print it if the user
+        requested help.  `argv0` is used to determine the program name.  For
+        options that contain commands, this is the top-level help message,
+        not the help for any particular command. */
+    template<option_or_group Option, option_or_group... Options>
+    void print_help(
+        std::ostream & os,
+        std::string_view argv0,
+        std::string_view program_desc,
+        Option opt,
+        Options... opts)
+    {
+        program_options_2::print_help(
+            os, argv0, program_desc, customizable_strings{}, opt, opts...);
+    }
+
 #if defined(BOOST_PROGRAM_OPTIONS_2_DOXYGEN) || defined(_MSC_VER)
 
     // tuple overloads
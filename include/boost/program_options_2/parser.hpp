@@ -0,0 +1,362 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_PARSER_HPP
+#define BOOST_PROGRAM_OPTIONS_2_PARSER_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/arg_view.hpp>
+#include <boost/program_options_2/concepts.hpp>
+#include <boost/program_options_2/options.hpp>
+#include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/response_file_buffers.hpp>
+#include <boost/program_options_2/storage.hpp>
+#include <boost/program_options_2/detail/parsing.hpp>
+#include <boost/program_options_2/decorators.hpp>
+
+#include <memory>
+#include <memory_resource>
+
+
+namespace boost { namespace program_options_2 {
+
+    /** A parser for a fixed set of options.  All the work that depends only
+        on the options -- validating them, splitting their names, computing
+        their storage names, and so on -- is done once, on construction.
+        Each call to `parse()` does only the work that depends on the args
+        being parsed, so a single `parser` can be used to parse many command
+        lines.
+
+        The semantics of `parse()` are exactly those of the
+        `parse_command_line()` overloads that take the same arguments.  As
+        with those, if the options contain commands, the results must be
+        parsed into an options map; the names of the commands at each level
+        are indexed once, on construction. */
+    template<option_or_group... Options>
+    struct parser
+    {
+        parser(
+            std::string_view program_desc,
+            std::ostream & os,
+            customizable_strings const & strings,
+            Options const &... opts) :
+            program_desc_(program_desc),
+            os_(&os),
+            strings_(strings),
+            opts_(opts...),
+            tables_(strings, opts...)
+        {
+            detail::check_options(strings, opts...);
+            if (1 < strings.response_file_threads)
+                pool_ = std::make_shared<detail::thread_pool>();
+        }
+
+        /** Parse `args`, and return a tuple that contains the results of the
+            parse.  Each element of tuple corresponds one-to-one to the
+            options given on construction (except that grouping is
+            ignored). */
+        template<range_of_string_view<char> Args>
+        auto parse(Args const & args) const
+            requires(!detail::contains_commands<Options...>())
+        {
+            BOOST_ASSERT(args.begin() != args.end());
+            auto const scanned = detail::scan_args(args, strings_, tables_);
+            handle_default_help(scanned);
+            detail::parse_mode mode;
+            mode.pool = pool_.get();
+            return hana::unpack(opts_, [&](auto const &... opts) {
+                return detail::parse_options_as_tuple(
+                    tables_,
+                    strings_,
+                    mode,
+                    scanned,
+                    program_desc_,
+                    *os_,
+                    opts...);
+            });
+        }
+
+        /** Parse `[argv, argv + argc)`, and return a tuple that contains the
+            results of the parse.  Each element of tuple corresponds
+            one-to-one to the options given on construction (except that
+            grouping is ignored). */
+        auto parse(int argc, char const ** argv) const
+            requires(!detail::contains_commands<Options...>())
+        {
+            return parse(arg_view(argc, argv));
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  For
+            any option `o`, the key for its associated entry in `map` is
+            `storage_name(o)`. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        void parse(Args const & args, OptionsMap & map) const
+        {
+            parse(args, map, *std::pmr::get_default_resource());
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  For
+            any option `o`, the key for its associated entry in `map` is
+            `storage_name(o)`.
+
+            All the memory that the parse needs for itself -- a copy of
+            `args[0]`, the classification of each arg, the contents and
+            tokens of any response files, and so on -- is allocated from
+            `resource`, and is released before this function returns.  This
+            makes it practical to parse each of many command lines using a
+            `std::pmr::monotonic_buffer_resource` that is released after
+            each parse.  The values placed in `map` are allocated the way
+            `map` allocates them, not from `resource`. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        void parse(
+            Args const & args,
+            OptionsMap & map,
+            std::pmr::memory_resource & resource) const
+        {
+            detail::parse_mode mode;
+            mode.resource = &resource;
+            parse_into(args, map, mode);
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  For
+            any option `o`, the key for its associated entry in `map` is
+            `storage_name(o)`.  The contents of the response files read by
+            the parse are kept in `buffers`, so that `std::string_view`
+            values in `map` that came from them remain valid for as long as
+            `buffers` does. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        void parse(
+            Args const & args,
+            OptionsMap & map,
+            response_file_buffers & buffers) const
+        {
+            detail::parse_mode mode;
+            mode.buffers = &buffers;
+            parse_into(args, map, mode);
+        }
+
+        /** Parse `[argv, argv + argc)`, and place the results of the parse in
+            `map`.  For any option `o`, the key for its associated entry in
+            `map` is `storage_name(o)`. */
+        template<options_storage OptionsMap>
+        void parse(int argc, char const ** argv, OptionsMap & map) const
+        {
+            parse(arg_view(argc, argv), map);
+        }
+
+        /** Parse `args`, and return a `parse_result` that contains a tuple of
+            the results of the parse.  Like `try_parse_command_line()`, this
+            never prints anything and never exits. */
+        template<range_of_string_view<char> Args>
+        auto try_parse(Args const & args) const
+            requires(!detail::contains_commands<Options...>())
+        {
+            BOOST_ASSERT(args.begin() != args.end());
+            return hana::unpack(opts_, [&](auto const &... opts) {
+                return detail::try_parse_options_as_tuple(
+                    tables_, strings_, args, pool_.get(), opts...);
+            });
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  Like
+            `try_parse_command_line()`, this never prints anything and never
+            exits. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        parse_status try_parse(Args const & args, OptionsMap & map) const
+        {
+            return try_parse(args, map, *std::pmr::get_default_resource());
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  Like
+            `try_parse_command_line()`, this never prints anything and never
+            exits.  The memory that the parse needs for itself is allocated
+            from `resource`, as with the overload of `parse()` that takes a
+            `std::pmr::memory_resource`. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        parse_status try_parse(
+            Args const & args,
+            OptionsMap & map,
+            std::pmr::memory_resource & resource) const
+        {
+            detail::parse_mode mode;
+            mode.resource = &resource;
+            return try_parse_into(args, map, mode);
+        }
+
+        /** Parse `args`, and place the results of the parse in `map`.  Like
+            `try_parse_command_line()`, this never prints anything and never
+            exits.  The contents of the response files read by the parse are
+            kept in `buffers`, as with the overload of `parse()` that takes a
+            `response_file_buffers`. */
+        template<range_of_string_view<char> Args, options_storage OptionsMap>
+        parse_status try_parse(
+            Args const & args,
+            OptionsMap & map,
+            response_file_buffers & buffers) const
+        {
+            detail::parse_mode mode;
+            mode.buffers = &buffers;
+            return try_parse_into(args, map, mode);
+        }
+
+        /** Prints the help message to the output stream given on
+            construction.  `argv0` is used to determine the program name. */
+        void print_help(std::string_view argv0) const
+        {
+            hana::unpack(opts_, [&](auto const &... opts) {
+                program_options_2::print_help(
+                    *os_, argv0, program_desc_, strings_, opts...);
+            });
+        }
+
+    private:
+        template<typename Args, typename OptionsMap>
+        void parse_into(
+            Args const & args,
+            OptionsMap & map,
+            detail::parse_mode mode) const
+        {
+            BOOST_ASSERT(args.begin() != args.end());
+            mode.pool = pool_.get();
+            if constexpr (detail::contains_commands<Options...>()) {
+                static_assert(
+                    options_map<OptionsMap>,
+                    "Options that contain commands must be parsed into an "
+                    "options map.");
+                hana::unpack(opts_, [&](auto const &... opts) {
+                    detail::parse_commands(
+                        tables_,
+                        map,
+                        strings_,
+                        mode,
+                        args,
+                        program_desc_,
+                        *os_,
+                        true,
+                        opts...);
+                });
+            } else {
+                auto const scanned =
+                    detail::scan_args(args, strings_, tables_, mode.resource);
+                handle_default_help(scanned);
+                hana::unpack(opts_, [&](auto const &... opts) {
+                    detail::parse_options_into_map(
+                        tables_,
+                        map,
+                        strings_,
+                        mode,
+                        scanned,
+                        program_desc_,
+                        *os_,
+                        opts...);
+                });
+            }
+        }
+
+        template<typename Args, typename OptionsMap>
+        parse_status try_parse_into(
+            Args const & args,
+            OptionsMap & map,
+            detail::parse_mode mode) const
+        {
+            BOOST_ASSERT(args.begin() != args.end());
+            mode.pool = pool_.get();
+            if constexpr (detail::contains_commands<Options...>()) {
+                static_assert(
+                    options_map<OptionsMap>,
+                    "Options that contain commands must be parsed into an "
+                    "options map.");
+                parse_status retval;
+                mode.status = &retval;
+                std::ostream null_os(nullptr);
+                hana::unpack(opts_, [&](auto const &... opts) {
+                    detail::parse_commands(
+                        tables_,
+                        map,
+                        strings_,
+                        mode,
+                        args,
+                        std::string_view(),
+                        null_os,
+                        true,
+                        opts...);
+                });
+                return retval;
+            } else {
+                return hana::unpack(opts_, [&](auto const &... opts) {
+                    return detail::try_parse_options_into_map(
+                        tables_, map, strings_, args, mode, opts...);
+                });
+            }
+        }
+
+        template<typename Args>
+        void handle_default_help(detail::scanned_args<Args> const & args) const
+        {
+            if (tables_.no_help && args.contains_default_help()) {
+                detail::parse_contexts_vec const parse_contexts;
+                hana::unpack(opts_, [&](auto const &... opts) {
+                    detail::print_help_and_exit(
+                        0,
+                        strings_,
+                        *args.begin(),
+                        program_desc_,
+                        *os_,
+                        true,
+                        parse_contexts,
+                        opts...);
+                });
+            }
+        }
+
+        std::string_view program_desc_;
+        std::ostream * os_;
+        customizable_strings strings_;
+        hana::tuple<Options...> opts_;
+        std::conditional_t<
+            detail::contains_commands<Options...>(),
+            detail::command_tables,
+            detail::parse_tables<Options...>>
+            tables_;
+        // The threads that help read response files, if
+        // strings_.response_file_threads calls for any.  Shared by copies of
+        // this parser.
+        std::shared_ptr<detail::thread_pool> pool_;
+    };
+
+    /** Returns a `parser` for the options `opt, opts...`.  Output will be
+        printed to `os` if an error occurs, or if the user requests help or
+        version.  If the given options contain commands, the parser can only
+        parse into an options map. */
+    template<option_or_group Option, option_or_group... Options>
+    auto make_parser(
+        std::string_view program_desc,
+        std::ostream & os,
+        customizable_strings const & strings,
+        Option opt,
+        Options... opts)
+    {
+        return parser<Option, Options...>(
+            program_desc, os, strings, opt, opts...);
+    }
+
+    /** Returns a `parser` for the options `opt, opts...`.  Output will be
+        printed to `os` if an error occurs, or if the user requests help or
+        version.  If the given options contain commands, the parser can only
+        parse into an options map. */
+    template<option_or_group Option, option_or_group... Options>
+    auto make_parser(
+        std::string_view program_desc,
+        std::ostream & os,
+        Option opt,
+        Options... opts)
+    {
+        return parser<Option, Options...>(
+            program_desc, os, customizable_strings{}, opt, opts...);
+    }
+
+}}
+
+#endif
@@ -0,0 +1,205 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_RESPONSE_FILE_BUFFERS_HPP
+#define BOOST_PROGRAM_OPTIONS_2_RESPONSE_FILE_BUFFERS_HPP
+
+#include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/detail/response_files.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <vector>
+
+
+namespace boost { namespace program_options_2 {
+
+    namespace detail {
+        response_file_cache &
+        kept_response_file_cache(response_file_buffers & buffers);
+
+        template<typename Values>
+        void release_unreferenced_response_files(
+            response_file_buffers & buffers, Values const & values);
+    }
+
+    /** Owns the contents of the response files read by each parse that it is
+        given to, for as long as it lives.  Ordinarily, a response file's
+        contents are released when the parse that read them ends, so any
+        `std::string_view` result that came from a response file (a
+        `std::string_view` option, or a container of them) is left
+        dangling.  When the parse is given a `response_file_buffers`, such a
+        result refers into the file's contents kept here instead -- the
+        mapped file itself, or the buffer the file was read into, or, for an
+        arg that needed unescaping, the unescaped copy -- and so it stays
+        valid for as long as the `response_file_buffers` does.  No result is
+        copied to make this so.
+
+        A `typed_options` owns one of these, and uses it for every parse
+        into it.  After each parse or load into a `typed_options`, the
+        contents kept for earlier parses that none of its values refer to
+        any longer are released, so parsing into the same `typed_options`
+        over and over does not accumulate files.
+
+        To use one with an options map, keep it alongside the map for as
+        long as the map's values are used.  Since the values in a map
+        cannot be inspected this way, nothing is released until you call
+        `clear()`; a `response_file_buffers` given to many parses keeps the
+        contents of every file that each of them read.  Copies share the
+        contents they keep, so a copy of a `typed_options` stays valid for
+        as long as it lives, too. */
+    struct response_file_buffers
+    {
+        /** Returns the number of response files whose contents are kept.  A
+            file read by more than one parse is counted once for each. */
+        std::size_t size() const
+        {
+            std::size_t retval = 0;
+            for (auto const & cache : caches_) {
+                retval += cache->size();
+            }
+            return retval;
+        }
+
+        /** Returns `size() == 0u`. */
+        bool empty() const { return size() == 0u; }
+
+        /** Releases the contents of all the response files kept, unless a
+            copy of `*this` keeps them too.  Any `std::string_view` results
+            that refer to released contents are left dangling. */
+        void clear() { caches_.clear(); }
+
+    private:
+        // Returns the cache a single parse reads its response files into.
+        // The cache keeps the unescaped copies of its files' tokens, since
+        // results may refer to them.  An empty cache left by an earlier
+        // parse is reused, unless a copy shares it.  The memory of each kept file comes from the default
+        // resource, since the one given to the parse may not live as long
+        // as this.
+        detail::response_file_cache & new_cache()
+        {
+            if (caches_.empty() || caches_.back()->size() ||
+                caches_.back().use_count() != 1) {
+                caches_.push_back(
+                    std::make_shared<detail::response_file_cache>(
+                        std::pmr::get_default_resource(), true));
+            }
+            return *caches_.back();
+        }
+
+        // Releases each kept cache that is not in use by a parse, and that
+        // none of the std::string_views passed to the callback given to
+        // for_each_view refers into.
+        template<typename ForEachView>
+        void release_unreferenced(ForEachView const & for_each_view)
+        {
+            if (caches_.empty())
+                return;
+
+            struct buffer
+            {
+                char const * first;
+                char const * last;
+                std::size_t cache;
+            };
+            std::vector<buffer> buffers;
+            for (std::size_t i = 0; i < caches_.size(); ++i) {
+                caches_[i]->for_each_buffer([&](std::string_view b) {
+                    if (!b.empty())
+                        buffers.push_back({b.data(), b.data() + b.size(), i});
+                });
+            }
+            std::less<char const *> const less{};
+            std::sort(
+                buffers.begin(),
+                buffers.end(),
+                [&](buffer const & lhs, buffer const & rhs) {
+                    return less(lhs.first, rhs.first);
+                });
+
+            std::vector<bool> referenced(caches_.size());
+            for_each_view([&](std::string_view v) {
+                if (v.empty())
+                    return;
+                auto it = std::upper_bound(
+                    buffers.begin(),
+                    buffers.end(),
+                    v.data(),
+                    [&](char const * p, buffer const & b) {
+                        return less(p, b.first);
+                    });
+                if (it == buffers.begin())
+                    return;
+                --it;
+                if (less(v.data(), it->last))
+                    referenced[it->cache] = true;
+            });
+
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < caches_.size(); ++i) {
+                if (referenced[i] || caches_[i]->expanding())
+                    caches_[kept++] = std::move(caches_[i]);
+            }
+            caches_.erase(caches_.begin() + kept, caches_.end());
+        }
+
+        std::vector<std::shared_ptr<detail::response_file_cache>> caches_;
+
+        friend detail::response_file_cache &
+        detail::kept_response_file_cache(response_file_buffers & buffers);
+
+        template<typename Values>
+        friend void detail::release_unreferenced_response_files(
+            response_file_buffers & buffers, Values const & values);
+    };
+
+    namespace detail {
+        inline response_file_cache &
+        kept_response_file_cache(response_file_buffers & buffers)
+        {
+            return buffers.new_cache();
+        }
+
+        // Calls f with each std::string_view in value, which may be a
+        // std::string_view, or an optional or container of them.
+        template<typename T, typename F>
+        void for_each_string_view(T const & value, F const & f)
+        {
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                f(value);
+            } else if constexpr (is_optional<T>::value) {
+                if (value)
+                    detail::for_each_string_view(*value, f);
+            } else if constexpr (std::ranges::range<T>) {
+                if constexpr (std::is_same_v<
+                                  std::ranges::range_value_t<T>,
+                                  std::string_view>) {
+                    for (auto v : value) {
+                        f(v);
+                    }
+                }
+            }
+        }
+
+        // Releases the contents kept in buffers that no std::string_view
+        // in values, a hana::tuple of option values, refers to.
+        template<typename Values>
+        void release_unreferenced_response_files(
+            response_file_buffers & buffers, Values const & values)
+        {
+            buffers.release_unreferenced([&](auto const & f) {
+                hana::for_each(values, [&](auto const & value) {
+                    detail::for_each_string_view(value, f);
+                });
+            });
+        }
+    }
+
+}}
+
+#endif
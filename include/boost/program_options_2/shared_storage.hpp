@@ -0,0 +1,624 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_SHARED_STORAGE_HPP
+#define BOOST_PROGRAM_OPTIONS_2_SHARED_STORAGE_HPP
+
+#include <boost/program_options_2/storage.hpp>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_SHARED_MEMORY
+
+#include <algorithm>
+#include <any>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace boost { namespace program_options_2 {
+
+    namespace detail {
+        // The layout of a block written by publish_shared_options() is:
+        //
+        //   "PO2S"
+        //   format version           std::uint32_t
+        //   block size               std::uint64_t
+        //   entry count              std::uint64_t
+        //   entries, sorted by name  shared_entry[entry count]
+        //   names
+        //   values, each aligned to 8 bytes
+        //
+        // Offsets are from the start of the block, so that it means the
+        // same thing wherever it is mapped.  Each value is encoded as by
+        // binary_append().
+        constexpr std::string_view shared_magic = "PO2S";
+        constexpr std::uint32_t shared_format_version = 1;
+        constexpr std::size_t shared_header_size = 24;
+        constexpr std::size_t shared_value_alignment = 8;
+
+        struct shared_entry
+        {
+            std::uint64_t name_offset;
+            std::uint64_t name_size;
+            std::uint64_t type;
+            std::uint64_t value_offset;
+            std::uint64_t value_size;
+        };
+
+        template<typename T>
+        std::uint64_t binary_type_fingerprint()
+        {
+            binary_fingerprint fp;
+            detail::add_binary_type<T>(fp);
+            return fp.value;
+        }
+
+        template<typename T>
+        struct is_const_span : std::false_type
+        {};
+        template<typename T>
+        struct is_const_span<std::span<T const>> : std::true_type
+        {};
+
+        // Returns true if a value stored with the given type can be read as
+        // a T by shared_options::get().
+        template<typename T>
+        bool shared_type_matches(std::uint64_t type)
+        {
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                return type == detail::binary_type_fingerprint<T>() ||
+                       type == detail::binary_type_fingerprint<std::string>();
+            } else if constexpr (is_const_span<T>::value) {
+                using value_type = typename T::value_type;
+                return type == detail::binary_type_fingerprint<
+                                   std::vector<value_type>>();
+            } else {
+                return type == detail::binary_type_fingerprint<T>();
+            }
+        }
+
+        struct shared_block_builder
+        {
+            template<typename T>
+            void add(std::string_view name, T const & value)
+            {
+                values_.push_back({name, binary_type_fingerprint<T>(), {}});
+                detail::binary_append(values_.back().bytes, value);
+            }
+
+            std::string finish()
+            {
+                std::ranges::sort(values_, {}, &value::name);
+
+                std::size_t names_size = 0;
+                for (auto const & v : values_) {
+                    names_size += v.name.size();
+                }
+                auto const entries_offset = shared_header_size;
+                auto const names_offset =
+                    entries_offset + values_.size() * sizeof(shared_entry);
+                auto value_offset = aligned(names_offset + names_size);
+                auto name_offset = names_offset;
+
+                std::vector<shared_entry> entries;
+                entries.reserve(values_.size());
+                for (auto const & v : values_) {
+                    entries.push_back(
+                        {name_offset,
+                         v.name.size(),
+                         v.type,
+                         value_offset,
+                         v.bytes.size()});
+                    name_offset += v.name.size();
+                    value_offset = aligned(value_offset + v.bytes.size());
+                }
+
+                std::string retval(value_offset, '\0');
+                char * const p = retval.data();
+                std::memcpy(p, shared_magic.data(), shared_magic.size());
+                std::memcpy(p + 4, &shared_format_version, 4);
+                std::uint64_t const size = retval.size();
+                std::uint64_t const count = entries.size();
+                std::memcpy(p + 8, &size, 8);
+                std::memcpy(p + 16, &count, 8);
+                if (!entries.empty()) {
+                    std::memcpy(
+                        p + entries_offset,
+                        entries.data(),
+                        entries.size() * sizeof(shared_entry));
+                }
+                for (std::size_t i = 0; i < entries.size(); ++i) {
+                    auto const & v = values_[i];
+                    std::memcpy(
+                        p + entries[i].name_offset,
+                        v.name.data(),
+                        v.name.size());
+                    std::memcpy(
+                        p + entries[i].value_offset,
+                        v.bytes.data(),
+                        v.bytes.size());
+                }
+                return retval;
+            }
+
+        private:
+            static std::size_t aligned(std::size_t n)
+            {
+                return (n + shared_value_alignment - 1) &
+                       ~(shared_value_alignment - 1);
+            }
+
+            struct value
+            {
+                std::string_view name;
+                std::uint64_t type;
+                std::string bytes;
+            };
+
+            std::vector<value> values_;
+        };
+
+        template<typename OptionsMap, typename OptTuple>
+        std::string shared_block(
+            OptionsMap const & m,
+            customizable_strings const & strings,
+            OptTuple const & opt_tuple)
+        {
+            shared_block_builder builder;
+            detail::storage_lookup<OptionsMap const, OptTuple> lookup(
+                m, strings, opt_tuple);
+            detail::for_each_binary_option(
+                opt_tuple, [&](auto const & opt, auto i) {
+                    using opt_type = std::remove_cvref_t<decltype(opt)>;
+                    using type = typename opt_type::type;
+
+                    auto const name =
+                        program_options_2::storage_name(opt, strings);
+                    type const * value = nullptr;
+                    try {
+                        value = lookup.template value<type>(opt, i);
+                    } catch (...) {
+                        BOOST_THROW_EXCEPTION(
+                            save_error(save_result::bad_any_cast, name));
+                    }
+                    if (value)
+                        builder.add(name, *value);
+                });
+            return builder.finish();
+        }
+
+        template<typename... Ts, typename OptTuple>
+        std::string shared_block(
+            hana::tuple<Ts...> const & results,
+            customizable_strings const & strings,
+            OptTuple const & opt_tuple)
+        {
+            shared_block_builder builder;
+            auto const indices =
+                hana::make_range(hana::size_c<0>, hana::size(opt_tuple));
+            hana::for_each(indices, [&](auto i) {
+                auto const & opt = opt_tuple[i];
+                using opt_type = std::remove_cvref_t<decltype(opt)>;
+                static_assert(
+                    !group_<opt_type>,
+                    "To publish a tuple of results with "
+                    "publish_shared_options(), the options must not contain "
+                    "mutually exclusive groups or commands.  Use a map "
+                    "instead.");
+                if constexpr (detail::binary_stored<opt_type>()) {
+                    using type = typename opt_type::type;
+                    static_assert(
+                        detail::binary_encodable<type>(),
+                        "To use publish_shared_options(), all options must "
+                        "have a type that is a string, trivially copyable, or "
+                        "an optional or insertable container of such types.");
+                    auto const & result = results[i];
+                    using result_type = std::remove_cvref_t<decltype(result)>;
+                    auto const name =
+                        program_options_2::storage_name(opt, strings);
+                    if constexpr (
+                        !std::is_same_v<result_type, type> &&
+                        std::is_same_v<result_type, std::optional<type>>) {
+                        if (result)
+                            builder.add(name, *result);
+                    } else {
+                        builder.add(name, result);
+                    }
+                }
+            });
+            return builder.finish();
+        }
+
+        // Puts block into a new shared memory object, named shm_name or, if
+        // shm_name is empty, anonymous.  Returns a read-only file descriptor
+        // for it, or -1 on failure.
+        inline int
+        create_shared_memory(std::string_view shm_name, std::string_view block)
+        {
+            bool const anonymous = shm_name.empty();
+            std::string name(shm_name);
+            int fd = -1;
+            bool sealable = false;
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+            if (anonymous) {
+                fd = ::memfd_create(
+                    "boost_program_options_2", MFD_ALLOW_SEALING);
+                sealable = 0 <= fd;
+            }
+#endif
+            if (fd < 0) {
+                if (anonymous) {
+                    name =
+                        detail::temporary_file_name("/boost_program_options_2");
+                }
+                // Only the returned read-only descriptor is used once this
+                // one is closed, so no one gets to write to the object.
+                fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0444);
+                if (fd < 0)
+                    return -1;
+            }
+
+            bool written = ::ftruncate(fd, block.size()) == 0;
+            if (written && !block.empty()) {
+                void * const p = ::mmap(
+                    nullptr, block.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+                written = p != MAP_FAILED;
+                if (written) {
+                    std::memcpy(p, block.data(), block.size());
+                    ::munmap(p, block.size());
+                }
+            }
+
+            if (sealable) {
+#if defined(F_ADD_SEALS)
+                written = written &&
+                          ::fcntl(
+                              fd,
+                              F_ADD_SEALS,
+                              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE |
+                                  F_SEAL_SEAL) == 0;
+#endif
+                if (!written) {
+                    ::close(fd);
+                    return -1;
+                }
+                return fd;
+            }
+
+            int const read_only_fd =
+                written ? ::shm_open(name.c_str(), O_RDONLY, 0) : -1;
+            ::close(fd);
+            if (anonymous || read_only_fd < 0)
+                ::shm_unlink(name.c_str());
+            if (anonymous && 0 <= read_only_fd) {
+                // Like a memfd, the descriptor for an anonymous object is
+                // the only way to share it, so let it survive exec().
+                int const flags = ::fcntl(read_only_fd, F_GETFD);
+                ::fcntl(read_only_fd, F_SETFD, flags & ~FD_CLOEXEC);
+            }
+            return read_only_fd;
+        }
+    }
+
+    /** A read-only view of the options published by
+        `publish_shared_options()`, mapped from shared memory.  Looking up a
+        value involves no parsing, and all processes that map the same
+        published options share the same memory.  A process that is forked
+        after a `shared_options` is created can simply keep using it; other
+        processes can create their own from the name, or from a copy of the
+        file descriptor. */
+    struct shared_options
+    {
+        shared_options() = default;
+
+        /** Maps the published options referred to by `fd`, and takes
+            ownership of `fd`.
+
+            \throws `load_error` if `fd` does not refer to published
+            options. */
+        explicit shared_options(int fd) : fd_(fd)
+        {
+            if (!map()) {
+                reset();
+                BOOST_THROW_EXCEPTION(
+                    load_error(load_result::malformed_binary, ""));
+            }
+        }
+
+        shared_options(shared_options && other) noexcept { swap(other); }
+        shared_options & operator=(shared_options && other) noexcept
+        {
+            shared_options temp(std::move(other));
+            swap(temp);
+            return *this;
+        }
+
+        ~shared_options() { reset(); }
+
+        /** Returns the file descriptor for the shared memory, or -1 if
+            there is none.  A process can pass the options on to another by
+            passing a copy of this descriptor. */
+        int fd() const { return fd_; }
+
+        /** Returns all the mapped memory. */
+        std::string_view block() const
+        {
+            return std::string_view(map_, map_ ? size_ : 0);
+        }
+
+        /** Returns the number of options that have values. */
+        std::size_t size() const { return count_; }
+
+        /** Returns true iff there is a value for the option whose
+            `storage_name()` is `name`. */
+        bool contains(std::string_view name) const
+        {
+            return find(name) != nullptr;
+        }
+
+        /** Returns the value for the option whose `storage_name()` is
+            `name`, or `std::nullopt` if there is none.  `T` must be the
+            type of the option, except that a `std::string_view` may be used
+            for a `std::string` option, and a `std::span<U const>` for an
+            option whose type is a contiguous container of trivially
+            copyable `U`s (like `std::vector<int>`).  Those refer directly
+            into the shared memory, and so are never copied.
+
+            \throws `std::bad_any_cast` if `T` is the wrong type. */
+        template<typename T>
+        std::optional<T> get(std::string_view name) const
+        {
+            char const * const entry_ptr = find(name);
+            if (!entry_ptr)
+                return std::nullopt;
+            detail::shared_entry entry;
+            std::memcpy(&entry, entry_ptr, sizeof(entry));
+            if (!detail::shared_type_matches<T>(entry.type))
+                BOOST_THROW_EXCEPTION(std::bad_any_cast());
+
+            char const * const first = map_ + entry.value_offset;
+            if constexpr (detail::is_const_span<T>::value) {
+                using value_type = typename T::value_type;
+                static_assert(
+                    detail::binary_raw<value_type>() &&
+                        alignof(value_type) <= detail::shared_value_alignment,
+                    "Only options whose elements are stored as their bytes "
+                    "can be read as a std::span.");
+                std::uint64_t n = 0;
+                if (entry.value_size < sizeof(n)) {
+                    BOOST_THROW_EXCEPTION(
+                        load_error(load_result::malformed_binary, name));
+                }
+                std::memcpy(&n, first, sizeof(n));
+                if ((entry.value_size - sizeof(n)) / sizeof(value_type) < n) {
+                    BOOST_THROW_EXCEPTION(
+                        load_error(load_result::malformed_binary, name));
+                }
+                return T((value_type const *)(first + sizeof(n)), n);
+            } else {
+                detail::binary_reader reader{first, first + entry.value_size};
+                T value{};
+                if (!reader.read(value)) {
+                    BOOST_THROW_EXCEPTION(
+                        load_error(load_result::malformed_binary, name));
+                }
+                return value;
+            }
+        }
+
+    private:
+        bool map()
+        {
+            struct stat st;
+            if (fd_ < 0 || ::fstat(fd_, &st) != 0 || !st.st_size)
+                return false;
+            size_ = (std::size_t)st.st_size;
+            void * const p =
+                ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+            if (p == MAP_FAILED)
+                return false;
+            map_ = (char const *)p;
+            return valid();
+        }
+
+        std::uint64_t read_u64(std::size_t offset) const
+        {
+            std::uint64_t retval = 0;
+            std::memcpy(&retval, map_ + offset, sizeof(retval));
+            return retval;
+        }
+
+        // Checks every offset in the block once, so that lookups need not.
+        bool valid()
+        {
+            using detail::shared_entry;
+            if (size_ < detail::shared_header_size ||
+                std::string_view(map_, 4) != detail::shared_magic) {
+                return false;
+            }
+            std::uint32_t version = 0;
+            std::memcpy(&version, map_ + 4, sizeof(version));
+            if (version != detail::shared_format_version ||
+                read_u64(8) != size_) {
+                return false;
+            }
+            count_ = read_u64(16);
+            auto const entries_size = size_ - detail::shared_header_size;
+            if (entries_size / sizeof(shared_entry) < count_)
+                return false;
+            auto in_bounds = [this](std::uint64_t offset, std::uint64_t n) {
+                return offset <= size_ && n <= size_ - offset;
+            };
+            std::string_view prev_name;
+            for (std::size_t i = 0; i < count_; ++i) {
+                shared_entry entry;
+                std::memcpy(&entry, entry_at(i), sizeof(entry));
+                if (!in_bounds(entry.name_offset, entry.name_size) ||
+                    !in_bounds(entry.value_offset, entry.value_size) ||
+                    entry.value_offset % detail::shared_value_alignment ||
+                    entry.value_size < sizeof(std::uint8_t)) {
+                    return false;
+                }
+                std::string_view const name(
+                    map_ + entry.name_offset, entry.name_size);
+                if (i && name <= prev_name)
+                    return false;
+                prev_name = name;
+            }
+            return true;
+        }
+
+        char const * entry_at(std::size_t i) const
+        {
+            return map_ + detail::shared_header_size +
+                   i * sizeof(detail::shared_entry);
+        }
+
+        std::string_view name_at(std::size_t i) const
+        {
+            auto const entry = entry_at(i);
+            std::uint64_t offset = 0;
+            std::uint64_t size = 0;
+            std::memcpy(&offset, entry, sizeof(offset));
+            std::memcpy(&size, entry + sizeof(offset), sizeof(size));
+            return std::string_view(map_ + offset, size);
+        }
+
+        char const * find(std::string_view name) const
+        {
+            std::size_t first = 0;
+            std::size_t n = count_;
+            while (0 < n) {
+                auto const half = n / 2;
+                if (name_at(first + half) < name) {
+                    first += half + 1;
+                    n -= half + 1;
+                } else {
+                    n = half;
+                }
+            }
+            if (first == count_ || name_at(first) != name)
+                return nullptr;
+            return entry_at(first);
+        }
+
+        void reset()
+        {
+            if (map_)
+                ::munmap((void *)map_, size_);
+            if (0 <= fd_)
+                ::close(fd_);
+            fd_ = -1;
+            map_ = nullptr;
+            size_ = 0;
+            count_ = 0;
+        }
+
+        void swap(shared_options & other)
+        {
+            std::swap(fd_, other.fd_);
+            std::swap(map_, other.map_);
+            std::swap(size_, other.size_);
+            std::swap(count_, other.count_);
+        }
+
+        int fd_ = -1;
+        char const * map_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t count_ = 0;
+    };
+
+    /** Lays out the values in `result` for the options in `opts` in a
+        single read-only block of shared memory, and returns a view of it.
+        `result` may be an options map, a `typed_options`, or a tuple of
+        results, as produced by the tuple-returning overloads of
+        `parse_command_line()`.  Each value can be looked up using the
+        `storage_name()` of its option.  Only options with a type that
+        `save_binary_file()` accepts may be used.
+
+        If `shm_name` is empty, the shared memory is anonymous (a sealed
+        `memfd` where available), and can be shared only through the
+        returned object's file descriptor, which is inherited by child
+        processes, even across `exec()`.  Otherwise, it is a POSIX shared
+        memory object named `shm_name` that any process with permission can
+        open with `open_shared_options()`, until it is removed with
+        `remove_shared_options()`.
+
+        \note When you customize the `short_option_prefix`,
+        `long_option_prefix`, or `response_file_prefix` members of
+        `customizable_strings`, you must pass your custom
+        `customizable_strings` here, even thought it is possible to call
+        another overload of this function without it.
+
+        \throws `save_error` on failure */
+    template<typename Result, typename... Options>
+    shared_options publish_shared_options(
+        std::string_view shm_name,
+        Result const & result,
+        customizable_strings const & strings,
+        Options const &... opts)
+    {
+        auto const block = detail::shared_block(
+            result, strings, detail::make_opt_tuple(opts...));
+        int const fd = detail::create_shared_memory(shm_name, block);
+        if (fd < 0) {
+            BOOST_THROW_EXCEPTION(save_error(
+                save_result::could_not_open_file_for_writing, shm_name));
+        }
+        return shared_options(fd);
+    }
+
+    /** Lays out the values in `result` for the options in `opts` in a
+        single read-only block of shared memory, and returns a view of it.
+
+        \see The overload of `publish_shared_options()` that takes a
+        `customizable_strings`.
+
+        \throws `save_error` on failure */
+    template<typename Result, typename... Options>
+    shared_options publish_shared_options(
+        std::string_view shm_name,
+        Result const & result,
+        Options const &... opts)
+    {
+        return program_options_2::publish_shared_options(
+            shm_name, result, customizable_strings{}, opts...);
+    }
+
+    /** Maps the options published under the name `shm_name` by
+        `publish_shared_options()`.
+
+        \throws `load_error` on failure */
+    inline shared_options open_shared_options(std::string_view shm_name)
+    {
+        std::string const name(shm_name);
+        int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            BOOST_THROW_EXCEPTION(load_error(
+                load_result::could_not_open_file_for_reading, shm_name));
+        }
+        return shared_options(fd);
+    }
+
+    /** Removes the name `shm_name` of options published by
+        `publish_shared_options()`.  Processes that have already mapped the
+        options can keep using them.  Returns false if there was no such
+        name. */
+    inline bool remove_shared_options(std::string_view shm_name)
+    {
+        std::string const name(shm_name);
+        return ::shm_unlink(name.c_str()) == 0;
+    }
+
+}}
+
+#endif
+
+#endif
@@ -7,13 +7,20 @@
 #define BOOST_PROGRAM_OPTIONS_2_STORAGE_HPP
 
 #include <boost/program_options_2/fwd.hpp>
+#include <boost/program_options_2/detail/atomic_file.hpp>
+#include <boost/program_options_2/detail/binary.hpp>
+#include <boost/program_options_2/detail/json.hpp>
 #include <boost/program_options_2/detail/parsing.hpp>
 #include <boost/program_options_2/detail/utility.hpp>
 
 #include <boost/throw_exception.hpp>
 #include <boost/type_traits/is_detected.hpp>
 
+#include <bit>
+#include <cstring>
 #include <exception>
+#include <optional>
+#include <sstream>
 
 
 namespace boost { namespace program_options_2 {
@@ -94,12 +101,35 @@ namespace boost { namespace program_options_2 {
             choices specified for its associated option. */
         no_such_choice = (int)detail::parse_option_error::no_such_choice,
 
+        /** A response file referred to itself, directly or indirectly. */
+        response_file_cycle =
+            (int)detail::parse_option_error::response_file_cycle,
+
+        /** Response files were nested more deeply than
+            `customizable_strings::max_response_file_depth` allows. */
+        response_files_nested_too_deeply =
+            (int)detail::parse_option_error::response_files_nested_too_deeply,
+
+        /** A response file referred to by the input could not be read. */
+        cannot_read_response_file =
+            (int)detail::parse_option_error::cannot_read_response_file,
+
         /** At least one value that was loaded failed a validation check for
             its associated option. */
         validation_error = (int)detail::parse_option_error::validation_error,
 
         /** Some of the input was JSON, and the JSON could not be parsed. */
-        malformed_json
+        malformed_json,
+
+        /** The input was not written by `save_binary_file()`, or has been
+            truncated or corrupted. */
+        malformed_binary,
+
+        /** The input was written by `save_binary_file()` for options with
+            different names, types, or numbers of arguments than the ones
+            used to load it, or on a platform with a different byte
+            order. */
+        schema_mismatch
     };
 
     /** The exception type thrown when an options-saving function fails. */
@@ -146,13 +176,37 @@ namespace boost { namespace program_options_2 {
             decltype(std::declval<std::ofstream>() << std::declval<T>());
         template<typename T>
         using quotable = decltype(std::quoted(std::declval<T>()));
+
+        // Appends x to out as a JSON scalar.  Arithmetic types are written
+        // as JSON numbers (or booleans); everything else is written as a
+        // string, using operator<<() via os if x is not already a string.
+        template<typename T>
+        void json_append_value(
+            std::string & out, T const & x, std::ostringstream & os)
+        {
+            if constexpr (std::is_arithmetic_v<T>) {
+                detail::json_append_number(out, x);
+            } else if constexpr (std::is_convertible_v<
+                                     T const &,
+                                     std::string_view>) {
+                detail::json_append_string(out, x);
+            } else {
+                static_assert(
+                    boost::is_detected<detail::streamable, T>::value,
+                    "To use save_json_file(), all options must have a type "
+                    "that can be written to file using operator<<().");
+                os.str(std::string());
+                os << x;
+                detail::json_append_string(out, os.view());
+            }
+        }
     }
 
     /** Saves the options in `m`, expecting to find the options in `opts`,
         writing to file `filename`.
 
         \throws `save_error` on failure */
-    template<options_map OptionsMap, typename... Options>
+    template<options_storage OptionsMap, typename... Options>
     void save_response_file(
         std::string_view filename,
         customizable_strings const & strings,
@@ -167,19 +221,22 @@ namespace boost { namespace program_options_2 {
 
         ofs << std::boolalpha;
 
-        detail::map_lookup<OptionsMap const> lookup(m, strings);
+        using namespace hana::literals;
+
         auto const opt_tuple = detail::make_opt_tuple(opts...);
-        hana::for_each(opt_tuple, [&](auto const & opt) {
+        detail::storage_lookup<OptionsMap const, decltype(opt_tuple)> lookup(
+            m, strings, opt_tuple);
+        hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
+            auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
             using opt_type = std::remove_cvref_t<decltype(opt)>;
             using type = typename opt_type::type;
 
-            auto it = lookup.find(opt);
-            if (it == m.end() || any_empty(it->second))
-                return;
-
             try {
-                type const & value =
-                    program_options_2::any_cast<type const &>(it->second);
+                type const * const value_ptr =
+                    lookup.template value<type>(opt, i);
+                if (!value_ptr)
+                    return i_plus_1;
+                type const & value = *value_ptr;
                 if (!detail::positional(opt, strings))
                     ofs << detail::first_long_name(opt.names, strings) << ' ';
                 if constexpr (insertable<type>) {
@@ -215,35 +272,54 @@ namespace boost { namespace program_options_2 {
                 BOOST_THROW_EXCEPTION(
                     save_error(save_result::bad_any_cast, filename));
             }
+            return i_plus_1;
         });
     }
 
     /** Loads the options in file `filename`, expecting to find the options in
-        `opts`, and putting the results into `m`.
+        `opts`, and putting the results into `m`.  If `m` is a
+        `typed_options`, the file's contents are kept in its
+        `response_files`, so that `std::string_view` values loaded from the
+        file stay valid.
 
         \throws `load_error` on failure */
-    template<options_map OptionsMap, typename... Options>
+    template<options_storage OptionsMap, typename... Options>
     void load_response_file(
         std::string_view filename, OptionsMap & m, Options const &... opts)
     {
-        std::ifstream ifs(filename.data());
-        ifs.unsetf(ifs.skipws);
-        if (!ifs) {
+        std::optional<detail::response_file_cache> local_files;
+        auto & files = [&]() -> detail::response_file_cache & {
+            if constexpr (detail::is_typed_options<OptionsMap>::value)
+                return detail::kept_response_file_cache(m.response_files);
+            else
+                return local_files.emplace();
+        }();
+        auto error = parse_option_error::none;
+        auto * const file = files.enter(
+            filename.data(),
+            customizable_strings{}.max_response_file_depth,
+            error);
+        if (!file) {
             BOOST_THROW_EXCEPTION(load_error(
                 load_result::could_not_open_file_for_reading, filename));
         }
 
-        std::ostringstream oss;
-        auto const parse_result = detail::parse_options_into_map(
-            m,
-            customizable_strings{},
-            true,
-            detail::response_file_arg_view(ifs),
-            std::string_view{},
-            oss,
-            false,
-            false,
-            opts...);
+        detail::parse_option_result parse_result;
+        {
+            detail::response_file_scope const scope(files, *file);
+            std::ostringstream oss;
+            parse_result = detail::parse_options_into_map(
+                m,
+                customizable_strings{},
+                true,
+                file->tokens(),
+                std::string_view{},
+                oss,
+                false,
+                false,
+                opts...);
+        }
+        detail::storage_cleanup(m);
 
         if (!parse_result) {
             BOOST_THROW_EXCEPTION(
@@ -253,247 +329,246 @@ namespace boost { namespace program_options_2 {
 
     namespace detail {
 
-        template<typename Iter>
-        struct excessive_nesting : std::runtime_error
-        {
-            excessive_nesting(Iter it) :
-                runtime_error("excessive_nesting"), iter(it)
-            {}
-            Iter iter;
-        };
-
-        struct global_state
+        // Fails to compile if any option in opt_tuple, including the options
+        // within mutually exclusive groups, would load std::string_views
+        // from a JSON file.
+        template<typename OptTuple>
+        void check_no_json_string_views(OptTuple const & opt_tuple)
         {
-            int recursive_open_count = 0;
-            int max_recursive_open_count = 0;
-        };
+            hana::for_each(opt_tuple, [](auto const & opt) {
+                using opt_type = std::remove_cvref_t<decltype(opt)>;
+                if constexpr (group_<opt_type>) {
+                    detail::check_no_json_string_views(detail::make_opt_tuple(
+                        detail::to_ref_tuple(opt.options)));
+                } else {
+                    static_assert(
+                        !detail::refers_to_input_buffer<
+                            typename opt_type::type>(),
+                        "load_json_file() cannot load std::string_view "
+                        "values, since they would refer into a file that is "
+                        "closed before it returns.  Use std::string "
+                        "instead.");
+                }
+            });
+        }
 
-        struct double_escape_locals
+        // Binds the members of the JSON object read by a json_reader
+        // directly to the options in opt_tuple.  Each key is looked up in an
+        // index of the options' names, and each scalar in its value is
+        // converted straight into the option's entry in the map (or
+        // typed_options), as if it were a command line arg for that
+        // option.
+        template<typename OptionsMap, typename OptTuple>
+        struct json_binder
         {
-            int first_surrogate = 0;
-        };
-
-        inline parser::rule<class ws> const ws = "whitespace";
-
-        inline parser::rule<class string_char, uint32_t> const string_char =
-            "code point (code points <= U+001F must be escaped)";
-        inline parser::rule<class four_hex_digits, uint32_t> const hex_4 =
-            "four hexidecimal digits";
-        inline parser::rule<class escape_seq, uint32_t> const escape_seq =
-            "\\uXXXX hexidecimal escape sequence";
-        parser::
-            rule<class escape_double_seq, uint32_t, double_escape_locals> const
-                escape_double_seq = "\\uXXXX hexidecimal escape sequence";
-        inline parser::rule<class single_escaped_char, uint32_t> const
-            single_escaped_char = "'\"', '\\', '/', 'b', 'f', 'n', 'r', or 't'";
-
-        inline parser::callback_rule<class null_tag> const null = "null";
-
-        inline parser::callback_rule<class bool_tag, bool> const bool_p =
-            "boolean";
-
-        inline parser::callback_rule<class string_tag, std::string> const
-            string = "string";
-        inline parser::callback_rule<class number_tag, double> const number =
-            "number";
-
-        inline parser::callback_rule<
-            class object_element_key_tag,
-            std::string> const object_element_key = "string";
-        inline parser::rule<class object_element_tag> const object_element =
-            "object-element";
-
-        inline parser::callback_rule<class object_open_tag> const object_open =
-            "'{'";
-        inline parser::callback_rule<class object_close_tag> const
-            object_close = "'}'";
-        inline parser::rule<class object_tag> const object = "object";
-
-        inline parser::callback_rule<class array_open_tag> const array_open =
-            "'['";
-        inline parser::callback_rule<class array_close_tag> const array_close =
-            "']'";
-        inline parser::rule<class array_tag> const array = "array";
-
-        inline parser::rule<class value_tag> const value = "value";
-
-
-        // Since we use these tag types as function parameters in the callbacks,
-        // they need to be complete types.
-        class null_tag
-        {};
-        class bool_tag
-        {};
-        class string_tag
-        {};
-        class number_tag
-        {};
-        class object_element_key_tag
-        {};
-        class object_open_tag
-        {};
-        class object_close_tag
-        {};
-        class array_open_tag
-        {};
-        class array_close_tag
-        {};
-
-
-        inline auto const ws_def =
-            parser::lit('\x09') | '\x0a' | '\x0d' | '\x20';
-
-        inline auto first_hex_escape = [](auto & ctx) {
-            auto & locals = _locals(ctx);
-            uint32_t const cu = _attr(ctx);
-            if (!boost::parser::detail::text::high_surrogate(cu))
-                _pass(ctx) = false;
-            else
-                locals.first_surrogate = cu;
-        };
-        inline auto second_hex_escape = [](auto & ctx) {
-            auto & locals = _locals(ctx);
-            uint32_t const cu = _attr(ctx);
-            if (!boost::parser::detail::text::low_surrogate(cu)) {
-                _pass(ctx) = false;
-            } else {
-                uint32_t const high_surrogate_min = 0xd800;
-                uint32_t const low_surrogate_min = 0xdc00;
-                uint32_t const surrogate_offset =
-                    0x10000 - (high_surrogate_min << 10) - low_surrogate_min;
-                uint32_t const first_cu = locals.first_surrogate;
-                _val(ctx) = (first_cu << 10) + cu + surrogate_offset;
+            json_binder(
+                OptionsMap & m,
+                OptTuple const & opt_tuple,
+                customizable_strings const & strings) :
+                lookup_(m, strings, opt_tuple),
+                opt_tuple_(opt_tuple),
+                names_(detail::make_name_index(opt_tuple))
+            {
+                // Positionals are named by their names, too.
+                int i = 0;
+                hana::for_each(opt_tuple, [&](auto const & opt) {
+                    if constexpr (!group_<std::remove_cvref_t<decltype(opt)>>) {
+                        if (opt.positional)
+                            names_.insert(opt.names, {i, -1});
+                    }
+                    ++i;
+                });
             }
-        };
-
-        inline parser::parser_interface<
-            parser::uint_parser<uint32_t, 16, 4, 4>> const hex_4_def;
-
-        inline auto const escape_seq_def = "\\u" > hex_4;
-
-        inline auto const escape_double_seq_def =
-            escape_seq[first_hex_escape] >> escape_seq[second_hex_escape];
 
-        inline parser::symbols<uint32_t> const single_escaped_char_def = {
-            {"\"", 0x0022u},
-            {"\\", 0x005cu},
-            {"/", 0x002fu},
-            {"b", 0x0008u},
-            {"f", 0x000cu},
-            {"n", 0x000au},
-            {"r", 0x000du},
-            {"t", 0x0009u}};
-
-        inline auto const string_char_def =
-            escape_double_seq | escape_seq |
-            (parser::lit('\\') > single_escaped_char) |
-            (parser::cp - parser::char_(0x0000u, 0x001fu));
-
-        inline auto const null_def = parser::lit("null");
-
-        inline auto const bool_p_def = parser::bool_;
+            bool key(std::string_view key)
+            {
+                location_ = names_.find(key);
+                values_ = 0;
+                null_ = false;
+                if (!location_)
+                    return fail(parse_option_error::unknown_arg);
+                bool retval = true;
+                with_option([&](auto i, auto const & opt, int exclusives) {
+                    retval = start_value(i, opt, exclusives);
+                });
+                return retval;
+            }
 
-        inline auto const string_def =
-            parser::lexeme['"' >> *(string_char - '"') > '"'];
+            bool scalar(std::string_view text, json_scalar kind)
+            {
+                if (kind == json_scalar::null) {
+                    null_ = true;
+                    return true;
+                }
+                ++values_;
+                bool retval = true;
+                with_option([&](auto i, auto const & opt, int) {
+                    retval = bind(i, opt, text, kind);
+                });
+                return retval;
+            }
 
-        inline auto parse_double = [](auto & ctx) {
-            auto const cp_range = _attr(ctx);
-            auto cp_first = cp_range.begin();
-            auto const cp_last = cp_range.end();
+            bool value_end()
+            {
+                // A null value means that the option has no value.
+                if (null_ && !values_)
+                    return true;
+                bool retval = true;
+                with_option([&](auto i, auto const & opt, int) {
+                    int min_reps = 1;
+                    int max_reps = 1;
+                    if (opt.args != 0) {
+                        min_reps = opt.args;
+                        if (min_reps < 0)
+                            min_reps = min_reps == one_or_more ? 1 : 0;
+                        max_reps = opt.args;
+                        if (max_reps < 0)
+                            max_reps = max_reps == zero_or_one ? 1 : INT_MAX;
+                    }
+                    if (values_ < min_reps || max_reps < values_)
+                        retval = fail(parse_option_error::wrong_number_of_args);
+                    else
+                        detail::note_assigned(lookup_, i);
+                });
+                return retval;
+            }
 
-            auto const result =
-                parser::parse(cp_first, cp_last, parser::double_);
-            if (result) {
-                _val(ctx) = *result;
-            } else {
-                boost::container::small_vector<char, 128> chars(
-                    cp_first, cp_last);
-                auto const chars_first = &*chars.begin();
-                auto chars_last = chars_first + chars.size();
-                _val(ctx) = std::strtod(chars_first, &chars_last);
+            bool nested_object()
+            {
+                return fail(parse_option_error::cannot_parse_arg);
             }
-        };
 
-        inline auto const number_def =
-            parser::raw[parser::lexeme
-                            [-parser::char_('-') >>
-                             (parser::char_('1', '9') >> *parser::ascii::digit |
-                              parser::char_('0')) >>
-                             -(parser::char_('.') >> +parser::ascii::digit) >>
-                             -(parser::char_("eE") >> -parser::char_("+-") >>
-                               +parser::ascii::digit)]][parse_double];
-
-        inline auto const object_element_key_def = string_def;
-
-        inline auto const object_element_def = object_element_key > ':' > value;
-
-        inline auto const object_open_def = parser::lit('{');
-        inline auto const object_close_def = parser::lit('}');
-        inline auto const object_def = object_open >>
-                                       -(object_element % ',') > object_close;
-
-        inline auto const array_open_def = parser::lit('[');
-        inline auto const array_close_def = parser::lit(']');
-        inline auto const array_def = array_open >>
-                                      -(value % ',') > array_close;
-
-        inline auto const value_def =
-            number | bool_p | null | string | array | object;
-
-        inline auto const skipper =
-            parser::ws |
-            ('#' >> *(parser::char_ - parser::eol) >> -parser::eol);
-
-        BOOST_PARSER_DEFINE_RULES(
-            ws,
-            hex_4,
-            escape_seq,
-            escape_double_seq,
-            single_escaped_char,
-            string_char,
-            null,
-            bool_p,
-            string,
-            number,
-            object_element_key,
-            object_element,
-            object_open,
-            object_close,
-            object,
-            array_open,
-            array_close,
-            array,
-            value);
-
-        struct json_callbacks
-        {
-            json_callbacks(std::vector<std::string> & result) : result_(result)
-            {}
+            parse_option_error error() const { return error_; }
 
-            void operator()(null_tag) const { result_.push_back("null"); }
-            void operator()(bool_tag, bool b) const
+        private:
+            template<typename F>
+            void with_option(F const & f)
             {
-                result_.push_back(b ? "true" : "false");
+                detail::dispatch<detail::opt_tuple_size<OptTuple>>(
+                    location_.option, [&](auto i) {
+                        auto const & opt = opt_tuple_[i];
+                        using opt_type = std::remove_cvref_t<decltype(opt)>;
+                        if constexpr (group_<opt_type>) {
+                            if constexpr (opt_type::mutually_exclusive) {
+                                auto const sub_opts = detail::make_opt_tuple(
+                                    detail::to_ref_tuple(opt.options));
+                                detail::dispatch<detail::opt_tuple_size<
+                                    decltype(sub_opts)>>(
+                                    location_.sub_option, [&](auto j) {
+                                        f(i, sub_opts[j], (int)i);
+                                    });
+                            }
+                        } else {
+                            f(i, opt, -1);
+                        }
+                    });
             }
-            void operator()(string_tag, std::string s) const
+
+            template<typename I, typename Option>
+            bool start_value(I i, Option const & opt, int exclusives_group)
             {
-                result_.push_back(std::move(s));
+                if (opt.action == action_kind::help ||
+                    opt.action == action_kind::version ||
+                    opt.action == action_kind::response_file) {
+                    return fail(parse_option_error::unknown_arg);
+                }
+                if (0 <= exclusives_group) {
+                    if (exclusives_seen_[exclusives_group]) {
+                        return fail(
+                            parse_option_error::too_many_mutually_exclusives);
+                    }
+                    exclusives_seen_[exclusives_group] = true;
+                }
+                auto & result = lookup_(opt, i);
+                value_ = &result;
+                // As on the command line, an optional option that takes
+                // zero or more args is engaged even if it gets none.
+                using option_result_type =
+                    decltype(detail::make_result_tuple_element<Option>());
+                if constexpr (
+                    !Option::required &&
+                    is_optional<option_result_type>::value) {
+                    if (opt.args == zero_or_one || opt.args == zero_or_more) {
+                        detail::assign_or_insert<Option>(
+                            result, typename Option::type{});
+                    }
+                }
+                return true;
             }
-            void operator()(number_tag, double d) const
+
+            template<typename I, typename Option>
+            bool bind(
+                I i,
+                Option const & opt,
+                std::string_view text,
+                json_scalar kind)
             {
-                result_.push_back(std::to_string(d));
+                using result_type =
+                    std::remove_reference_t<decltype(lookup_(opt, i))>;
+                auto & result = *static_cast<result_type *>(value_);
+                // Only flags take no args, and their results (a count or a
+                // bool) are assigned directly.
+                constexpr bool flag_result =
+                    std::is_assignable_v<result_type &, int> &&
+                    std::is_assignable_v<result_type &, bool>;
+                if constexpr (flag_result) {
+                    if (opt.args == 0) {
+                        if (opt.action == action_kind::count) {
+                            int count = 0;
+                            if (kind != json_scalar::number ||
+                                !detail::convert_arg(text, count)) {
+                                return fail(
+                                    parse_option_error::cannot_parse_arg);
+                            }
+                            result = count;
+                            return true;
+                        }
+                        if (kind != json_scalar::boolean)
+                            return fail(parse_option_error::cannot_parse_arg);
+                        result = text == "true";
+                        return true;
+                    }
+                }
+
+                parse_option_error error = parse_option_error::none;
+                std::string_view validation_error;
+                auto const parse_element = detail::arg_parser_for<char>(
+                    opt,
+                    detail::value_destination(opt, result),
+                    error,
+                    validation_error);
+                bool const parsed =
+                    opt.separator.empty()
+                        ? parse_element(text)
+                        : detail::for_each_delimited(
+                              text, opt.separator, parse_element);
+                if (!parsed) {
+                    return fail(
+                        error == parse_option_error::none
+                            ? parse_option_error::cannot_parse_arg
+                            : error);
+                }
+                if (!validation_error.empty())
+                    return fail(parse_option_error::validation_error);
+                return true;
             }
-            void operator()(object_element_key_tag, std::string key) const
+
+            bool fail(parse_option_error error)
             {
-                result_.push_back(std::move(key));
+                error_ = error;
+                return false;
             }
-            void operator()(object_open_tag) const {}
-            void operator()(object_close_tag) const {}
-            void operator()(array_open_tag) const {}
-            void operator()(array_close_tag) const {}
 
-        private:
-            std::vector<std::string> & result_;
+            storage_lookup<OptionsMap, OptTuple> lookup_;
+            OptTuple const & opt_tuple_;
+            name_index names_;
+            option_location location_;
+            // Points to the result for the option at location_.
+            void * value_ = nullptr;
+            int values_ = 0;
+            bool null_ = false;
+            std::array<bool, opt_tuple_size<OptTuple>> exclusives_seen_ = {};
+            parse_option_error error_ = parse_option_error::none;
         };
 
         inline std::string file_slurp(std::ifstream & ifs)
@@ -510,7 +585,11 @@ namespace boost { namespace program_options_2 {
     }
 
     /** Saves the options in `m`, expecting to find the options in `opts`,
-        writing JSON-formatted output to file `filename`.
+        writing JSON-formatted output to file `filename`.  Values of
+        arithmetic type are written as JSON numbers (or booleans), and all
+        other values as JSON strings.  The output is written to a temporary
+        file that then replaces `filename`, so `filename` is never left
+        partially written.
 
         \note When you customize the `short_option_prefix`,
         `long_option_prefix`, or `response_file_prefix` members of
@@ -521,72 +600,69 @@ namespace boost { namespace program_options_2 {
         the rest of your program.
 
         \throws `save_error` on failure */
-    template<options_map OptionsMap, typename... Options>
+    template<options_storage OptionsMap, typename... Options>
     void save_json_file(
         std::string_view filename,
         OptionsMap const & m,
         customizable_strings const & strings,
         Options const &... opts)
     {
-        std::ofstream ofs(filename.data());
-        if (!ofs) {
-            BOOST_THROW_EXCEPTION(save_error(
-                save_result::could_not_open_file_for_writing, filename));
-        }
+        std::string json = "{\n";
+        std::ostringstream os;
 
-        ofs << std::boolalpha;
-        ofs << "{\n";
+        using namespace hana::literals;
 
-        detail::map_lookup<OptionsMap const> lookup(m, strings);
         auto const opt_tuple = detail::make_opt_tuple(opts...);
+        detail::storage_lookup<OptionsMap const, decltype(opt_tuple)> lookup(
+            m, strings, opt_tuple);
         bool first_opt = true;
-        hana::for_each(opt_tuple, [&](auto const & opt) {
+        hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
+            auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
             using opt_type = std::remove_cvref_t<decltype(opt)>;
             using type = typename opt_type::type;
 
-            auto it = lookup.find(opt);
-            if (it == m.end() || any_empty(it->second))
-                return;
-
             try {
-                type const & value =
-                    program_options_2::any_cast<type const &>(it->second);
+                type const * const value_ptr =
+                    lookup.template value<type>(opt, i);
+                if (!value_ptr)
+                    return i_plus_1;
+                type const & value = *value_ptr;
                 if (!first_opt)
-                    ofs << ",\n";
+                    json += ",\n";
                 first_opt = false;
-                ofs << "    \"" << detail::first_long_name(opt.names, strings)
-                    << "\":";
-                if constexpr (insertable<type>) {
+                json += "    ";
+                detail::json_append_string(
+                    json, detail::first_long_name(opt.names, strings));
+                json += ':';
+                if constexpr (
+                    insertable<type> && !detail::is_string<type>::value) {
                     bool first_arg = true;
-                    ofs << " [";
+                    json += " [";
                     for (auto const & x : value) {
-                        static_assert(
-                            boost::is_detected<
-                                detail::streamable,
-                                decltype(x)>::value,
-                            "To use save_json_file(), all options must have a "
-                            "type that can be written to file using "
-                            "operator<<().");
                         if (!first_arg)
-                            ofs << ',';
+                            json += ',';
                         first_arg = false;
-                        ofs << " \"" << x << '"';
+                        json += ' ';
+                        detail::json_append_value(json, x, os);
                     }
-                    ofs << " ]";
+                    json += " ]";
                 } else {
-                    static_assert(
-                        boost::is_detected<detail::streamable, type>::value,
-                        "To use save_json_file(), all options must have a type "
-                        "that can be written to file using operator<<().");
-                    ofs << " \"" << value << '"';
+                    json += ' ';
+                    detail::json_append_value(json, value, os);
                 }
             } catch (...) {
                 BOOST_THROW_EXCEPTION(
                     save_error(save_result::bad_any_cast, filename));
             }
+            return i_plus_1;
         });
 
-        ofs << "\n}\n";
+        json += "\n}\n";
+
+        if (!detail::write_file_atomically(filename, json)) {
+            BOOST_THROW_EXCEPTION(save_error(
+                save_result::could_not_open_file_for_writing, filename));
+        }
     }
 
     /** Saves the options in `m`, expecting to find the options in `opts`,
@@ -601,84 +677,345 @@ namespace boost { namespace program_options_2 {
         of your program.
 
         \throws `save_error` on failure */
-    template<options_map OptionsMap, typename... Options>
+    template<options_storage OptionsMap, typename... Options>
     void save_json_file(
         std::string_view filename,
         OptionsMap const & m,
         Options const &... opts)
     {
         program_options_2::save_json_file(
-            filename, customizable_strings{}, m, opts...);
+            filename, m, customizable_strings{}, opts...);
     }
 
     /** Loads the options in the JSON-formatted file `filename`, expecting to
-        find the options in `opts`, and putting the results into `m`.
+        find the options in `opts`, and putting the results into `m`.  The
+        file must contain a single object, each of whose keys is a name of
+        one of `opts`, and each of whose values is a value for that option,
+        or an array of them.  Since the file is closed before this function
+        returns, no option may have a `std::string_view` type (or a type
+        that contains them, like `std::vector<std::string_view>`).
 
         \throws `load_error` on failure */
-    template<options_map OptionsMap, typename... Options>
+    template<options_storage OptionsMap, typename... Options>
     void load_json_file(
         std::string_view filename, OptionsMap & m, Options const &... opts)
     {
-        std::ifstream ifs(filename.data());
-        if (!ifs) {
-            BOOST_THROW_EXCEPTION(save_error(
-                save_result::could_not_open_file_for_writing, filename));
+        auto const opt_tuple = detail::make_opt_tuple(opts...);
+        detail::check_no_json_string_views(opt_tuple);
+
+        detail::mapped_file const file(filename.data());
+        if (!file.is_open()) {
+            BOOST_THROW_EXCEPTION(load_error(
+                load_result::could_not_open_file_for_reading, filename));
         }
 
-        std::string error_message;
-        auto record_error = [&](std::string const & error) {
-            error_message = error;
-        };
-        parser::callback_error_handler error_callbacks(
-            record_error, record_error, filename);
-
-        int const max_recursion = 512;
-        detail::global_state globals{0, max_recursion};
-
-        std::vector<std::string> args;
-        detail::json_callbacks callbacks(args);
-        auto const contents = detail::file_slurp(ifs);
-        using iter_t = decltype(contents.begin());
-
-        auto const parser = parser::with_error_handler(
-            parser::with_globals(detail::value, globals), error_callbacks);
-        try {
-            if (!parser::callback_parse(
-                    contents, parser, detail::skipper, callbacks)) {
-                BOOST_THROW_EXCEPTION(
-                    load_error(load_result::malformed_json, error_message));
-            }
-        } catch (detail::excessive_nesting<iter_t> const & e) {
+        customizable_strings const strings;
+        detail::json_binder binder(m, opt_tuple, strings);
+        auto const contents = file.contents();
+        detail::json_reader reader(contents, binder);
+        bool const success = reader.read();
+        if (!success)
+            detail::storage_cleanup(m);
+
+        if (!reader.error().empty()) {
             std::ostringstream os;
             parser::write_formatted_message(
                 os,
                 filename,
                 contents.begin(),
-                e.iter,
+                contents.begin() + (reader.position() - contents.data()),
                 contents.end(),
-                "error: Exceeded maximum number (" +
-                    std::to_string(max_recursion) +
-                    ") of open arrays and/or objects");
+                reader.error());
             BOOST_THROW_EXCEPTION(
                 load_error(load_result::malformed_json, os.str()));
         }
+        if (!success) {
+            BOOST_THROW_EXCEPTION(
+                load_error((load_result)binder.error(), filename));
+        }
 
-        std::ostringstream oss;
-        auto const parse_result = detail::parse_options_into_map(
-            m,
-            customizable_strings{},
-            true,
-            args,
-            std::string_view{},
-            oss,
-            false,
-            false,
-            opts...);
+        detail::storage_lookup<OptionsMap, decltype(opt_tuple)> lookup(
+            m, strings, opt_tuple);
+        detail::assign_defaults(lookup, opt_tuple);
+        detail::storage_cleanup(m);
+    }
 
-        if (!parse_result) {
-            BOOST_THROW_EXCEPTION(
-                load_error((load_result)parse_result.error, filename));
+    namespace detail {
+        template<typename Option>
+        constexpr bool binary_stored()
+        {
+            using type = typename Option::type;
+            return !std::is_void_v<type> && !std::is_same_v<type, no_value> &&
+                   !is_value_sink<type>::value;
+        }
+
+        // Calls f(opt, i) for each option in opt_tuple that has a value to
+        // store, including the options within mutually exclusive groups.
+        // As when parsing, an option within a group is passed the group's
+        // index i, not its index within the group.
+        template<typename OptTuple, typename F>
+        void for_each_binary_option(OptTuple const & opt_tuple, F const & f)
+        {
+            using namespace hana::literals;
+
+            hana::fold(opt_tuple, 0_c, [&](auto i, auto const & opt) {
+                auto const i_plus_1 = hana::llong_c<decltype(i)::value + 1>;
+                using opt_type = std::remove_cvref_t<decltype(opt)>;
+                if constexpr (group_<opt_type>) {
+                    if constexpr (opt_type::mutually_exclusive) {
+                        detail::for_each_binary_option(
+                            detail::make_opt_tuple(
+                                detail::to_ref_tuple(opt.options)),
+                            [&](auto const & sub_opt, auto) {
+                                f(sub_opt, i);
+                            });
+                    }
+                } else if constexpr (detail::binary_stored<opt_type>()) {
+                    using type = typename opt_type::type;
+                    static_assert(
+                        detail::binary_encodable<type>(),
+                        "To use save_binary_file() or load_binary_file(), all "
+                        "options must have a type that is a string, "
+                        "trivially copyable, or an optional or insertable "
+                        "container of such types.");
+                    f(opt, i);
+                }
+                return i_plus_1;
+            });
+        }
+
+        template<typename OptTuple>
+        std::uint64_t binary_schema_fingerprint(OptTuple const & opt_tuple)
+        {
+            binary_fingerprint fp;
+            fp.add(binary_format_version);
+            fp.add((int)std::endian::native);
+            detail::for_each_binary_option(
+                opt_tuple, [&](auto const & opt, auto) {
+                    using opt_type = std::remove_cvref_t<decltype(opt)>;
+                    fp.add(opt.names);
+                    fp.add(opt.args);
+                    fp.add(opt.positional);
+                    detail::add_binary_type<typename opt_type::type>(fp);
+                });
+            return fp.value;
+        }
+
+        template<typename OptionsMap, typename OptTuple>
+        load_result load_binary(
+            std::string_view buffer,
+            OptionsMap & m,
+            OptTuple const & opt_tuple)
+        {
+            binary_reader reader{buffer.data(), buffer.data() + buffer.size()};
+            std::uint32_t version = 0;
+            std::uint64_t fingerprint = 0;
+            if (!buffer.starts_with(binary_magic))
+                return load_result::malformed_binary;
+            reader.it += binary_magic.size();
+            if (!reader.read(version) || !reader.read(fingerprint))
+                return load_result::malformed_binary;
+            if (version != binary_format_version ||
+                fingerprint != detail::binary_schema_fingerprint(opt_tuple)) {
+                return load_result::schema_mismatch;
+            }
+
+            customizable_strings const strings;
+            detail::storage_lookup<OptionsMap, OptTuple> lookup(
+                m, strings, opt_tuple);
+            bool success = true;
+            detail::for_each_binary_option(
+                opt_tuple, [&](auto const & opt, auto i) {
+                    std::uint64_t length = 0;
+                    if (!success || !reader.read(length)) {
+                        success = false;
+                        return;
+                    }
+                    using opt_type = std::remove_cvref_t<decltype(opt)>;
+                    // As with the other loaders, an option with no value
+                    // gets its default, if any.
+                    if (length == binary_no_value) {
+                        if constexpr (
+                            !opt_type::required &&
+                            detail::has_default<opt_type>()) {
+                            auto & result = lookup(opt, i);
+                            if (detail::result_empty(result)) {
+                                detail::assign_or_insert<opt_type>(
+                                    result, opt.default_value);
+                                detail::note_assigned(lookup, i);
+                            }
+                        }
+                        return;
+                    }
+                    if (reader.remaining() < length) {
+                        success = false;
+                        return;
+                    }
+                    binary_reader value_reader{reader.it, reader.it + length};
+                    reader.it += length;
+                    typename opt_type::type value{};
+                    if (!value_reader.read(value) || value_reader.remaining()) {
+                        success = false;
+                        return;
+                    }
+                    lookup(opt, i) = std::move(value);
+                    detail::note_assigned(lookup, i);
+                });
+            if (!success || reader.remaining()) {
+                detail::storage_cleanup(m);
+                return load_result::malformed_binary;
+            }
+
+            detail::storage_cleanup(m);
+            return load_result::success;
+        }
+    }
+
+    /** Saves the options in `m`, expecting to find the options in `opts`,
+        writing a compact binary representation to file `filename`.  The
+        file starts with a fingerprint of the names, types, and numbers of
+        arguments of `opts`, and each value is stored in its native
+        representation, so loading it back with `load_binary_file()` or
+        `load_binary_buffer()` involves no parsing.  As with
+        `save_json_file()`, `filename` is replaced in a single step, and is
+        never left partially written.
+
+        Each option must have a type that is trivially copyable (like `int`
+        or `double`), a string, or an optional or insertable container (like
+        `std::vector`) of those.  The file is only meant to be read by the
+        same program on the same platform; for anything else, use
+        `save_json_file()`.
+
+        \note When you customize the `short_option_prefix`,
+        `long_option_prefix`, or `response_file_prefix` members of
+        `customizable_strings`, you must pass your custom
+        `customizable_strings` here, even thought it is possible to call
+        another overload of this function without it.  If you fail to do this,
+        the values saved by this function are very likely to be unparseable by
+        the rest of your program.
+
+        \throws `save_error` on failure */
+    template<options_storage OptionsMap, typename... Options>
+    void save_binary_file(
+        std::string_view filename,
+        OptionsMap const & m,
+        customizable_strings const & strings,
+        Options const &... opts)
+    {
+        auto const opt_tuple = detail::make_opt_tuple(opts...);
+        std::string bytes(detail::binary_magic);
+        detail::binary_append(bytes, detail::binary_format_version);
+        detail::binary_append(
+            bytes, detail::binary_schema_fingerprint(opt_tuple));
+
+        detail::storage_lookup<OptionsMap const, decltype(opt_tuple)> lookup(
+            m, strings, opt_tuple);
+        detail::for_each_binary_option(
+            opt_tuple, [&](auto const & opt, auto i) {
+                using opt_type = std::remove_cvref_t<decltype(opt)>;
+                using type = typename opt_type::type;
+
+                try {
+                    type const * const value =
+                        lookup.template value<type>(opt, i);
+                    if (!value) {
+                        detail::binary_append(bytes, detail::binary_no_value);
+                        return;
+                    }
+                    auto const length_offset = bytes.size();
+                    detail::binary_append(bytes, std::uint64_t(0));
+                    detail::binary_append(bytes, *value);
+                    std::uint64_t const length =
+                        bytes.size() - length_offset - sizeof(std::uint64_t);
+                    std::memcpy(
+                        bytes.data() + length_offset, &length, sizeof(length));
+                } catch (...) {
+                    BOOST_THROW_EXCEPTION(
+                        save_error(save_result::bad_any_cast, filename));
+                }
+            });
+
+        if (!detail::write_file_atomically(filename, bytes)) {
+            BOOST_THROW_EXCEPTION(save_error(
+                save_result::could_not_open_file_for_writing, filename));
+        }
+    }
+
+    /** Saves the options in `m`, expecting to find the options in `opts`,
+        writing a compact binary representation to file `filename`.
+
+        \note When you customize the `short_option_prefix`,
+        `long_option_prefix`, or `response_file_prefix` members of
+        `customizable_strings`, you must call the overload of this function
+        that takes a `customizable_strings`, and pass your custom
+        `customizable_strings` there.  If you fail to do this, the values
+        saved by this function are very likely to be unparseable by the rest
+        of your program.
+
+        \throws `save_error` on failure */
+    template<options_storage OptionsMap, typename... Options>
+    void save_binary_file(
+        std::string_view filename,
+        OptionsMap const & m,
+        Options const &... opts)
+    {
+        program_options_2::save_binary_file(
+            filename, m, customizable_strings{}, opts...);
+    }
+
+    /** Loads the options in `buffer`, which must hold the contents of a file
+        written by `save_binary_file()`, expecting to find the options in
+        `opts`, and putting the results into `m`.  `opts` must have the same
+        names, types, and numbers of arguments as the options used to save
+        the file.  The values are not validated again; any choices or
+        validators were applied when they were first parsed.  Loaded
+        `std::string_view` values refer into `buffer`.
+
+        \throws `load_error` on failure */
+    template<options_storage OptionsMap, typename... Options>
+    void load_binary_buffer(
+        std::string_view buffer, OptionsMap & m, Options const &... opts)
+    {
+        auto const result =
+            detail::load_binary(buffer, m, detail::make_opt_tuple(opts...));
+        if (result != load_result::success)
+            BOOST_THROW_EXCEPTION(load_error(result, ""));
+    }
+
+    /** Loads the options in file `filename`, which must have been written by
+        `save_binary_file()`, expecting to find the options in `opts`, and
+        putting the results into `m`.  `opts` must have the same names,
+        types, and numbers of arguments as the options used to save the
+        file.  The file is memory-mapped where possible.  Since the file is
+        closed before this function returns, no option may have a
+        `std::string_view` type (or a type that contains them, like
+        `std::vector<std::string_view>`); use `load_binary_buffer()` for
+        those instead.
+
+        \throws `load_error` on failure */
+    template<options_storage OptionsMap, typename... Options>
+    void load_binary_file(
+        std::string_view filename, OptionsMap & m, Options const &... opts)
+    {
+        auto const opt_tuple = detail::make_opt_tuple(opts...);
+        detail::for_each_binary_option(opt_tuple, [](auto const & opt, auto) {
+            using opt_type = std::remove_cvref_t<decltype(opt)>;
+            static_assert(
+                !detail::refers_to_input_buffer<typename opt_type::type>(),
+                "load_binary_file() cannot load std::string_view values, "
+                "since they would refer into a file that is closed before "
+                "it returns.  Use load_binary_buffer() instead.");
+        });
+
+        detail::mapped_file const file(filename.data());
+        if (!file.is_open()) {
+            BOOST_THROW_EXCEPTION(load_error(
+                load_result::could_not_open_file_for_reading, filename));
         }
+        auto const result =
+            detail::load_binary(file.contents(), m, opt_tuple);
+        if (result != load_result::success)
+            BOOST_THROW_EXCEPTION(load_error(result, filename));
     }
 
 }}
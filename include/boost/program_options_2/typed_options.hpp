@@ -0,0 +1,202 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_TYPED_OPTIONS_HPP
+#define BOOST_PROGRAM_OPTIONS_2_TYPED_OPTIONS_HPP
+
+#include <boost/program_options_2/response_file_buffers.hpp>
+#include <boost/program_options_2/storage.hpp>
+#include <boost/program_options_2/detail/name_index.hpp>
+#include <boost/program_options_2/detail/parsing.hpp>
+
+#include <bitset>
+#include <optional>
+
+
+namespace boost { namespace program_options_2 {
+
+    namespace detail {
+        template<typename OptTuple, std::size_t... Is>
+        constexpr bool contains_groups(std::index_sequence<Is...>)
+        {
+            return (group_<opt_tuple_element_t<OptTuple, Is>> || ...);
+        }
+    }
+
+    /** Storage for the values of the options `Options...`, as an
+        alternative to an options map.  Each option's value has a slot of
+        its own type in `values`, a `hana::tuple` laid out like the tuple
+        returned by the tuple overloads of `parse_command_line()`: an
+        optional option's value is a `std::optional<T>`, a positional or
+        required option's value is a `T`, and an option with no value
+        (like a help option) has a `no_value` slot.  Groups are flattened,
+        as they are for those overloads.
+
+        A `typed_options` can be used anywhere an options map can --
+        including `parse_command_line()`, `parser::parse()`, and all the
+        `save_*()` and `load_*()` functions -- as long as the options passed
+        along with it are the ones it was made from.  Unlike a map, it never
+        needs to look up a value by name while parsing, saving, or loading,
+        and reading a value involves no `any_cast`.  A value can be read by
+        its index at compile time, as `values[hana::llong_c<I>]`, or by the
+        `storage_name()` of its option, with `get_if()`, which uses an index
+        of the names that is built once, on construction.
+
+        A slot that is not a `std::optional` always holds a value, even
+        before one is assigned, so `typed_options` keeps track of which of
+        those slots have been assigned: by a parse, by a load, by a default,
+        or by a call to the non-const `operator[]`.  `contains()` is false
+        for such a slot until it has been assigned, and the `save_*()`
+        functions skip it, as they skip an option missing from a map.
+        Assigning to an element of `values` directly does not count.
+
+        The contents of any response file read while parsing into a
+        `typed_options` are kept in its `response_files`, so values of type
+        `std::string_view` (the default type of `argument()` and
+        `positional()`) remain valid for as long as the `typed_options`
+        does, even when they came from a response file.
+
+        The options must not contain commands or mutually exclusive
+        groups. */
+    template<typename... Options>
+    struct typed_options
+    {
+        static_assert(
+            (option_or_group<Options> && ...),
+            "typed_options may only be made from options and groups.");
+
+        using opt_tuple_type = decltype(detail::make_opt_tuple(
+            std::declval<Options const &>()...));
+        using values_type = decltype(detail::make_result_tuple(
+            std::declval<Options const &>()...));
+
+        static_assert(
+            !detail::contains_groups<opt_tuple_type>(
+                std::make_index_sequence<
+                    detail::opt_tuple_size<opt_tuple_type>>()),
+            "typed_options may not be made from options that contain "
+            "commands or mutually exclusive groups.");
+
+        /** Makes storage for the options in `opts`, each of whose value is
+            empty (or default-constructed, if it is not optional). */
+        explicit typed_options(Options const &... opts) :
+            typed_options(customizable_strings{}, opts...)
+        {}
+
+        /** Makes storage for the options in `opts`, each of whose value is
+            empty (or default-constructed, if it is not optional).  The
+            options' names are looked up using `storage_name(opt,
+            strings)`. */
+        typed_options(
+            customizable_strings const & strings, Options const &... opts) :
+            values(detail::make_result_tuple(opts...))
+        {
+            int i = 0;
+            hana::for_each(
+                detail::make_opt_tuple(opts...), [&](auto const & opt) {
+                    index_.insert(
+                        program_options_2::storage_name(opt, strings),
+                        {i, -1});
+                    ++i;
+                });
+        }
+
+        /** Returns the number of slots in `values`. */
+        static constexpr std::size_t size()
+        {
+            return detail::opt_tuple_size<opt_tuple_type>;
+        }
+
+        /** Returns the slot for the `I`-th option, and marks it as
+            assigned. */
+        template<long long I>
+        auto & operator[](hana::llong<I> i)
+        {
+            present_.set(I);
+            return values[i];
+        }
+
+        /** Returns the slot for the `I`-th option. */
+        template<long long I>
+        auto const & operator[](hana::llong<I> i) const
+        {
+            return values[i];
+        }
+
+        /** Returns the index of the slot for the option whose
+            `storage_name()` is `name`, or -1 if there is none. */
+        int index(std::string_view name) const
+        {
+            return index_.find(name).option;
+        }
+
+        /** Returns a pointer to the value for the option whose
+            `storage_name()` is `name`, or `nullptr` if there is no such
+            option, if it has no value, or if its type is not `T`. */
+        template<typename T>
+        T const * get_if(std::string_view name) const
+        {
+            T const * retval = nullptr;
+            int const i = index(name);
+            if (i < 0)
+                return retval;
+            detail::dispatch<size()>(i, [&](auto i) {
+                auto const & value = values[i];
+                using value_type = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<value_type, std::optional<T>>) {
+                    if (value)
+                        retval = &*value;
+                } else if constexpr (std::is_same_v<value_type, T>) {
+                    retval = &value;
+                }
+            });
+            return retval;
+        }
+
+        /** Returns true iff the option whose `storage_name()` is `name` has
+            a value.  A slot that is not a `std::optional` has one only once
+            it has been assigned. */
+        bool contains(std::string_view name) const
+        {
+            bool retval = false;
+            int const i = index(name);
+            if (i < 0)
+                return retval;
+            detail::dispatch<size()>(i, [&](auto i) {
+                auto const & value = values[i];
+                using value_type = std::remove_cvref_t<decltype(value)>;
+                if constexpr (detail::is_optional<value_type>::value)
+                    retval = value.has_value();
+                else if constexpr (!std::is_same_v<value_type, no_value>)
+                    retval = present_[decltype(i)::value];
+            });
+            return retval;
+        }
+
+        values_type values;
+
+        /** The contents of the response files read by the parses into
+            `*this`, which `std::string_view` values may refer to. */
+        response_file_buffers response_files;
+
+    private:
+        template<typename TypedOptions>
+        friend struct detail::typed_lookup;
+
+        detail::name_index index_;
+        // Which slots have been assigned.
+        std::bitset<detail::opt_tuple_size<opt_tuple_type>> present_;
+    };
+
+    template<option_or_group... Options>
+    typed_options(Options const &...) -> typed_options<Options...>;
+
+    template<option_or_group... Options>
+    typed_options(customizable_strings const &, Options const &...)
+        -> typed_options<Options...>;
+
+}}
+
+#endif
@@ -0,0 +1,205 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#ifndef BOOST_PROGRAM_OPTIONS_2_WATCHED_STORAGE_HPP
+#define BOOST_PROGRAM_OPTIONS_2_WATCHED_STORAGE_HPP
+
+#include <boost/program_options_2/storage.hpp>
+#include <boost/program_options_2/detail/file_watcher.hpp>
+#include <boost/program_options_2/detail/rcu.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+
+namespace boost { namespace program_options_2 {
+
+    /** The formats of file that `watched_options` can load. */
+    enum struct file_format {
+        /** A file written by `save_response_file()`, or by hand. */
+        response_file,
+
+        /** A file written by `save_json_file()`, or by hand. */
+        json,
+
+        /** A file written by `save_binary_file()`. */
+        binary
+    };
+
+    /** Options loaded from a file, which are loaded again each time the file
+        changes.  Changes are noticed with inotify where it is available (see
+        `BOOST_PROGRAM_OPTIONS_2_DISABLE_INOTIFY`), and by checking the
+        file's status every `poll_interval` otherwise.  Each reload parses
+        the file into a new `OptionsMap` on a thread of its own, and
+        replaces the current one only if the load succeeds; a file that is
+        missing, malformed, or fails validation leaves the current options
+        in place, and is reported by `last_result()`.
+
+        Any number of threads may call `read()` at the same time, without
+        locking or waiting, even while a reload is in progress.  A reload
+        never waits for readers either; the options it replaces are
+        destroyed by a later reload (or by the `watched_options` itself),
+        once no `snapshot` of them remains.  Every `snapshot` must be
+        destroyed before the `watched_options` is.
+
+        \note The file is closed after each load, so options with a
+        `std::string_view` type (or containers of them) must not be used;
+        use `std::string` instead. */
+    template<options_map OptionsMap = string_any_map>
+    struct watched_options
+    {
+        /** A read-only view of the options at the time it was created,
+            which keeps them alive until it is destroyed. */
+        struct snapshot
+        {
+            snapshot(snapshot && other) noexcept :
+                ptr_(std::exchange(other.ptr_, nullptr)),
+                slot_(other.slot_),
+                rcu_(other.rcu_)
+            {}
+            snapshot & operator=(snapshot &&) = delete;
+            ~snapshot()
+            {
+                if (ptr_)
+                    rcu_->read_unlock(slot_);
+            }
+
+            OptionsMap const & operator*() const { return *ptr_; }
+            OptionsMap const * operator->() const { return ptr_; }
+
+        private:
+            explicit snapshot(detail::rcu_ptr<OptionsMap> const & rcu) :
+                slot_(rcu.read_lock()), rcu_(&rcu)
+            {
+                ptr_ = rcu.get();
+            }
+
+            OptionsMap const * ptr_;
+            unsigned slot_;
+            detail::rcu_ptr<OptionsMap> const * rcu_;
+
+            friend watched_options;
+        };
+
+        /** Loads the options in file `filename`, which must be in format
+            `format`, expecting to find the options in `opts`, and watches
+            the file for changes, checking it every `poll_interval` if it
+            cannot be watched with inotify.
+
+            \throws `load_error` if the first load fails */
+        template<option_or_group... Options>
+        watched_options(
+            std::string_view filename,
+            file_format format,
+            std::chrono::milliseconds poll_interval,
+            Options const &... opts) :
+            filename_(filename),
+            load_(make_loader(filename_, format, opts...)),
+            rcu_(load_initial()),
+            watcher_(filename_, poll_interval, [this] {
+                // A reload that fails leaves the current options in place.
+                try {
+                    reload();
+                } catch (...) {
+                }
+            })
+        {}
+
+        /** Loads the options in file `filename`, which must be in format
+            `format`, expecting to find the options in `opts`, and watches
+            the file for changes, checking it once a second if it cannot be
+            watched with inotify.
+
+            \throws `load_error` if the first load fails */
+        template<option_or_group... Options>
+        watched_options(
+            std::string_view filename,
+            file_format format,
+            Options const &... opts) :
+            watched_options(
+                filename, format, std::chrono::milliseconds(1000), opts...)
+        {}
+
+        watched_options(watched_options const &) = delete;
+        watched_options & operator=(watched_options const &) = delete;
+
+        /** Returns a view of the current options.  This never blocks. */
+        snapshot read() const { return snapshot(rcu_); }
+
+        /** Loads the file again right away, instead of waiting for a change
+            to be noticed.  Returns true, and replaces the current options,
+            iff the load succeeds.  This does not wait for any `snapshot` of
+            the replaced options to be destroyed. */
+        bool reload()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto m = std::make_unique<OptionsMap>();
+            try {
+                load_(*m);
+            } catch (load_error const & e) {
+                last_result_ = e.error();
+                return false;
+            }
+            rcu_.replace(std::move(m));
+            last_result_ = load_result::success;
+            ++generation_;
+            return true;
+        }
+
+        /** Returns the number of times the options have been loaded
+            successfully, including the first time. */
+        std::uint64_t generation() const { return generation_; }
+
+        /** Returns the result of the most recent load. */
+        load_result last_result() const { return last_result_; }
+
+    private:
+        template<typename... Options>
+        static std::function<void(OptionsMap &)> make_loader(
+            std::string filename, file_format format, Options const &... opts)
+        {
+            return [filename = std::move(filename), format, opts...](
+                       OptionsMap & m) {
+                switch (format) {
+                case file_format::response_file:
+                    program_options_2::load_response_file(
+                        filename, m, opts...);
+                    break;
+                case file_format::json:
+                    program_options_2::load_json_file(filename, m, opts...);
+                    break;
+                case file_format::binary:
+                    program_options_2::load_binary_file(filename, m, opts...);
+                    break;
+                }
+            };
+        }
+
+        std::unique_ptr<OptionsMap const> load_initial()
+        {
+            auto m = std::make_unique<OptionsMap>();
+            load_(*m);
+            return m;
+        }
+
+        std::string filename_;
+        std::function<void(OptionsMap &)> load_;
+        detail::rcu_ptr<OptionsMap> rcu_;
+        std::mutex mutex_;
+        std::atomic<std::uint64_t> generation_ = 1;
+        std::atomic<load_result> last_result_ = load_result::success;
+        // Declared last, so that its calls to reload() stop before anything
+        // they use is destroyed.
+        detail::file_watcher watcher_;
+    };
+
+}}
+
+#endif
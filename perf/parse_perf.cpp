@@ -0,0 +1,194 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/storage.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace po2 = boost::program_options_2;
+
+// A command line with many options, almost all of them ASCII, like nearly
+// every real command line.
+std::vector<std::string> make_args(int n)
+{
+    std::vector<std::string> retval = {"prog"};
+    for (int i = 0; i < n; ++i) {
+        switch (i % 4) {
+        case 0: retval.push_back("--apple"); break;
+        case 1: retval.push_back(std::to_string(i)); break;
+        case 2: retval.push_back("-b"); break;
+        case 3: retval.push_back("some-file-name-" + std::to_string(i)); break;
+        }
+    }
+    return retval;
+}
+
+auto const apple = po2::argument<std::vector<int>>("-a,--apple", "Apples.");
+auto const banana =
+    po2::argument<std::vector<std::string>>("-b,--banana", "Bananas.");
+auto const verbose = po2::flag("-v,--verbose", "Verbosity.");
+
+void BM_parse_long_argv(benchmark::State & state)
+{
+    auto const args_storage = make_args(state.range(0));
+    std::vector<std::string_view> const args(
+        args_storage.begin(), args_storage.end());
+    while (state.KeepRunning()) {
+        auto result =
+            po2::try_parse_command_line(args, apple, banana, verbose);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_parse_long_argv)->Range(8, 8 << 10);
+
+void BM_default_help_scan(benchmark::State & state)
+{
+    auto const args_storage = make_args(state.range(0));
+    std::vector<std::string_view> const args(
+        args_storage.begin(), args_storage.end());
+    po2::customizable_strings const strings;
+    while (state.KeepRunning()) {
+        bool const found =
+            po2::detail::argv_contains_default_help_flag(strings, args);
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_default_help_scan)->Range(8, 8 << 10);
+
+void BM_leading_dash(benchmark::State & state)
+{
+    auto const args_storage = make_args(state.range(0));
+    po2::customizable_strings const strings;
+    while (state.KeepRunning()) {
+        int dashed = 0;
+        for (auto const & arg : args_storage) {
+            dashed += po2::detail::leading_dash(arg, strings);
+        }
+        benchmark::DoNotOptimize(dashed);
+    }
+}
+BENCHMARK(BM_leading_dash)->Range(8, 8 << 10);
+
+void BM_parse_many_values(benchmark::State & state)
+{
+    std::vector<std::string> args_storage = {"prog", "--values"};
+    for (int i = 0, n = state.range(0); i < n; ++i) {
+        args_storage.push_back(std::to_string(i * 37));
+    }
+    std::vector<std::string_view> const args(
+        args_storage.begin(), args_storage.end());
+    auto const values = po2::argument<std::vector<long>>(
+        "--values", "Values.", po2::one_or_more);
+    while (state.KeepRunning()) {
+        auto result = po2::try_parse_command_line(args, values);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_parse_many_values)->Range(8, 8 << 10);
+
+// A response file like the ones build systems write: many short tokens,
+// with an occasional quoted path.
+std::string make_response_file(int n)
+{
+    std::string const filename = "response_file_for_perf_test";
+    std::ofstream ofs(filename);
+    for (auto const & arg : make_args(n)) {
+        if (arg.starts_with("some"))
+            ofs << '"' << arg << " with spaces\"\n";
+        else
+            ofs << arg << ' ';
+    }
+    return filename;
+}
+
+void BM_response_file_stream(benchmark::State & state)
+{
+    auto const filename = make_response_file(state.range(0));
+    while (state.KeepRunning()) {
+        std::ifstream ifs(filename);
+        ifs.unsetf(ifs.skipws);
+        std::size_t size = 0;
+        for (auto token : po2::detail::response_file_arg_view(ifs)) {
+            size += token.size();
+        }
+        benchmark::DoNotOptimize(size);
+    }
+}
+BENCHMARK(BM_response_file_stream)->Range(8, 64 << 10);
+
+void BM_response_file_mapped(benchmark::State & state)
+{
+    auto const filename = make_response_file(state.range(0));
+    while (state.KeepRunning()) {
+        po2::detail::mapped_file const file(filename.c_str());
+        std::size_t size = 0;
+        for (auto token :
+             po2::detail::response_file_buffer_arg_view(file.contents())) {
+            size += token.size();
+        }
+        benchmark::DoNotOptimize(size);
+    }
+}
+BENCHMARK(BM_response_file_mapped)->Range(8, 64 << 10);
+
+// A config file with a few scalars, and one long array of numbers.
+std::string make_json_file(int n)
+{
+    std::string const filename = "json_file_for_perf_test";
+    std::ofstream ofs(filename);
+    ofs << "{\n    \"--name\": \"a \\\"quoted\\\" name\",\n"
+        << "    \"--ratio\": 0.25,\n    \"--ints\": [";
+    for (int i = 0; i < n; ++i) {
+        if (i)
+            ofs << ", ";
+        ofs << i * 7919;
+    }
+    ofs << "]\n}\n";
+    return filename;
+}
+
+void BM_load_json_file(benchmark::State & state)
+{
+    auto const filename = make_json_file(state.range(0));
+    auto const name = po2::argument<std::string>("--name", "Name.");
+    auto const ratio = po2::argument<double>("--ratio", "Ratio.");
+    auto const ints = po2::argument<std::vector<int>>(
+        "--ints", "Ints.", po2::zero_or_more);
+    while (state.KeepRunning()) {
+        po2::string_any_map m;
+        po2::load_json_file(filename, m, name, ratio, ints);
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_load_json_file)->Range(8, 64 << 10);
+
+void BM_load_binary_file(benchmark::State & state)
+{
+    auto const json_filename = make_json_file(state.range(0));
+    auto const name = po2::argument<std::string>("--name", "Name.");
+    auto const ratio = po2::argument<double>("--ratio", "Ratio.");
+    auto const ints = po2::argument<std::vector<int>>(
+        "--ints", "Ints.", po2::zero_or_more);
+    std::string const filename = "binary_file_for_perf_test";
+    {
+        po2::string_any_map m;
+        po2::load_json_file(json_filename, m, name, ratio, ints);
+        po2::save_binary_file(filename, m, name, ratio, ints);
+    }
+    while (state.KeepRunning()) {
+        po2::string_any_map m;
+        po2::load_binary_file(filename, m, name, ratio, ints);
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(BM_load_binary_file)->Range(8, 64 << 10);
+
+BENCHMARK_MAIN()
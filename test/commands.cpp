@@ -7,6 +7,7 @@
 #include <boost/program_options_2/option_groups.hpp>
 #include <boost/program_options_2/decorators.hpp>
 #include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/parser.hpp>
 
 #include <boost/mpl/assert.hpp>
 #include <boost/type_traits/is_same.hpp>
@@ -423,3 +424,174 @@ response files:
 )");
     }
 }
+
+TEST(commands, try_parse)
+{
+    int calls = 0;
+    auto command = po2::command(
+        [&](auto const &) { ++calls; }, "cmd", "A command.", arg1, arg2, arg3);
+
+    {
+        std::vector<std::string_view> args{"prog", "cmd", "-a", "55"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_TRUE(status);
+        EXPECT_EQ(std::any_cast<int>(result["apple"]), 55);
+        EXPECT_EQ(calls, 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "cmd", "-a", "x"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::cannot_parse_arg);
+        EXPECT_EQ(status.token, "x");
+        EXPECT_EQ(calls, 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "cmd", "-h"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_FALSE(status);
+        EXPECT_TRUE(status.help_requested);
+        EXPECT_EQ(calls, 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "-a", "55"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::expected_command);
+        EXPECT_EQ(status.token, "-a");
+        EXPECT_EQ(calls, 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "bogus"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::expected_command);
+        EXPECT_EQ(status.token, "bogus");
+        EXPECT_EQ(calls, 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::expected_command);
+        EXPECT_EQ(status.token, "");
+        EXPECT_EQ(calls, 1);
+    }
+}
+
+TEST(commands, dispatch)
+{
+    std::string called;
+    auto command_tree = po2::group(
+        po2::command(
+            [&](auto const &) { called = "add"; }, "add,a", "Add.", arg1),
+        po2::group(
+            po2::command(
+                [&](auto const &) { called = "remove"; },
+                "remove,rm",
+                "Remove.",
+                arg1),
+            po2::command(
+                "remote",
+                "Remotes.",
+                po2::command(
+                    [&](auto const &) { called = "remote show"; },
+                    "show",
+                    "Show.",
+                    arg3),
+                po2::command(
+                    [&](auto const &) { called = "remote prune"; },
+                    "prune,p",
+                    "Prune.",
+                    arg4))));
+
+    {
+        std::vector<std::string_view> args{"prog", "a", "-a", "1"};
+        std::map<std::string_view, std::any> result;
+        EXPECT_TRUE(po2::try_parse_command_line(args, result, command_tree));
+        EXPECT_EQ(called, "add");
+        EXPECT_EQ(std::any_cast<int>(result["apple"]), 1);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "rm", "-a", "2"};
+        std::map<std::string_view, std::any> result;
+        EXPECT_TRUE(po2::try_parse_command_line(args, result, command_tree));
+        EXPECT_EQ(called, "remove");
+        EXPECT_EQ(std::any_cast<int>(result["apple"]), 2);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "remote", "p", "-f", "3"};
+        std::map<std::string_view, std::any> result;
+        EXPECT_TRUE(po2::try_parse_command_line(args, result, command_tree));
+        EXPECT_EQ(called, "remote prune");
+        EXPECT_EQ(std::any_cast<short>(result["f"]), 3);
+    }
+    {
+        called.clear();
+        std::vector<std::string_view> args{"prog", "remote", "add"};
+        std::map<std::string_view, std::any> result;
+        auto const status =
+            po2::try_parse_command_line(args, result, command_tree);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::expected_command);
+        EXPECT_EQ(called, "");
+    }
+
+    // A parser indexes the names of the commands at each level once, and
+    // matches them the same way.
+    {
+        std::ostringstream os;
+        auto const parser = po2::make_parser("A program.", os, command_tree);
+        {
+            std::vector<std::string_view> args{
+                "prog", "remote", "show", "-e", "2"};
+            std::map<std::string_view, std::any> result;
+            EXPECT_TRUE(parser.try_parse(args, result));
+            EXPECT_EQ(called, "remote show");
+            EXPECT_EQ(std::any_cast<short>(result["e"]), 2);
+        }
+        {
+            std::vector<std::string_view> args{"prog", "add", "-a", "5"};
+            std::map<std::string_view, std::any> result;
+            parser.parse(args, result);
+            EXPECT_EQ(called, "add");
+            EXPECT_EQ(std::any_cast<int>(result["apple"]), 5);
+        }
+        {
+            called.clear();
+            std::vector<std::string_view> args{"prog", "remote", "rm"};
+            std::map<std::string_view, std::any> result;
+            auto const status = parser.try_parse(args, result);
+            EXPECT_FALSE(status);
+            EXPECT_EQ(status.error, po2::parse_option_error::expected_command);
+            EXPECT_EQ(status.token, "rm");
+            EXPECT_EQ(called, "");
+        }
+    }
+
+    // The commands used are printed under the names used.
+    {
+        std::vector<std::string_view> args{"prog", "remote", "p", "-h"};
+        std::ostringstream os;
+        std::map<std::string_view, std::any> result;
+        try {
+            po2::parse_command_line(
+                args, result, "A program.", os, command_tree);
+        } catch (int) {
+        }
+        EXPECT_EQ(os.str().find("usage:  prog remote p [-h] [-f {1,2,3}]"), 0u)
+            << os.str();
+    }
+}
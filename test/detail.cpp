@@ -3,13 +3,21 @@
 // Distributed under the Boost Software License, Version 1.0. (See
 // accompanying file LICENSE_1_0.txt or copy at
 // http://www.boost.org/LICENSE_1_0.txt)
+#include <boost/program_options_2/option_groups.hpp>
 #include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/detail/rcu.hpp>
 
 #include <boost/mpl/assert.hpp>
 #include <boost/type_traits/is_same.hpp>
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+
 
 namespace po2 = boost::program_options_2;
 
@@ -123,6 +131,254 @@ TEST(detail, misc)
     }
 }
 
+TEST(detail, name_index)
+{
+    auto const opt_tuple = po2::detail::make_opt_tuple(
+        po2::argument<int>("-a,--abacus", "The abacus."),
+        po2::positional<int>("bobcat", "The bobcat."),
+        po2::exclusive(
+            po2::flag("-c,--cataphract", "The cataphract."),
+            po2::counted_flag("-d,--dolemite", "*The* Dolemite.")));
+    auto const index = po2::detail::make_name_index(opt_tuple);
+    po2::customizable_strings const strings;
+    using sv = std::string_view;
+
+    EXPECT_EQ(index.size(), 6u);
+
+    EXPECT_EQ(index.find(sv("-a")).option, 0);
+    EXPECT_EQ(index.find(sv("--abacus")).option, 0);
+    EXPECT_EQ(index.find(sv("--abacus")).sub_option, -1);
+    EXPECT_FALSE(index.find(sv("bobcat")));
+    EXPECT_FALSE(index.find(sv("-abacus")));
+    EXPECT_FALSE(index.find(sv("")));
+
+    EXPECT_EQ(index.find(sv("-c")).option, 2);
+    EXPECT_EQ(index.find(sv("-c")).sub_option, 0);
+    EXPECT_EQ(index.find(sv("--dolemite")).option, 2);
+    EXPECT_EQ(index.find(sv("--dolemite")).sub_option, 1);
+    EXPECT_TRUE(index.find(sv("--dolemite")).counted);
+
+    EXPECT_EQ(index.find(std::u32string_view(U"--abacus")).option, 0);
+    EXPECT_TRUE(index.contains(std::u32string_view(U"-c")));
+
+    EXPECT_EQ(index.find_option(sv("-ddd"), strings).option, 2);
+    EXPECT_EQ(index.find_option(sv("-ddd"), strings).sub_option, 1);
+    EXPECT_FALSE(index.find_option(sv("-ccc"), strings));
+    EXPECT_FALSE(index.find_option(sv("-dde"), strings));
+    EXPECT_FALSE(index.find_option(sv("--ddd"), strings));
+
+    auto const known_names = po2::detail::make_known_names_index(
+        po2::argument<int>("-a,--abacus", "The abacus."),
+        po2::command(
+            [](auto const &) {},
+            "cmd",
+            po2::flag("-e,--eggplant", "The eggplant.")));
+    EXPECT_TRUE(known_names.contains(sv("-a")));
+    EXPECT_TRUE(known_names.contains(sv("--eggplant")));
+    EXPECT_FALSE(known_names.contains(sv("cmd")));
+}
+
+TEST(detail, ascii_comparisons)
+{
+    using sv = std::string_view;
+    using wsv = std::wstring_view;
+
+    EXPECT_TRUE(po2::detail::ascii(sv("")));
+    EXPECT_TRUE(po2::detail::ascii(sv("--a-long-option-name=value")));
+    EXPECT_FALSE(po2::detail::ascii(sv("--a-long-option-name=v\xc3\xa1lue")));
+    EXPECT_FALSE(po2::detail::ascii(sv("\xc3\xa1")));
+    EXPECT_TRUE(po2::detail::ascii(wsv(L"--option")));
+    EXPECT_FALSE(po2::detail::ascii(wsv(L"--opti\x00e1n")));
+
+    EXPECT_TRUE(po2::detail::transcoded_starts_with(sv("--foo"), sv("--")));
+    EXPECT_FALSE(po2::detail::transcoded_starts_with(sv("-"), sv("--")));
+    EXPECT_TRUE(po2::detail::transcoded_starts_with(wsv(L"--foo"), sv("--")));
+    EXPECT_TRUE(po2::detail::transcoded_starts_with(
+        sv("\xc3\xa1\xc3\xa1" "foo"), sv("\xc3\xa1\xc3\xa1")));
+    EXPECT_TRUE(po2::detail::transcoded_starts_with(
+        wsv(L"\x00e1\x00e1" L"foo"), sv("\xc3\xa1\xc3\xa1")));
+    EXPECT_FALSE(po2::detail::transcoded_starts_with(
+        wsv(L"\x00e1" L"foo"), sv("\xc3\xa1\xc3\xa1")));
+
+    EXPECT_TRUE(po2::detail::transcoded_equal(sv("--foo"), sv("--foo")));
+    EXPECT_FALSE(po2::detail::transcoded_equal(sv("--foo"), sv("--fo")));
+    EXPECT_TRUE(po2::detail::transcoded_equal(wsv(L"--foo"), sv("--foo")));
+    EXPECT_FALSE(po2::detail::transcoded_equal(wsv(L"--f\x00e1"), sv("--fa")));
+    EXPECT_TRUE(
+        po2::detail::transcoded_equal(wsv(L"--f\x00e1"), sv("--f\xc3\xa1")));
+    EXPECT_TRUE(po2::detail::transcoded_equal(
+        std::string("--f\xc3\xa1"), sv("--f\xc3\xa1")));
+}
+
+TEST(detail, scan_args)
+{
+    po2::customizable_strings const strings;
+    auto const known_names = po2::detail::make_known_names_index(
+        po2::argument<int>("-a,--apple", "Apples."),
+        po2::exclusive(
+            po2::flag("-b", "B."), po2::flag("--banana", "Bananas.")),
+        po2::positional<int>("pos", "Positional."));
+    auto const help_names =
+        po2::detail::make_default_help_names_index(strings);
+
+    std::vector<std::string_view> const args{
+        "prog", "-a", "3", "--banana", "-x", "@file", "--help", "-"};
+    auto const scanned =
+        po2::detail::scan_args(args, strings, known_names, help_names);
+    EXPECT_TRUE(scanned.contains_default_help());
+    ASSERT_EQ(scanned.tokens_.size(), args.size());
+
+    auto dashed = [&](int i) { return scanned.tokens_[i].dashed; };
+    auto known = [&](int i) { return scanned.tokens_[i].known_name; };
+    auto response_file = [&](int i) {
+        return scanned.tokens_[i].response_file;
+    };
+    auto help = [&](int i) { return scanned.tokens_[i].default_help; };
+
+    EXPECT_FALSE(dashed(0));
+    EXPECT_TRUE(dashed(1));
+    EXPECT_TRUE(known(1));
+    EXPECT_FALSE(dashed(2));
+    EXPECT_FALSE(known(2));
+    EXPECT_TRUE(dashed(3));
+    EXPECT_TRUE(known(3));
+    EXPECT_TRUE(dashed(4));
+    EXPECT_FALSE(known(4));
+    EXPECT_FALSE(dashed(5));
+    EXPECT_TRUE(response_file(5));
+    EXPECT_FALSE(response_file(4));
+    EXPECT_TRUE(help(6));
+    EXPECT_FALSE(help(1));
+    EXPECT_TRUE(dashed(7));
+    EXPECT_FALSE(known(7));
+
+    // The scanned range iterates over the same tokens as the args.
+    EXPECT_TRUE(std::ranges::equal(scanned, args));
+    auto it = scanned.begin();
+    ++it;
+    EXPECT_TRUE(po2::detail::dashed_token(it, strings));
+    EXPECT_TRUE(po2::detail::known_name_token(it, known_names));
+    EXPECT_TRUE(po2::detail::dashed_token(args.begin() + 1, strings));
+    EXPECT_TRUE(po2::detail::known_name_token(args.begin() + 1, known_names));
+    EXPECT_TRUE(po2::detail::contains_default_help_flag(
+        scanned.begin(), scanned.end(), strings));
+    EXPECT_TRUE(po2::detail::contains_default_help_flag(
+        args.begin(), args.end(), strings));
+    EXPECT_FALSE(po2::detail::contains_default_help_flag(
+        scanned.begin(), std::next(scanned.begin(), 6), strings));
+    EXPECT_FALSE(po2::detail::contains_default_help_flag(
+        args.begin(), args.begin() + 6, strings));
+
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            std::next(scanned.begin(), 2), scanned.end(), 100, known_names),
+        1);
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            std::next(scanned.begin(), 4), scanned.end(), 100, known_names),
+        4);
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            std::next(scanned.begin(), 4), scanned.end(), 2, known_names),
+        2);
+
+    // Unscanned args, like those of a response file, give the same runs.
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            args.begin() + 2, args.end(), 100, known_names),
+        1);
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            args.begin() + 4, args.end(), 100, known_names),
+        4);
+    EXPECT_EQ(
+        po2::detail::value_run_length(
+            args.begin() + 4, args.end(), 2, known_names),
+        2);
+}
+
+TEST(detail, reserve_values)
+{
+    // As when an option with two args appears many times.
+    std::vector<int> v;
+    int reallocations = 0;
+    for (int i = 0; i < 10000; ++i) {
+        auto const capacity = v.capacity();
+        po2::detail::reserve_values_impl(v, 2);
+        if (v.capacity() != capacity)
+            ++reallocations;
+        EXPECT_LE(v.size() + 2, v.capacity());
+        v.push_back(i);
+        v.push_back(i);
+    }
+    EXPECT_LT(reallocations, 20);
+
+    std::optional<std::vector<int>> opt_v(std::in_place);
+    po2::detail::reserve_values_impl(opt_v, 5);
+    EXPECT_LE(5u, opt_v->capacity());
+}
+
+TEST(detail, convert_arg)
+{
+    {
+        int i = 0;
+        EXPECT_TRUE(po2::detail::convert_arg("42", i));
+        EXPECT_EQ(i, 42);
+        EXPECT_TRUE(po2::detail::convert_arg("-42", i));
+        EXPECT_EQ(i, -42);
+        EXPECT_TRUE(po2::detail::convert_arg("+42", i));
+        EXPECT_EQ(i, 42);
+        EXPECT_FALSE(po2::detail::convert_arg("+-42", i));
+        EXPECT_FALSE(po2::detail::convert_arg("42x", i));
+        EXPECT_FALSE(po2::detail::convert_arg("", i));
+        EXPECT_FALSE(po2::detail::convert_arg("99999999999999999999", i));
+    }
+    {
+        unsigned int u = 0;
+        EXPECT_TRUE(po2::detail::convert_arg("42", u));
+        EXPECT_EQ(u, 42u);
+        EXPECT_FALSE(po2::detail::convert_arg("-42", u));
+        EXPECT_FALSE(po2::detail::convert_arg("+42", u));
+    }
+    {
+        double d = 0;
+        EXPECT_TRUE(po2::detail::convert_arg("1.5", d));
+        EXPECT_EQ(d, 1.5);
+        EXPECT_TRUE(po2::detail::convert_arg("+2e3", d));
+        EXPECT_EQ(d, 2000.0);
+        EXPECT_FALSE(po2::detail::convert_arg("1.5.", d));
+    }
+    {
+        bool b = false;
+        EXPECT_TRUE(po2::detail::convert_arg("true", b));
+        EXPECT_TRUE(b);
+        EXPECT_TRUE(po2::detail::convert_arg("false", b));
+        EXPECT_FALSE(b);
+        EXPECT_FALSE(po2::detail::convert_arg("1", b));
+    }
+    {
+        std::string str;
+        EXPECT_TRUE(po2::detail::convert_arg("some string", str));
+        EXPECT_EQ(str, "some string");
+        std::string_view sv;
+        EXPECT_TRUE(po2::detail::convert_arg("", sv));
+        EXPECT_EQ(sv, "");
+    }
+
+    static_assert(po2::detail::direct_conversion<
+                  char,
+                  decltype(po2::argument<std::vector<int>>("-a", ""))>());
+    static_assert(po2::detail::direct_conversion<
+                  char,
+                  decltype(po2::argument<std::optional<double>>("-a", ""))>());
+    static_assert(po2::detail::direct_conversion<
+                  char,
+                  decltype(po2::argument<std::string>("-a", ""))>());
+    static_assert(!po2::detail::direct_conversion<
+                  wchar_t,
+                  decltype(po2::argument<int>("-a", ""))>());
+}
+
 TEST(detail, response_file_arg_view_)
 {
     {
@@ -194,3 +450,332 @@ TEST(detail, response_file_arg_view_)
         EXPECT_EQ(result[4], "baz ");
     }
 }
+
+std::vector<std::string> stream_tokens(std::string const & contents)
+{
+    std::istringstream is(contents);
+    is.unsetf(is.skipws);
+    po2::detail::response_file_arg_view view(is);
+    return std::vector<std::string>(view.begin(), view.end());
+}
+
+std::vector<std::string> buffer_tokens(std::string const & contents)
+{
+    po2::detail::response_file_buffer_arg_view view(contents);
+    return std::vector<std::string>(view.begin(), view.end());
+}
+
+TEST(detail, response_file_buffer_arg_view_)
+{
+
+    std::string const contents[] = {
+        "",
+        "   \n\t ",
+        "-a",
+        "-a -1  foo\nbar\tbaz",
+        "  -a -1  foo\nbar\tbaz  \n",
+        "  -a -1\\  \"\\\"foo\\\"\" \n   \"\\\"bar\\\\\\\"\" \t\"baz \"  \n",
+        "# comment\n-a # another\r\n-b#c\n",
+        "\"a # b\" \"\" x\"y z\"w \"unterminated \\",
+        "\"\\x\\\\y\\\"z\"",
+    };
+    for (auto const & c : contents) {
+        EXPECT_EQ(buffer_tokens(c), stream_tokens(c)) << "'" << c << "'";
+    }
+
+    // Tokens that need no unescaping are views of the buffer.
+    {
+        std::string const buffer = "-a \"some file\" \"a\\\"b\"";
+        po2::detail::response_file_buffer_arg_view view(buffer);
+        auto it = view.begin();
+        EXPECT_EQ(*it, "-a");
+        EXPECT_EQ((*it).data(), buffer.data());
+        ++it;
+        EXPECT_EQ(*it, "some file");
+        EXPECT_EQ((*it).data(), buffer.data() + 4);
+        ++it;
+        EXPECT_EQ(*it, "a\"b");
+        EXPECT_FALSE(
+            buffer.data() <= (*it).data() &&
+            (*it).data() < buffer.data() + buffer.size());
+        ++it;
+        EXPECT_TRUE(it == view.end());
+    }
+
+    // mapped_file
+    {
+        auto const filename = "response_file_for_view_test_0";
+        {
+            std::ofstream ofs(filename);
+            ofs << "-a 1\n\"b c\"";
+        }
+        po2::detail::mapped_file const file(filename);
+        EXPECT_TRUE(file.is_open());
+        EXPECT_EQ(file.contents(), "-a 1\n\"b c\"");
+        po2::detail::response_file_buffer_arg_view view(file.contents());
+        std::vector<std::string> const result(view.begin(), view.end());
+        EXPECT_EQ(result, (std::vector<std::string>{"-a", "1", "b c"}));
+
+        po2::detail::mapped_file const no_file("no_such_file_for_view_test");
+        EXPECT_FALSE(no_file.is_open());
+        EXPECT_EQ(no_file.contents(), "");
+    }
+}
+
+TEST(detail, response_file_token_iter)
+{
+    static_assert(
+        std::forward_iterator<po2::detail::response_file_token_iter>);
+
+    std::string const contents = "-a \"x\\\"y\" b \"z\\\\w\"";
+    std::vector<std::string> const expected = {"-a", "x\"y", "b", "z\\w"};
+
+    // A copy is advanced independently of the original, even past tokens
+    // that needed unescaping.
+    {
+        po2::detail::response_file_token_iter first(
+            contents, nullptr, std::pmr::get_default_resource());
+        po2::detail::response_file_token_iter const last;
+        ++first;
+        auto copy = first;
+        EXPECT_EQ(*first, "x\"y");
+        ++copy;
+        ++copy;
+        EXPECT_EQ(*copy, "z\\w");
+        EXPECT_EQ(*first, "x\"y");
+        EXPECT_EQ(std::distance(first, last), 3);
+        EXPECT_EQ(*first, "x\"y");
+    }
+
+    // With somewhere to keep them, unescaped tokens stay valid, and each
+    // is kept once, however many passes are made.
+    {
+        std::pmr::deque<std::pmr::string> unescaped;
+        std::vector<std::string_view> views;
+        for (int i = 0; i < 3; ++i) {
+            po2::detail::response_file_token_iter first(
+                contents, &unescaped, std::pmr::get_default_resource());
+            po2::detail::response_file_token_iter const last;
+            for (; first != last; ++first) {
+                views.push_back(*first);
+            }
+        }
+        EXPECT_EQ(unescaped.size(), 2u);
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_EQ(
+                std::vector<std::string>(
+                    views.begin() + 4 * i, views.begin() + 4 * (i + 1)),
+                expected);
+        }
+        EXPECT_EQ(views[1].data(), views[5].data());
+    }
+}
+
+TEST(detail, special_bytes)
+{
+    std::string bytes;
+    for (int i = 0; i < 256; ++i) {
+        bytes += (char)i;
+    }
+    for (std::size_t i = 0; i < bytes.size(); i += 64) {
+        std::uint64_t const mask =
+            po2::detail::special_bytes(bytes.data() + i, 64);
+        for (std::size_t j = 0; j < 64; ++j) {
+            char const c = bytes[i + j];
+            bool const expected = c == ' ' || c == '\t' || c == '\n' ||
+                                  c == '\v' || c == '\f' || c == '\r' ||
+                                  c == '"' || c == '\\' || c == '#';
+            EXPECT_EQ(bool(mask & (std::uint64_t(1) << j)), expected)
+                << "byte " << (i + j);
+        }
+        EXPECT_EQ(
+            po2::detail::special_bytes(bytes.data() + i, 10),
+            mask & 0x3ff);
+    }
+}
+
+TEST(detail, response_file_tokenizers_agree)
+{
+    // Random files over an alphabet heavy in the bytes that matter to the
+    // tokenizers, long enough to cross several blocks.
+    char const alphabet[] = {
+        'a', 'b', '-', ' ', ' ', '\t', '\n', '\r', '\v', '"', '"', '\\',
+        '\\', '#', '\xc3', '\xa1', 'z', '0'};
+    std::mt19937 g(42);
+    std::uniform_int_distribution<int> size_dist(0, 300);
+    std::uniform_int_distribution<int> char_dist(0, sizeof(alphabet) - 1);
+    for (int i = 0; i < 5000; ++i) {
+        std::string contents(size_dist(g), ' ');
+        for (auto & c : contents) {
+            c = alphabet[char_dist(g)];
+        }
+        EXPECT_EQ(buffer_tokens(contents), stream_tokens(contents))
+            << "'" << contents << "'";
+    }
+
+    // Long runs of ordinary bytes, with a special byte at every offset
+    // within a block.
+    for (int i = 0; i < 130; ++i) {
+        for (char special : {' ', '"', '\\', '#', '\n'}) {
+            std::string contents(200, 'x');
+            contents[i] = special;
+            contents[i + 3] = '"';
+            EXPECT_EQ(buffer_tokens(contents), stream_tokens(contents))
+                << "'" << contents << "'";
+        }
+    }
+}
+
+TEST(detail, thread_pool)
+{
+    po2::detail::thread_pool pool;
+
+    // Each job takes its work from a shared counter, so every item is done
+    // exactly once, however many threads take part.
+    for (int pass = 0; pass < 3; ++pass) {
+        std::vector<std::atomic<int>> done(1000);
+        std::atomic<std::size_t> next = 0;
+        pool.run(3, [&] {
+            for (std::size_t i = next++; i < done.size(); i = next++) {
+                ++done[i];
+            }
+        });
+        for (auto const & d : done) {
+            EXPECT_EQ(d, 1);
+        }
+        // The threads are started once, and then reused.
+        EXPECT_EQ(pool.size(), 3u);
+    }
+
+    // Without helpers, the job runs on the calling thread alone.
+    {
+        std::thread::id id;
+        pool.run(0, [&] { id = std::this_thread::get_id(); });
+        EXPECT_EQ(id, std::this_thread::get_id());
+    }
+}
+
+TEST(detail, response_file_cache_prefetch)
+{
+    static_assert(std::forward_iterator<
+                  po2::detail::scanned_iterator<char const * const *>>);
+
+    std::vector<std::string> paths;
+    std::vector<std::string> contents;
+    for (int i = 0; i < 6; ++i) {
+        paths.push_back("prefetched_response_file_" + std::to_string(i));
+        std::string c;
+        for (int j = 0; j < 1000 * i; ++j) {
+            c += "--arg" + std::to_string(j) + " \"a \\\"b\\\"\" c\n";
+        }
+        contents.push_back(c);
+        std::ofstream ofs(paths.back());
+        ofs << c;
+    }
+    // The same file, twice, and a file that does not exist.
+    paths.push_back(paths.front());
+    paths.push_back("no_such_response_file");
+
+    po2::detail::thread_pool pool;
+    po2::detail::response_file_cache cache;
+    cache.prefetch(paths, pool, 4);
+    EXPECT_EQ(pool.size(), 3u);
+    po2::detail::response_file_cache serial_cache;
+    for (int i = 0; i < 6; ++i) {
+        auto error = po2::parse_option_error::none;
+        auto * const tokens = cache.enter(paths[i].c_str(), 64, error);
+        ASSERT_TRUE(tokens);
+        EXPECT_EQ(error, po2::parse_option_error::none);
+        auto * const serial_tokens =
+            serial_cache.enter(paths[i].c_str(), 64, error);
+        ASSERT_TRUE(serial_tokens);
+        auto const file_tokens = tokens->tokens();
+        auto const serial_file_tokens = serial_tokens->tokens();
+        std::vector<std::string> const strings(
+            file_tokens.begin(), file_tokens.end());
+        EXPECT_EQ(strings, buffer_tokens(contents[i]));
+        EXPECT_EQ(
+            strings,
+            std::vector<std::string>(
+                serial_file_tokens.begin(), serial_file_tokens.end()));
+        cache.leave(*tokens);
+        serial_cache.leave(*serial_tokens);
+    }
+    {
+        auto error = po2::parse_option_error::none;
+        auto * const tokens =
+            cache.enter("no_such_response_file", 64, error);
+        EXPECT_FALSE(tokens);
+        EXPECT_EQ(error, po2::parse_option_error::cannot_read_response_file);
+        EXPECT_EQ(cache.size(), 6u);
+        EXPECT_FALSE(cache.expanding());
+    }
+    {
+        auto error = po2::parse_option_error::none;
+        po2::detail::response_file_cache dir_cache;
+        EXPECT_FALSE(dir_cache.enter(".", 64, error));
+        EXPECT_EQ(error, po2::parse_option_error::cannot_read_response_file);
+        EXPECT_EQ(dir_cache.size(), 0u);
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        std::remove(paths[i].c_str());
+    }
+}
+
+TEST(detail, rcu_ptr)
+{
+    // Both members are always equal, until destruction.
+    struct value
+    {
+        explicit value(int x) : a(x), b(x) {}
+        ~value() { a = -1; }
+        int a;
+        int b;
+    };
+
+    po2::detail::rcu_ptr<value> ptr(std::make_unique<value const>(0));
+    std::atomic<bool> done = false;
+    std::atomic<int> bad_reads = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            int last = 0;
+            while (!done) {
+                auto const slot = ptr.read_lock();
+                value const * const v = ptr.get();
+                int const a = v->a;
+                std::this_thread::yield();
+                if (a != v->b || v->a != a || a < last)
+                    ++bad_reads;
+                last = a;
+                ptr.read_unlock(slot);
+            }
+        });
+    }
+    for (int i = 1; i <= 2000; ++i) {
+        ptr.replace(std::make_unique<value const>(i));
+    }
+    done = true;
+    for (auto & t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(bad_reads, 0);
+    auto const slot = ptr.read_lock();
+    EXPECT_EQ(ptr.get()->a, 2000);
+
+    // A reader that holds on does not keep the writer waiting; it only
+    // keeps the replaced values from being deleted.
+    value const * const held = ptr.get();
+    for (int i = 2001; i <= 2010; ++i) {
+        ptr.replace(std::make_unique<value const>(i));
+    }
+    EXPECT_EQ(held->a, 2000);
+    EXPECT_EQ(held->b, 2000);
+    EXPECT_LE(10u, ptr.retired());
+    ptr.read_unlock(slot);
+
+    ptr.replace(std::make_unique<value const>(2011));
+    EXPECT_EQ(ptr.retired(), 0u);
+}
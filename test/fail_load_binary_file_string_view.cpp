@@ -0,0 +1,19 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#include <boost/program_options_2/option_groups.hpp>
+#include <boost/program_options_2/storage.hpp>
+
+namespace po2 = boost::program_options_2;
+
+int main()
+{
+    auto const arg =
+        po2::argument<std::optional<std::vector<std::string_view>>>(
+            "-n,--names", "Names");
+
+    po2::string_any_map m;
+    po2::load_binary_file("file", m, arg);
+}
@@ -1814,6 +1814,40 @@ TEST(parse_command_line, mixed_tuple)
     }
 }
 
+TEST(parse_command_line, mixed_tuple_any_order)
+{
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog", "-d", "5", "-z", "2", "-b", "66", "-a", "55", "77", "88"};
+        auto result = po2::parse_command_line(
+            args, "A program.", os, MIXED(int, 4, 5, 6, 42));
+        EXPECT_TRUE(result[0_c]);
+        EXPECT_EQ(*result[0_c], 55);
+        EXPECT_TRUE(result[1_c]);
+        EXPECT_EQ(*result[1_c], std::optional<int>{66});
+        EXPECT_EQ(result[2_c], std::vector<int>({77, 88}));
+        EXPECT_TRUE(result[3_c]);
+        EXPECT_EQ(*result[3_c], 5);
+        EXPECT_TRUE(result[4_c]);
+        EXPECT_EQ(*result[4_c], std::vector<int>({2}));
+        EXPECT_EQ(result[5_c], std::vector<std::string_view>({}));
+    }
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog", "77", "88", "x", "y", "-d", "5", "-a", "55"};
+        auto result = po2::parse_command_line(
+            args, "A program.", os, MIXED(int, 4, 5, 6, 42));
+        EXPECT_TRUE(result[0_c]);
+        EXPECT_EQ(*result[0_c], 55);
+        EXPECT_EQ(result[2_c], std::vector<int>({77, 88}));
+        EXPECT_TRUE(result[3_c]);
+        EXPECT_EQ(*result[3_c], 5);
+        EXPECT_EQ(result[5_c], std::vector<std::string_view>({"x", "y"}));
+    }
+}
+
 #undef MIXED
 
 TEST(parse_command_line, flags_tuple)
@@ -2002,6 +2036,165 @@ TEST(parse_command_line, numeric_named_argument)
     }
 }
 
+TEST(parse_command_line, separated_lists)
+{
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog", "--ids", "1,2,3", "4", "--tags", "a::b::::c", "5,6", "7"};
+        auto result = po2::parse_command_line(
+            args,
+            "A program.",
+            os,
+            po2::with_separator(
+                po2::argument<std::vector<int>>(
+                    "--ids", "IDs.", po2::one_or_more),
+                ","),
+            po2::with_separator(
+                po2::argument<std::vector<std::string>>("--tags", "Tags."),
+                "::"),
+            po2::with_separator(
+                po2::positional<std::vector<int>>("pos", "Pos.", 2), ","));
+        BOOST_MPL_ASSERT((is_same<
+                          decltype(result),
+                          tuple<
+                              opt<std::vector<int>>,
+                              opt<std::vector<std::string>>,
+                              std::vector<int>>>));
+        EXPECT_EQ(*result[0_c], std::vector<int>({1, 2, 3, 4}));
+        EXPECT_EQ(
+            *result[1_c], std::vector<std::string>({"a", "b", "", "c"}));
+        EXPECT_EQ(result[2_c], std::vector<int>({5, 6, 7}));
+        EXPECT_EQ(os.str(), "");
+    }
+    {
+        std::vector<std::string_view> args{"prog", "--ids", "1,x,3"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::with_separator(
+                po2::argument<std::vector<int>>(
+                    "--ids", "IDs.", po2::one_or_more),
+                ","));
+        EXPECT_EQ(result.error, po2::parse_option_error::cannot_parse_arg);
+        EXPECT_EQ(result.token, "1,x,3");
+    }
+    {
+        std::vector<std::string_view> args{"prog", "--ids", "1,7"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::with_separator(
+                po2::argument<std::vector<int>>(
+                    "--ids", "IDs.", po2::one_or_more, 1, 2, 3),
+                ","));
+        EXPECT_EQ(result.error, po2::parse_option_error::no_such_choice);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "--cpus", "0;2;4"};
+        po2::string_any_map m;
+        auto const status = po2::try_parse_command_line(
+            args,
+            m,
+            po2::with_separator(
+                po2::argument<std::vector<unsigned int>>("--cpus", "CPUs."),
+                ";"));
+        EXPECT_TRUE(status);
+        EXPECT_EQ(
+            std::any_cast<std::vector<unsigned int>>(m["cpus"]),
+            std::vector<unsigned int>({0, 2, 4}));
+    }
+}
+
+TEST(parse_command_line, sinks)
+{
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog", "-n", "3", "in", "a", "b", "-c"};
+        std::vector<std::string> rest;
+        auto result = po2::parse_command_line(
+            args,
+            "A program.",
+            os,
+            po2::argument<int>("-n", "N."),
+            po2::positional("input", "Input."),
+            po2::with_sink(
+                po2::remainder("rest", "Rest."),
+                [&rest](std::string_view sv) { rest.emplace_back(sv); }));
+        BOOST_MPL_ASSERT((is_same<
+                          decltype(result),
+                          tuple<opt<int>, std::string_view, po2::no_value>>));
+        EXPECT_EQ(result[0_c], 3);
+        EXPECT_EQ(result[1_c], "in");
+        EXPECT_EQ(rest, std::vector<std::string>({"a", "b", "-c"}));
+        EXPECT_EQ(os.str(), "");
+    }
+    {
+        std::vector<std::string_view> args{"prog", "1,2", "3"};
+        std::vector<int> ints;
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::with_sink(
+                po2::with_separator(
+                    po2::positional<std::vector<int>>(
+                        "ints", "Ints.", po2::one_or_more),
+                    ","),
+                std::back_inserter(ints)));
+        EXPECT_TRUE(result);
+        EXPECT_EQ(ints, std::vector<int>({1, 2, 3}));
+    }
+    {
+        std::vector<std::string_view> args{"prog", "1", "x"};
+        std::vector<int> ints;
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::with_sink(
+                po2::positional<std::vector<int>>(
+                    "ints", "Ints.", po2::one_or_more),
+                [&ints](int i) { ints.push_back(i); }));
+        EXPECT_EQ(result.error, po2::parse_option_error::unknown_arg);
+        EXPECT_EQ(result.token, "x");
+        EXPECT_EQ(ints, std::vector<int>({1}));
+    }
+    {
+        {
+            std::ofstream ofs("sink_response_file");
+            ofs << "a b \"c d\"\n";
+        }
+        std::vector<std::string_view> args{"prog", "@sink_response_file"};
+        std::vector<std::string> rest;
+        po2::string_any_map m;
+        auto const status = po2::try_parse_command_line(
+            args,
+            m,
+            po2::with_sink(
+                po2::remainder("rest", "Rest."),
+                [&rest](std::string_view sv) { rest.emplace_back(sv); }));
+        EXPECT_TRUE(status);
+        EXPECT_TRUE(m.empty());
+        EXPECT_EQ(rest, std::vector<std::string>({"a", "b", "c d"}));
+        std::remove("sink_response_file");
+    }
+    {
+        // A sink is not a default, and later decorators keep it.
+        std::vector<int> ints;
+        auto const opt = po2::with_validator(
+            po2::with_sink(
+                po2::positional<std::vector<int>>(
+                    "ints", "Ints.", po2::one_or_more),
+                std::back_inserter(ints)),
+            [](auto const &) { return po2::validation_result{}; });
+        static_assert(
+            !po2::detail::has_default<std::remove_cvref_t<decltype(opt)>>());
+
+        std::vector<std::string_view> args{"prog", "1", "2"};
+        po2::string_any_map m;
+        auto const status = po2::try_parse_command_line(args, m, opt);
+        EXPECT_TRUE(status);
+        EXPECT_TRUE(m.empty());
+        EXPECT_EQ(ints, std::vector<int>({1, 2}));
+    }
+}
+
 TEST(parse_command_line, response_files)
 {
     {
@@ -2107,3 +2300,260 @@ optional arguments:
 )");
     }
 }
+
+TEST(parse_command_line, nested_response_files)
+{
+    auto const arg =
+        po2::argument<std::vector<int>>("-a", "A.", po2::one_or_more);
+
+    {
+        std::ofstream ofs("nested_response_file_common");
+        ofs << "-a 1";
+    }
+    {
+        std::ofstream ofs("nested_response_file_top");
+        ofs << "@nested_response_file_common -a 2 @nested_response_file_common";
+    }
+    {
+        std::ofstream ofs("nested_response_file_cycle_0");
+        ofs << "-a 1 @nested_response_file_cycle_1";
+    }
+    {
+        std::ofstream ofs("nested_response_file_cycle_1");
+        ofs << "-a 2 @nested_response_file_cycle_0";
+    }
+    int const max_depth = po2::customizable_strings{}.max_response_file_depth;
+    for (int i = 0; i <= max_depth; ++i) {
+        std::ofstream ofs("nested_response_file_chain_" + std::to_string(i));
+        if (i < max_depth)
+            ofs << "@nested_response_file_chain_" << (i + 1);
+        else
+            ofs << "-a 3";
+    }
+
+    // A file referred to more than once is expanded each time.
+    {
+        std::vector<std::string_view> args{
+            "prog",
+            "@nested_response_file_top",
+            "@nested_response_file_common"};
+        auto const result = po2::try_parse_command_line(args, arg);
+        EXPECT_TRUE(result);
+        EXPECT_EQ(*result.value[0_c], std::vector<int>({1, 2, 1, 1}));
+    }
+
+    {
+        std::vector<std::string_view> args{
+            "prog", "@nested_response_file_cycle_0"};
+        auto const result = po2::try_parse_command_line(args, arg);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::response_file_cycle);
+        EXPECT_EQ(result.token, "@nested_response_file_cycle_0");
+    }
+
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog", "@nested_response_file_cycle_0"};
+        try {
+            po2::parse_command_line(args, "A program.", os, arg);
+        } catch (int) {
+        }
+        EXPECT_EQ(
+            os.str().find("error: response file "
+                          "'@nested_response_file_cycle_0' refers to itself"),
+            0u)
+            << os.str();
+    }
+
+    {
+        std::vector<std::string_view> args{
+            "prog", "@nested_response_file_chain_1"};
+        auto const result = po2::try_parse_command_line(args, arg);
+        EXPECT_TRUE(result);
+        EXPECT_EQ(*result.value[0_c], std::vector<int>({3}));
+    }
+
+    {
+        std::vector<std::string_view> args{
+            "prog", "@nested_response_file_chain_0"};
+        auto const result = po2::try_parse_command_line(args, arg);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(
+            result.error,
+            po2::parse_option_error::response_files_nested_too_deeply);
+    }
+
+    // The limit is a runtime setting.
+    {
+        po2::customizable_strings strings;
+        strings.max_response_file_depth = 2;
+        std::string const two_deep =
+            "@nested_response_file_chain_" + std::to_string(max_depth - 1);
+        std::string const three_deep =
+            "@nested_response_file_chain_" + std::to_string(max_depth - 2);
+
+        std::vector<std::string_view> args{"prog", two_deep};
+        auto result = po2::try_parse_command_line(args, strings, arg);
+        EXPECT_TRUE(result);
+        EXPECT_EQ(*result.value[0_c], std::vector<int>({3}));
+
+        args[1] = three_deep;
+        result = po2::try_parse_command_line(args, strings, arg);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(
+            result.error,
+            po2::parse_option_error::response_files_nested_too_deeply);
+    }
+
+    std::remove("nested_response_file_common");
+    std::remove("nested_response_file_top");
+    std::remove("nested_response_file_cycle_0");
+    std::remove("nested_response_file_cycle_1");
+    for (int i = 0; i <= max_depth; ++i) {
+        std::remove(
+            ("nested_response_file_chain_" + std::to_string(i)).c_str());
+    }
+}
+
+TEST(parse_command_line, try_parse_tuple)
+{
+    // success
+    {
+        std::vector<std::string_view> args{"prog", "-a", "3", "4"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::argument<int>("-a", "Arg."),
+            po2::positional<int>("pos", "Positional."));
+        EXPECT_TRUE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::none);
+        EXPECT_TRUE(result.value[0_c]);
+        EXPECT_EQ(*result.value[0_c], 3);
+        EXPECT_EQ(result.value[1_c], 4);
+    }
+
+    // unknown arg
+    {
+        std::vector<std::string_view> args{"prog", "4", "-b", "3"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::argument<int>("-a", "Arg."),
+            po2::positional<int>("pos", "Positional."));
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::unknown_arg);
+        EXPECT_EQ(result.token, "-b");
+        EXPECT_FALSE(result.help_requested);
+    }
+
+    // cannot parse arg
+    {
+        std::vector<std::string_view> args{"prog", "-a", "x"};
+        auto result = po2::try_parse_command_line(
+            args, po2::argument<int>("-a", "Arg."));
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::cannot_parse_arg);
+        EXPECT_EQ(result.token, "x");
+    }
+
+    // missing positional
+    {
+        std::vector<std::string_view> args{"prog", "-a", "3"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::argument<int>("-a", "Arg."),
+            po2::positional<int>("pos", "Positional."));
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::missing_positional);
+        EXPECT_EQ(result.token, "POS");
+    }
+
+    // validation error
+    {
+        std::vector<std::string_view> args{"prog", "-a", "no_such_file"};
+        auto result = po2::try_parse_command_line(
+            args, po2::file(po2::argument("-a", "Arg.")));
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::validation_error);
+        EXPECT_EQ(result.token, "no_such_file");
+    }
+
+    // default help
+    {
+        std::vector<std::string_view> args{"prog", "-a", "3", "--help"};
+        auto result = po2::try_parse_command_line(
+            args, po2::argument<int>("-a", "Arg."));
+        EXPECT_FALSE(result);
+        EXPECT_TRUE(result.help_requested);
+        EXPECT_EQ(result.error, po2::parse_option_error::none);
+    }
+
+    // user-supplied help and version
+    {
+        std::vector<std::string_view> args{"prog", "-?"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::argument<int>("-a", "Arg."),
+            po2::help("-?"),
+            po2::version("1.0"));
+        EXPECT_FALSE(result);
+        EXPECT_TRUE(result.help_requested);
+        EXPECT_FALSE(result.version_requested);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "--version"};
+        auto result = po2::try_parse_command_line(
+            args,
+            po2::argument<int>("-a", "Arg."),
+            po2::help("-?"),
+            po2::version("1.0"));
+        EXPECT_FALSE(result);
+        EXPECT_FALSE(result.help_requested);
+        EXPECT_TRUE(result.version_requested);
+    }
+
+    // help, on request
+    {
+        std::ostringstream os;
+        po2::print_help(
+            os, "prog", "A program.", po2::argument("-a", "Arg."));
+        EXPECT_EQ(os.str(), R"(usage:  prog [-h] [-a A]
+
+A program.
+
+optional arguments:
+  -h, --help  Print this help message and exit
+  -a          Arg.
+
+response files:
+  Use '@file' to load a file containing command line arguments.
+)");
+    }
+}
+
+TEST(parse_command_line, try_parse_map)
+{
+    {
+        std::vector<std::string_view> args{"prog", "-a", "3", "4"};
+        po2::string_any_map m;
+        auto const status = po2::try_parse_command_line(
+            args,
+            m,
+            po2::argument<int>("-a", "Arg."),
+            po2::positional<int>("pos", "Positional."));
+        EXPECT_TRUE(status);
+        EXPECT_EQ(std::any_cast<int>(m["a"]), 3);
+        EXPECT_EQ(std::any_cast<int>(m["pos"]), 4);
+    }
+    {
+        std::vector<std::string_view> args{"prog", "-a", "3", "4", "5"};
+        po2::string_any_map m;
+        auto const status = po2::try_parse_command_line(
+            args,
+            m,
+            po2::argument<int>("-a", "Arg."),
+            po2::positional<int>("pos", "Positional."));
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::unknown_arg);
+        EXPECT_EQ(status.token, "5");
+    }
+}
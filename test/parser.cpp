@@ -0,0 +1,317 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#define BOOST_PROGRAM_OPTIONS_2_TESTING
+#include <boost/program_options_2/parser.hpp>
+#include <boost/program_options_2/option_groups.hpp>
+
+#include <boost/mpl/assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory_resource>
+
+
+namespace po2 = boost::program_options_2;
+using boost::is_same;
+using boost::hana::tuple;
+using namespace boost::hana::literals;
+
+template<typename T>
+using opt = std::optional<T>;
+
+#define MIXED(T, choice0, choice1, choice2, default_)                          \
+    po2::argument<T>("-a,--abacus", "The abacus."),                            \
+        po2::with_default(                                                     \
+            po2::argument<std::optional<T>>(                                   \
+                "-b,--bobcat", "The bobcat.", po2::zero_or_one),               \
+            default_),                                                         \
+        po2::positional<std::vector<T>>("cataphract", "The cataphract", 2),    \
+        po2::argument<T>(                                                      \
+            "-d,--dolemite", "*The* Dolemite.", 1, choice0, choice1, choice2), \
+        po2::argument<std::vector<T>>(                                         \
+            "-z,--zero-plus", "None is fine; so is more.", po2::zero_or_more), \
+        po2::remainder("args", "other args at the end")
+
+TEST(parser, tuple)
+{
+    std::ostringstream os;
+    auto const parser =
+        po2::make_parser("A program.", os, MIXED(int, 4, 5, 6, 42));
+
+    {
+        std::vector<std::string_view> args{
+            "prog", "-a", "55", "-b", "66", "77", "88", "-d", "5", "2"};
+        auto result = parser.parse(args);
+        BOOST_MPL_ASSERT((is_same<
+                          decltype(result),
+                          tuple<
+                              opt<int>,
+                              opt<opt<int>>,
+                              std::vector<int>,
+                              opt<int>,
+                              opt<std::vector<int>>,
+                              std::vector<std::string_view>>>));
+        EXPECT_TRUE(result[0_c]);
+        EXPECT_EQ(*result[0_c], 55);
+        EXPECT_TRUE(result[1_c]);
+        EXPECT_EQ(*result[1_c], std::optional<int>{66});
+        EXPECT_EQ(result[2_c], std::vector<int>({77, 88}));
+        EXPECT_TRUE(result[3_c]);
+        EXPECT_EQ(*result[3_c], 5);
+        EXPECT_FALSE(result[4_c]);
+        EXPECT_EQ(result[5_c], std::vector<std::string_view>({"2"}));
+    }
+
+    // The same parser, reused; no state leaks from the previous parse.
+    {
+        std::vector<std::string_view> args{"prog", "77", "88", "-z", "2"};
+        auto result = parser.parse(args);
+        EXPECT_FALSE(result[0_c]);
+        EXPECT_TRUE(result[1_c]);
+        EXPECT_EQ(*result[1_c], std::optional<int>{42});
+        EXPECT_EQ(result[2_c], std::vector<int>({77, 88}));
+        EXPECT_FALSE(result[3_c]);
+        EXPECT_TRUE(result[4_c]);
+        EXPECT_EQ(*result[4_c], std::vector<int>({2}));
+        EXPECT_EQ(result[5_c], std::vector<std::string_view>({}));
+    }
+
+    {
+        char const * argv[] = {"prog", "1", "2", "-a", "3"};
+        auto result = parser.parse(5, argv);
+        EXPECT_TRUE(result[0_c]);
+        EXPECT_EQ(*result[0_c], 3);
+        EXPECT_EQ(result[2_c], std::vector<int>({1, 2}));
+    }
+
+    // Errors.
+    {
+        std::vector<std::string_view> args{"prog", "77", "88", "-d", "7"};
+        EXPECT_THROW(parser.parse(args), int);
+        EXPECT_TRUE(os.str().starts_with(
+            "error: '7' is not one of the allowed choices for '-d,--dolemite'"))
+            << os.str();
+    }
+}
+
+TEST(parser, map)
+{
+    std::ostringstream os;
+    auto const parser = po2::make_parser(
+        "A program.",
+        os,
+        po2::argument<int>("-a,--abacus", "The abacus."),
+        po2::positional<int>("bobcat", "The bobcat."),
+        po2::exclusive(
+            po2::flag("-c,--cataphract", "The cataphract."),
+            po2::flag("-d,--dolemite", "*The* Dolemite.")));
+
+    for (int i = 0; i < 3; ++i) {
+        std::vector<std::string_view> args{"prog", "-d", "--abacus", "1", "2"};
+        po2::string_any_map m;
+        parser.parse(args, m);
+        EXPECT_EQ(m.size(), 3u);
+        EXPECT_EQ(std::any_cast<int>(m["abacus"]), 1);
+        EXPECT_EQ(std::any_cast<int>(m["bobcat"]), 2);
+        EXPECT_EQ(std::any_cast<bool>(m["dolemite"]), true);
+    }
+}
+
+TEST(parser, try_parse)
+{
+    std::ostringstream os;
+    auto const parser =
+        po2::make_parser("A program.", os, MIXED(int, 4, 5, 6, 42));
+
+    {
+        std::vector<std::string_view> args{"prog", "77", "88", "-d", "5"};
+        auto result = parser.try_parse(args);
+        EXPECT_TRUE(result);
+        EXPECT_EQ(result.value[2_c], std::vector<int>({77, 88}));
+    }
+    {
+        std::vector<std::string_view> args{"prog", "77", "88", "-d", "7"};
+        auto result = parser.try_parse(args);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(result.error, po2::parse_option_error::no_such_choice);
+        EXPECT_EQ(result.token, "7");
+    }
+    {
+        std::vector<std::string_view> args{"prog", "-h"};
+        po2::string_any_map m;
+        auto const status = parser.try_parse(args, m);
+        EXPECT_FALSE(status);
+        EXPECT_TRUE(status.help_requested);
+    }
+    EXPECT_EQ(os.str(), "");
+
+    parser.print_help("prog");
+    EXPECT_TRUE(os.str().starts_with("usage:  prog [-h] [-a A]")) << os.str();
+}
+
+struct counting_resource : std::pmr::memory_resource
+{
+    explicit counting_resource(std::pmr::memory_resource * upstream) :
+        upstream_(upstream)
+    {}
+
+    int allocations = 0;
+    std::size_t outstanding_bytes = 0;
+    std::size_t peak_bytes = 0;
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        outstanding_bytes += bytes;
+        peak_bytes = (std::max)(peak_bytes, outstanding_bytes);
+        return upstream_->allocate(bytes, alignment);
+    }
+    void
+    do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+    {
+        outstanding_bytes -= bytes;
+        upstream_->deallocate(p, bytes, alignment);
+    }
+    bool
+    do_is_equal(std::pmr::memory_resource const & other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource * upstream_;
+};
+
+// Makes any use of the default resource throw, until destroyed.
+struct no_default_resource
+{
+    no_default_resource() :
+        prev_(std::pmr::set_default_resource(std::pmr::null_memory_resource()))
+    {}
+    ~no_default_resource() { std::pmr::set_default_resource(prev_); }
+
+    std::pmr::memory_resource * prev_;
+};
+
+TEST(parser, memory_resource)
+{
+    std::ostringstream os;
+    auto const parser = po2::make_parser(
+        "A program.",
+        os,
+        po2::argument<int>("-a,--abacus", "The abacus."),
+        po2::positional<int>("bobcat", "The bobcat."),
+        po2::exclusive(
+            po2::flag("-c,--cataphract", "The cataphract."),
+            po2::flag("-d,--dolemite", "*The* Dolemite.")),
+        po2::response_file("-r,--response-file", "A response file."));
+
+    {
+        std::ofstream ofs("parser_memory_resource_file");
+        ofs << "--abacus 1 \"2\"";
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        std::pmr::monotonic_buffer_resource arena;
+        counting_resource resource(&arena);
+        std::vector<std::string_view> args{
+            "/a/very/long/path/to/prog",
+            "-d",
+            "@parser_memory_resource_file"};
+        po2::string_any_map m;
+        {
+            no_default_resource no_default;
+            parser.parse(args, m, resource);
+        }
+        EXPECT_LT(0, resource.allocations);
+        EXPECT_EQ(m.size(), 3u);
+        EXPECT_EQ(std::any_cast<int>(m["abacus"]), 1);
+        EXPECT_EQ(std::any_cast<int>(m["bobcat"]), 2);
+        EXPECT_EQ(std::any_cast<bool>(m["dolemite"]), true);
+    }
+
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<std::string_view> args{
+            "prog", "--response-file", "parser_memory_resource_file"};
+        po2::string_any_map m;
+        po2::parse_status status;
+        {
+            no_default_resource no_default;
+            status = parser.try_parse(args, m, arena);
+        }
+        EXPECT_TRUE(status);
+        EXPECT_EQ(std::any_cast<int>(m["bobcat"]), 2);
+    }
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<std::string_view> args{"prog", "-c", "-a", "1"};
+        po2::string_any_map m;
+        po2::parse_status status;
+        {
+            no_default_resource no_default;
+            status = parser.try_parse(args, m, arena);
+        }
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::missing_positional);
+        EXPECT_EQ(status.token, "BOBCAT");
+    }
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<std::string_view> args{"prog", "-c", "-d", "-a", "1"};
+        po2::string_any_map m;
+        auto const status = parser.try_parse(args, m, arena);
+        EXPECT_FALSE(status);
+        EXPECT_EQ(
+            status.error,
+            po2::parse_option_error::too_many_mutually_exclusives);
+    }
+
+    std::remove("parser_memory_resource_file");
+}
+
+TEST(parser, response_file_sink)
+{
+    // Streaming a large response file through a sink holds on to no more
+    // than the file itself (when it is read rather than mapped) and a
+    // bounded amount of bookkeeping; nothing is kept per token.
+    int const token_count = 200000;
+    std::size_t file_size = 0;
+    {
+        std::ofstream ofs("parser_response_file_sink_file");
+        for (int i = 0; i < token_count; ++i) {
+            ofs << "x ";
+        }
+        file_size = 2 * token_count;
+    }
+
+    int seen = 0;
+    std::ostringstream os;
+    auto const parser = po2::make_parser(
+        "A program.",
+        os,
+        po2::with_sink(
+            po2::remainder("rest", "Rest."),
+            [&seen](std::string_view sv) {
+                if (sv == "x")
+                    ++seen;
+            }));
+
+    counting_resource resource(std::pmr::new_delete_resource());
+    std::vector<std::string_view> args{
+        "prog", "@parser_response_file_sink_file"};
+    po2::string_any_map m;
+    auto const status = parser.try_parse(args, m, resource);
+    EXPECT_TRUE(status);
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(seen, token_count);
+    EXPECT_LT(resource.peak_bytes, file_size + (1 << 16));
+
+    std::remove("parser_response_file_sink_file");
+}
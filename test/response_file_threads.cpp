@@ -0,0 +1,160 @@
+// Copyright (C) 2020 T. Zachary Laine
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+#include <boost/program_options_2/parser.hpp>
+#include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/response_file_buffers.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <map>
+
+
+namespace po2 = boost::program_options_2;
+
+#define OPTIONS                                                                \
+    po2::argument<int>("-a,--abacus", "The abacus."),                          \
+        po2::argument<std::vector<int>>(                                       \
+            "-b,--bobcat", "The bobcat.", po2::one_or_more),                   \
+        po2::flag("-v,--verbose", "Verbose."),                                 \
+        po2::argument<std::string>("-n,--name", "The name."),                  \
+        po2::remainder<std::vector<std::string>>("args", "The rest.")
+
+po2::customizable_strings threaded_strings()
+{
+    po2::customizable_strings retval;
+    retval.response_file_threads = 4;
+    return retval;
+}
+
+// Returns m, with each std::any replaced by a string with its value.
+std::map<std::string, std::string> values(po2::string_any_map const & m)
+{
+    std::map<std::string, std::string> retval;
+    for (auto const & [key, value] : m) {
+        std::string & str = retval[key];
+        if (auto const * x = std::any_cast<int>(&value)) {
+            str = std::to_string(*x);
+        } else if (auto const * x = std::any_cast<bool>(&value)) {
+            str = *x ? "true" : "false";
+        } else if (auto const * x = std::any_cast<std::string>(&value)) {
+            str = *x;
+        } else if (auto const * x = std::any_cast<std::vector<int>>(&value)) {
+            for (auto i : *x) {
+                str += std::to_string(i) + ' ';
+            }
+        } else if (
+            auto const * x =
+                std::any_cast<std::vector<std::string>>(&value)) {
+            for (auto const & s : *x) {
+                str += s + ' ';
+            }
+        } else {
+            ADD_FAILURE() << "unexpected type for " << key;
+        }
+    }
+    return retval;
+}
+
+TEST(response_file_threads, same_as_serial)
+{
+    {
+        std::ofstream ofs("threaded_response_file_0");
+        ofs << "-a 1 -b 2 3";
+    }
+    {
+        std::ofstream ofs("threaded_response_file_1");
+        ofs << "@threaded_response_file_2 -b 4\n--name \"a name\"";
+    }
+    {
+        std::ofstream ofs("threaded_response_file_2");
+        ofs << "-b 5";
+    }
+    {
+        std::ofstream ofs("threaded_response_file_3");
+        ofs << "x y";
+    }
+
+    std::ostringstream os;
+    auto const strings = threaded_strings();
+    auto const parser = po2::make_parser("A program.", os, strings, OPTIONS);
+
+    std::vector<std::string_view> const args{
+        "prog",
+        "@threaded_response_file_0",
+        "-v",
+        "@threaded_response_file_1",
+        "@threaded_response_file_3"};
+
+    // The same args, with the contents of each response file written out in
+    // place of the file.
+    std::vector<std::string_view> const serial_args{
+        "prog", "-a", "1", "-b", "2", "3", "-v", "-b", "5", "-b", "4",
+        "--name", "a name", "x", "y"};
+    po2::string_any_map serial;
+    parser.parse(serial_args, serial);
+    EXPECT_EQ(serial.size(), 5u);
+
+    // Each parse reuses the threads of the last.
+    for (int i = 0; i < 2; ++i) {
+        po2::string_any_map m;
+        parser.parse(args, m);
+        EXPECT_EQ(values(m), values(serial));
+    }
+    for (int i = 0; i < 2; ++i) {
+        po2::string_any_map m;
+        po2::parse_command_line(args, m, "A program.", os, strings, OPTIONS);
+        EXPECT_EQ(values(m), values(serial));
+    }
+    EXPECT_EQ(po2::detail::default_thread_pool().size(), 2u);
+
+    for (int i = 0; i < 4; ++i) {
+        std::remove(("threaded_response_file_" + std::to_string(i)).c_str());
+    }
+}
+
+TEST(response_file_threads, values_are_not_prefetched)
+{
+    {
+        std::ofstream ofs("threaded_response_file_a");
+        ofs << "-a 1";
+    }
+    {
+        std::ofstream ofs("threaded_response_file_b");
+        ofs << "-b 2";
+    }
+    {
+        std::ofstream ofs("threaded_response_file_c");
+        ofs << "-b 3";
+    }
+
+    std::ostringstream os;
+    auto const parser =
+        po2::make_parser("A program.", os, threaded_strings(), OPTIONS);
+
+    // "@threaded_response_file_c" is the value of --name, so it must not be
+    // read.
+    std::vector<std::string_view> const args{
+        "prog",
+        "@threaded_response_file_a",
+        "-v",
+        "@threaded_response_file_b",
+        "--name",
+        "@threaded_response_file_c"};
+    po2::string_any_map m;
+    po2::response_file_buffers buffers;
+    parser.parse(args, m, buffers);
+    EXPECT_EQ(buffers.size(), 2u);
+    EXPECT_EQ(std::any_cast<int>(m["abacus"]), 1);
+    EXPECT_EQ(
+        std::any_cast<std::vector<int>>(m["bobcat"]), std::vector<int>{2});
+    EXPECT_EQ(
+        std::any_cast<std::string>(m["name"]), "@threaded_response_file_c");
+
+    for (char c : {'a', 'b', 'c'}) {
+        std::remove((std::string("threaded_response_file_") + c).c_str());
+    }
+}
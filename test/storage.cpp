@@ -3,11 +3,36 @@
 // Distributed under the Boost Software License, Version 1.0. (See
 // accompanying file LICENSE_1_0.txt or copy at
 // http://www.boost.org/LICENSE_1_0.txt)
+#include <boost/program_options_2/option_groups.hpp>
+#include <boost/program_options_2/option_value.hpp>
 #include <boost/program_options_2/parse_command_line.hpp>
+#include <boost/program_options_2/parser.hpp>
+#include <boost/program_options_2/shared_storage.hpp>
 #include <boost/program_options_2/storage.hpp>
+#include <boost/program_options_2/typed_options.hpp>
+#include <boost/program_options_2/watched_storage.hpp>
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if BOOST_PROGRAM_OPTIONS_2_USE_SHARED_MEMORY
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
+
 // TODO: Document that the option default type (std::string_view) causes
 // dangling when loading from files.
 
@@ -38,6 +63,12 @@ namespace po2 = boost::program_options_2;
         po2::remainder<std::vector<std::string>>(                              \
             "args", "other args at the end")
 
+#define STRING_VIEWS                                                           \
+    po2::argument("-a,--abacus", "The abacus."),                               \
+        po2::positional<std::vector<std::string_view>>(                        \
+            "cataphract", "The cataphract", 2),                                \
+        po2::response_file("-r,--response-file", "A response file.")
+
 TEST(storage, save_load_response_file)
 {
     // Just arguments
@@ -434,6 +465,11 @@ TEST(storage, save_load_json_file)
         po2::parse_command_line(
             args, m, "A program.", os, ARGUMENTS(int, 4, 5, 6));
 
+        {
+            std::ofstream ofs("dummy_file");
+            ofs << "{\n";
+        }
+
         EXPECT_THROW(
             po2::save_json_file(
                 "dummy_file",
@@ -450,6 +486,10 @@ TEST(storage, save_load_json_file)
         } catch (po2::save_error & e) {
             EXPECT_EQ(e.error(), po2::save_result::bad_any_cast);
         }
+
+        // A failed save leaves the existing file alone.
+        std::ifstream ifs("dummy_file");
+        EXPECT_EQ(po2::detail::file_slurp(ifs), "{\n");
     }
     {
         po2::string_any_map m;
@@ -573,5 +613,1169 @@ TEST(storage, save_load_json_file)
     }
 }
 
+TEST(storage, load_json_file_binding)
+{
+    {
+        std::ofstream ofs("json_map_for_binding");
+        ofs << R"({
+    # Keys may be any name of an option, or the name of a positional.
+    "-a": 1,
+    "--dolemite": 5,
+    "cataphract": [7, -8],
+    "args": ["x", "tab\there", "\u00e9\ud83d\ude00"],
+    "--bobcat": null
+})";
+    }
+    {
+        po2::string_any_map m;
+        po2::load_json_file(
+            "json_map_for_binding", m, MIXED(int, 4, 5, 6, 42));
+
+        EXPECT_EQ(m.size(), 5u);
+        EXPECT_EQ(std::any_cast<int>(m["abacus"]), 1);
+        EXPECT_EQ(std::any_cast<int>(m["bobcat"]), 42);
+        EXPECT_EQ(
+            std::any_cast<std::vector<int>>(m["cataphract"]),
+            std::vector<int>({7, -8}));
+        EXPECT_EQ(std::any_cast<int>(m["dolemite"]), 5);
+        EXPECT_EQ(
+            std::any_cast<std::vector<std::string>>(m["args"]),
+            std::vector<std::string>(
+                {"x", "tab\there", "\xc3\xa9\xf0\x9f\x98\x80"}));
+    }
+
+    {
+        std::ofstream ofs("json_map_for_binding");
+        ofs << R"({"--flag": true, "-v": 3, "--ids": ["1,2", 3]})";
+    }
+    {
+        po2::string_any_map m;
+        po2::load_json_file(
+            "json_map_for_binding",
+            m,
+            po2::flag("-f,--flag", "F."),
+            po2::counted_flag("-v,--verbose", "V."),
+            po2::with_separator(
+                po2::argument<std::vector<int>>(
+                    "--ids", "IDs.", po2::one_or_more),
+                ","));
+
+        EXPECT_EQ(m.size(), 3u);
+        EXPECT_EQ(std::any_cast<bool>(m["flag"]), true);
+        EXPECT_EQ(std::any_cast<int>(m["verbose"]), 3);
+        EXPECT_EQ(
+            std::any_cast<std::vector<int>>(m["ids"]),
+            std::vector<int>({1, 2, 3}));
+    }
+
+    std::pair<char const *, po2::load_result> const bad_maps[] = {
+        {R"({"--nope": 1})", po2::load_result::unknown_arg},
+        {R"({"cataphract": [1]})", po2::load_result::wrong_number_of_args},
+        {R"({"-a": [1, 2]})", po2::load_result::wrong_number_of_args},
+        {R"({"-a": "x"})", po2::load_result::cannot_parse_arg},
+        {R"({"-a": 1.5})", po2::load_result::cannot_parse_arg},
+        {R"({"-a": {"-b": 1}})", po2::load_result::cannot_parse_arg},
+        {R"({"-d": 7})", po2::load_result::no_such_choice},
+        {R"({"-a": 1,})", po2::load_result::malformed_json},
+        {R"({"-a": 01})", po2::load_result::malformed_json},
+        {R"({"-a": "\q"})", po2::load_result::malformed_json},
+        {R"([1])", po2::load_result::malformed_json},
+        {R"({} {})", po2::load_result::malformed_json},
+    };
+    for (auto [contents, expected] : bad_maps) {
+        {
+            std::ofstream ofs("json_map_for_binding");
+            ofs << contents;
+        }
+        po2::string_any_map m;
+        try {
+            po2::load_json_file(
+                "json_map_for_binding", m, MIXED(int, 4, 5, 6, 42));
+            ADD_FAILURE() << contents;
+        } catch (po2::load_error & e) {
+            EXPECT_EQ(e.error(), expected) << contents;
+        }
+    }
+
+    std::remove("json_map_for_binding");
+}
+
+TEST(storage, save_json_file_typed)
+{
+    auto const flag = po2::flag("-f,--flag", "F.");
+    auto const ratio = po2::argument<double>("-r,--ratio", "R.");
+    auto const big = po2::argument<unsigned long long>("-b,--big", "B.");
+    auto const name = po2::argument<std::string>("-n,--name", "N.");
+    auto const words = po2::argument<std::vector<std::string>>(
+        "-w,--words", "W.", po2::one_or_more);
+    auto save = [&](auto const & m) {
+        po2::save_json_file(
+            "saved_typed_json_map", m, flag, ratio, big, name, words);
+    };
+    auto load = [&](auto & m) {
+        po2::load_json_file(
+            "saved_typed_json_map", m, flag, ratio, big, name, words);
+    };
+
+    po2::string_any_map m;
+    m["flag"] = true;
+    m["ratio"] = 0.1;
+    m["big"] = 18446744073709551615ull;
+    m["name"] = std::string("a \"quoted\"\\name\n\x01\xc3\xa9");
+    m["words"] = std::vector<std::string>({"x", "tab\there"});
+    save(m);
+
+    {
+        std::ifstream ifs("saved_typed_json_map");
+        EXPECT_EQ(po2::detail::file_slurp(ifs), R"({
+    "--flag": true,
+    "--ratio": 0.1,
+    "--big": 18446744073709551615,
+    "--name": "a \"quoted\"\\name\n\u0001)"
+                  "\xc3\xa9"
+                  R"(",
+    "--words": [ "x", "tab\there" ]
+}
+)");
+    }
+
+    po2::string_any_map loaded;
+    load(loaded);
+    EXPECT_EQ(loaded.size(), 5u);
+    EXPECT_EQ(std::any_cast<bool>(loaded["flag"]), true);
+    EXPECT_EQ(std::any_cast<double>(loaded["ratio"]), 0.1);
+    EXPECT_EQ(
+        std::any_cast<unsigned long long>(loaded["big"]),
+        18446744073709551615ull);
+    EXPECT_EQ(
+        std::any_cast<std::string>(loaded["name"]),
+        std::any_cast<std::string>(m["name"]));
+    EXPECT_EQ(
+        std::any_cast<std::vector<std::string>>(loaded["words"]),
+        std::any_cast<std::vector<std::string>>(m["words"]));
+
+    // Values that JSON has no numbers for are written as strings.
+    m["ratio"] = std::numeric_limits<double>::infinity();
+    save(m);
+    loaded.clear();
+    load(loaded);
+    EXPECT_EQ(
+        std::any_cast<double>(loaded["ratio"]),
+        std::numeric_limits<double>::infinity());
+
+    try {
+        po2::save_json_file("no_such_directory/saved_typed_json_map", m, flag);
+        ADD_FAILURE();
+    } catch (po2::save_error & e) {
+        EXPECT_EQ(e.error(), po2::save_result::could_not_open_file_for_writing);
+    }
+
+    std::remove("saved_typed_json_map");
+}
+
+TEST(storage, save_load_binary_file)
+{
+    {
+        std::ostringstream os;
+        std::vector<std::string_view> args{
+            "prog",
+            "-a",
+            "55",
+            "77",
+            "88",
+            "--dolemite",
+            "5",
+            "\\2\"",
+            "two words"};
+        po2::string_any_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+
+        EXPECT_EQ(m.size(), 5u);
+
+        po2::save_binary_file("saved_binary_map", m, MIXED(int, 4, 5, 6, 42));
+    }
+    {
+        po2::string_any_map m;
+        po2::load_binary_file("saved_binary_map", m, MIXED(int, 4, 5, 6, 42));
+
+        EXPECT_EQ(m.size(), 5u);
+        EXPECT_EQ(std::any_cast<int>(m["abacus"]), 55);
+        EXPECT_EQ(std::any_cast<int>(m["bobcat"]), 42);
+        EXPECT_EQ(
+            std::any_cast<std::vector<int>>(m["cataphract"]),
+            std::vector<int>({77, 88}));
+        EXPECT_EQ(std::any_cast<int>(m["dolemite"]), 5);
+        EXPECT_EQ(
+            std::any_cast<std::vector<std::string>>(m["args"]),
+            std::vector<std::string>({"\\2\"", "two words"}));
+    }
+
+    std::string contents;
+    {
+        std::ifstream ifs("saved_binary_map", std::ios_base::binary);
+        contents = po2::detail::file_slurp(ifs);
+    }
+
+    auto error_from = [](std::string_view buffer, auto const &... opts) {
+        po2::string_any_map m;
+        try {
+            po2::load_binary_buffer(buffer, m, opts...);
+        } catch (po2::load_error & e) {
+            return e.error();
+        }
+        return po2::load_result::success;
+    };
+
+    EXPECT_EQ(
+        error_from(contents, MIXED(int, 4, 5, 6, 42)),
+        po2::load_result::success);
+    EXPECT_EQ(
+        error_from(contents, MIXED(short, 4, 5, 6, 42)),
+        po2::load_result::schema_mismatch);
+    EXPECT_EQ(
+        error_from(contents, ARGUMENTS(int, 4, 5, 6)),
+        po2::load_result::schema_mismatch);
+    EXPECT_EQ(
+        error_from(
+            std::string_view(contents).substr(0, contents.size() - 1),
+            MIXED(int, 4, 5, 6, 42)),
+        po2::load_result::malformed_binary);
+    EXPECT_EQ(
+        error_from(contents + '\0', MIXED(int, 4, 5, 6, 42)),
+        po2::load_result::malformed_binary);
+    EXPECT_EQ(
+        error_from("{}", MIXED(int, 4, 5, 6, 42)),
+        po2::load_result::malformed_binary);
+
+    {
+        po2::string_any_map m;
+        try {
+            po2::load_binary_file(
+                "no_such_binary_map", m, MIXED(int, 4, 5, 6, 42));
+            ADD_FAILURE();
+        } catch (po2::load_error & e) {
+            EXPECT_EQ(
+                e.error(), po2::load_result::could_not_open_file_for_reading);
+        }
+    }
+
+    // Optionals, string_views that refer into the buffer, and mutually
+    // exclusive options.
+    {
+        auto const opts = [] {
+            return std::tuple(
+                po2::argument<std::optional<int>>("--opt", "Opt."),
+                po2::argument<std::string_view>("--name", "Name."),
+                po2::exclusive(
+                    po2::flag("--yes", "Yes."), po2::flag("--no", "No.")));
+        };
+        po2::string_any_map m;
+        m["opt"] = std::optional<int>(3);
+        m["name"] = std::string_view("a name");
+        m["no"] = true;
+        std::apply(
+            [&](auto const &... opt) {
+                po2::save_binary_file("saved_binary_map", m, opt...);
+            },
+            opts());
+
+        std::ifstream ifs("saved_binary_map", std::ios_base::binary);
+        std::string const buffer = po2::detail::file_slurp(ifs);
+        po2::string_any_map loaded;
+        std::apply(
+            [&](auto const &... opt) {
+                po2::load_binary_buffer(buffer, loaded, opt...);
+            },
+            opts());
+
+        EXPECT_EQ(loaded.size(), 3u);
+        EXPECT_EQ(
+            std::any_cast<std::optional<int>>(loaded["opt"]),
+            std::optional<int>(3));
+        auto const name = std::any_cast<std::string_view>(loaded["name"]);
+        EXPECT_EQ(name, "a name");
+        EXPECT_TRUE(
+            buffer.data() <= name.data() &&
+            name.data() + name.size() <= buffer.data() + buffer.size());
+        EXPECT_EQ(std::any_cast<bool>(loaded["no"]), true);
+    }
+
+    // An option of the same type as the options in a mutually exclusive
+    // group that follows it.
+    {
+        auto const opts = [] {
+            return std::tuple(
+                po2::argument<int>("--x", "X."),
+                po2::exclusive(
+                    po2::argument<int>("--a", "A."),
+                    po2::argument<int>("--b", "B.")));
+        };
+        po2::string_any_map m;
+        m["x"] = 1;
+        m["a"] = 2;
+        std::apply(
+            [&](auto const &... opt) {
+                po2::save_binary_file("saved_binary_map", m, opt...);
+            },
+            opts());
+
+        po2::string_any_map loaded;
+        std::apply(
+            [&](auto const &... opt) {
+                po2::load_binary_file("saved_binary_map", loaded, opt...);
+            },
+            opts());
+
+        EXPECT_EQ(loaded.size(), 2u);
+        EXPECT_EQ(std::any_cast<int>(loaded["x"]), 1);
+        EXPECT_EQ(std::any_cast<int>(loaded["a"]), 2);
+    }
+
+    std::remove("saved_binary_map");
+}
+
+struct transparent_string_hash
+{
+    using is_transparent = void;
+    std::size_t operator()(std::string_view sv) const
+    {
+        return std::hash<std::string_view>{}(sv);
+    }
+};
+
+TEST(storage, heterogeneous_maps)
+{
+    using ordered_map = std::map<std::string, std::any, std::less<>>;
+    using unordered_map = std::unordered_map<
+        std::string,
+        std::any,
+        transparent_string_hash,
+        std::equal_to<>>;
+
+    static_assert(po2::options_map<ordered_map>);
+    static_assert(po2::heterogeneous_options_map<ordered_map>);
+    static_assert(po2::options_map<unordered_map>);
+    static_assert(po2::heterogeneous_options_map<unordered_map>);
+    static_assert(!po2::heterogeneous_options_map<po2::string_any_map>);
+    static_assert(!po2::heterogeneous_options_map<po2::string_view_any_map>);
+
+    std::vector<std::string_view> const args{
+        "prog", "-a", "55", "77", "88", "--dolemite", "5", "two", "words"};
+
+    auto check = [](auto & m) {
+        EXPECT_EQ(m.size(), 5u);
+        EXPECT_EQ(std::any_cast<int>(m.find("abacus")->second), 55);
+        EXPECT_EQ(std::any_cast<int>(m.find("bobcat")->second), 42);
+        EXPECT_EQ(
+            std::any_cast<std::vector<int>>(m.find("cataphract")->second),
+            std::vector<int>({77, 88}));
+        EXPECT_EQ(std::any_cast<int>(m.find("dolemite")->second), 5);
+        EXPECT_EQ(
+            std::any_cast<std::vector<std::string>>(m.find("args")->second),
+            std::vector<std::string>({"two", "words"}));
+    };
+
+    {
+        std::ostringstream os;
+        ordered_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+        check(m);
+
+        po2::save_response_file(
+            "saved_heterogeneous_map",
+            po2::customizable_strings{},
+            m,
+            MIXED(int, 4, 5, 6, 42));
+    }
+    {
+        ordered_map m;
+        po2::load_response_file(
+            "saved_heterogeneous_map", m, MIXED(int, 4, 5, 6, 42));
+        check(m);
+    }
+    {
+        std::ostringstream os;
+        unordered_map m;
+        auto const parser =
+            po2::make_parser("A program.", os, MIXED(int, 4, 5, 6, 42));
+        parser.parse(args, m);
+        check(m);
+
+        po2::save_json_file(
+            "saved_heterogeneous_map", m, MIXED(int, 4, 5, 6, 42));
+    }
+    {
+        unordered_map m;
+        po2::load_json_file(
+            "saved_heterogeneous_map", m, MIXED(int, 4, 5, 6, 42));
+        check(m);
+    }
+    {
+        ordered_map m;
+        m["abacus"] = 1;
+        po2::load_json_file(
+            "saved_heterogeneous_map", m, MIXED(int, 4, 5, 6, 42));
+        check(m);
+    }
+
+    std::remove("saved_heterogeneous_map");
+}
+
+TEST(storage, option_value)
+{
+    static_assert(po2::erased_type<po2::option_value>);
+    static_assert(po2::options_map<po2::string_option_value_map>);
+    static_assert(
+        sizeof(std::vector<std::string>) <= po2::option_value::inline_size);
+
+    using big = std::array<std::string, 4>;
+
+    {
+        po2::option_value v;
+        EXPECT_TRUE(po2::any_empty(v));
+        EXPECT_THROW(po2::any_cast<int>(v), std::bad_any_cast);
+
+        v = std::vector<int>({1, 2, 3});
+        EXPECT_FALSE(po2::any_empty(v));
+        EXPECT_TRUE(v.holds<std::vector<int>>());
+        EXPECT_FALSE(v.holds<std::vector<double>>());
+        EXPECT_EQ(v.get_if<int>(), nullptr);
+        EXPECT_THROW(po2::any_cast<double>(v), std::bad_any_cast);
+
+        // Held inline.
+        auto const * ptr = v.get_if<std::vector<int>>();
+        EXPECT_GE((void const *)ptr, (void const *)&v);
+        EXPECT_LT((void const *)ptr, (void const *)(&v + 1));
+
+        po2::any_cast<std::vector<int> &>(v).push_back(4);
+        po2::option_value const copy = v;
+        EXPECT_EQ(
+            po2::any_cast<std::vector<int> const &>(copy),
+            std::vector<int>({1, 2, 3, 4}));
+
+        po2::option_value moved = std::move(v);
+        EXPECT_TRUE(po2::any_empty(v));
+        EXPECT_EQ(
+            po2::any_cast<std::vector<int>>(moved),
+            std::vector<int>({1, 2, 3, 4}));
+
+        // Too big to be held inline.
+        moved = big{{"a", "b", "c", "d"}};
+        po2::option_value big_copy = moved;
+        EXPECT_EQ(po2::any_cast<big const &>(big_copy)[3], "d");
+        EXPECT_NE(
+            moved.get_if<big>(),
+            std::as_const(big_copy).get_if<big>());
+        moved.reset();
+        EXPECT_TRUE(po2::any_empty(moved));
+        EXPECT_EQ(po2::any_cast<big const &>(big_copy)[0], "a");
+    }
+    {
+        // Types whose operations are identical are still told apart.
+        po2::option_value v = 1;
+        EXPECT_TRUE(v.holds<int>());
+        EXPECT_FALSE(v.holds<unsigned int>());
+        EXPECT_THROW(po2::any_cast<unsigned int>(v), std::bad_any_cast);
+    }
+    {
+        // Assigning from the held value.
+        std::string const long_string(100, 'x');
+        po2::option_value v = long_string;
+        v = po2::any_cast<std::string const &>(v);
+        EXPECT_EQ(po2::any_cast<std::string const &>(v), long_string);
+        v.emplace<std::string>(po2::any_cast<std::string const &>(v), 90);
+        EXPECT_EQ(po2::any_cast<std::string const &>(v), std::string(10, 'x'));
+
+        v = big{{long_string, "b", "c", "d"}};
+        v = po2::any_cast<big const &>(v)[0];
+        EXPECT_EQ(po2::any_cast<std::string const &>(v), long_string);
+    }
+
+    std::vector<std::string_view> const args{
+        "prog", "-a", "55", "77", "88", "--dolemite", "5", "two", "words"};
+
+    auto check = [](po2::string_option_value_map const & m) {
+        EXPECT_EQ(m.size(), 5u);
+        EXPECT_EQ(po2::any_cast<int const &>(m.at("abacus")), 55);
+        EXPECT_EQ(po2::any_cast<int const &>(m.at("bobcat")), 42);
+        EXPECT_EQ(
+            po2::any_cast<std::vector<int> const &>(m.at("cataphract")),
+            std::vector<int>({77, 88}));
+        EXPECT_EQ(po2::any_cast<int const &>(m.at("dolemite")), 5);
+        EXPECT_EQ(
+            po2::any_cast<std::vector<std::string> const &>(m.at("args")),
+            std::vector<std::string>({"two", "words"}));
+    };
+
+    {
+        std::ostringstream os;
+        po2::string_option_value_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+        check(m);
+
+        po2::save_response_file(
+            "saved_option_value_map",
+            po2::customizable_strings{},
+            m,
+            MIXED(int, 4, 5, 6, 42));
+    }
+    {
+        po2::string_option_value_map m;
+        po2::load_response_file(
+            "saved_option_value_map", m, MIXED(int, 4, 5, 6, 42));
+        check(m);
+
+        po2::save_binary_file(
+            "saved_option_value_map", m, MIXED(int, 4, 5, 6, 42));
+    }
+    {
+        po2::string_option_value_map m;
+        po2::load_binary_file(
+            "saved_option_value_map", m, MIXED(int, 4, 5, 6, 42));
+        check(m);
+    }
+
+    std::remove("saved_option_value_map");
+}
+
+TEST(storage, typed_options)
+{
+    using namespace boost::hana::literals;
+
+    std::vector<std::string_view> const args{
+        "prog", "-a", "55", "1", "2", "--dolemite", "5", "x", "y"};
+
+    {
+        po2::typed_options result(MIXED(int, 4, 5, 6, 42));
+        static_assert(result.size() == 5u);
+        static_assert(std::is_same_v<
+                      std::remove_cvref_t<decltype(result[1_c])>,
+                      std::optional<int>>);
+        EXPECT_FALSE(result[0_c]);
+        EXPECT_FALSE(result.contains("abacus"));
+        EXPECT_FALSE(result.get_if<int>("abacus"));
+
+        std::ostringstream os;
+        po2::parse_command_line(
+            args, result, "A program.", os, MIXED(int, 4, 5, 6, 42));
+
+        EXPECT_EQ(result[0_c], 55);
+        EXPECT_EQ(result[1_c], 42);
+        EXPECT_EQ(result[2_c], std::vector<int>({1, 2}));
+        EXPECT_EQ(result[3_c], 5);
+        EXPECT_EQ(result[4_c], std::vector<std::string>({"x", "y"}));
+
+        EXPECT_EQ(result.index("abacus"), 0);
+        EXPECT_EQ(result.index("cataphract"), 2);
+        EXPECT_EQ(result.index("args"), 4);
+        EXPECT_EQ(result.index("--abacus"), -1);
+        EXPECT_EQ(result.index("zebra"), -1);
+        EXPECT_TRUE(result.contains("bobcat"));
+        EXPECT_FALSE(result.contains("zebra"));
+        ASSERT_TRUE(result.get_if<int>("abacus"));
+        EXPECT_EQ(*result.get_if<int>("abacus"), 55);
+        ASSERT_TRUE(result.get_if<std::vector<int>>("cataphract"));
+        EXPECT_EQ(
+            *result.get_if<std::vector<int>>("cataphract"),
+            std::vector<int>({1, 2}));
+        EXPECT_FALSE(result.get_if<double>("abacus"));
+        EXPECT_FALSE(result.get_if<int>("zebra"));
+
+        // The same values, parsed into a map.
+        po2::string_any_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+
+        // Saved from either, the values are the same.
+        po2::save_response_file(
+            "saved_typed_map",
+            po2::customizable_strings{},
+            result,
+            MIXED(int, 4, 5, 6, 42));
+        po2::save_response_file(
+            "saved_map_for_typed",
+            po2::customizable_strings{},
+            m,
+            MIXED(int, 4, 5, 6, 42));
+        {
+            po2::typed_options loaded(MIXED(int, 4, 5, 6, 42));
+            po2::load_response_file(
+                "saved_map_for_typed", loaded, MIXED(int, 4, 5, 6, 42));
+            EXPECT_EQ(loaded.values, result.values);
+            po2::string_any_map loaded_m;
+            po2::load_response_file(
+                "saved_typed_map", loaded_m, MIXED(int, 4, 5, 6, 42));
+            EXPECT_EQ(loaded_m.size(), m.size());
+            EXPECT_EQ(std::any_cast<int>(loaded_m["abacus"]), 55);
+            EXPECT_EQ(
+                std::any_cast<std::vector<int>>(loaded_m["cataphract"]),
+                std::vector<int>({1, 2}));
+        }
+
+        po2::save_json_file("saved_typed_map", result, MIXED(int, 4, 5, 6, 42));
+        {
+            po2::typed_options loaded(MIXED(int, 4, 5, 6, 42));
+            po2::load_json_file(
+                "saved_typed_map", loaded, MIXED(int, 4, 5, 6, 42));
+            EXPECT_EQ(loaded.values, result.values);
+        }
+
+        po2::save_binary_file(
+            "saved_typed_map", result, MIXED(int, 4, 5, 6, 42));
+        {
+            po2::typed_options loaded(MIXED(int, 4, 5, 6, 42));
+            po2::load_binary_file(
+                "saved_typed_map", loaded, MIXED(int, 4, 5, 6, 42));
+            EXPECT_EQ(loaded.values, result.values);
+        }
+
+        std::remove("saved_typed_map");
+        std::remove("saved_map_for_typed");
+    }
+
+    // Loading a file, and then parsing the command line on top of it, as
+    // with a map.
+    {
+        std::ofstream ofs("typed_response_file");
+        ofs << "--abacus 1 --bobcat 2 7 8";
+        ofs.close();
+
+        po2::typed_options result(MIXED(int, 4, 5, 6, 42));
+        po2::load_response_file(
+            "typed_response_file", result, MIXED(int, 4, 5, 6, 42));
+        EXPECT_EQ(result[0_c], 1);
+        EXPECT_EQ(result[1_c], 2);
+        EXPECT_EQ(result[2_c], std::vector<int>({7, 8}));
+        EXPECT_FALSE(result[3_c]);
+
+        std::vector<std::string_view> const more_args{
+            "prog", "-a", "3", "--dolemite", "6", "9", "10"};
+        std::ostringstream os;
+        auto const parser =
+            po2::make_parser("A program.", os, MIXED(int, 4, 5, 6, 42));
+        auto const status = parser.try_parse(more_args, result);
+        EXPECT_TRUE(status) << (int)status.error;
+        EXPECT_EQ(result[0_c], 3);
+        EXPECT_EQ(result[1_c], 2);
+        EXPECT_EQ(result[3_c], 6);
+
+        std::remove("typed_response_file");
+    }
+
+    // Errors are reported just as they are for maps.
+    {
+        po2::typed_options result(MIXED(int, 4, 5, 6, 42));
+        std::vector<std::string_view> const bad_args{
+            "prog", "1", "2", "--dolemite", "7"};
+        auto const status = po2::try_parse_command_line(
+            bad_args, result, MIXED(int, 4, 5, 6, 42));
+        EXPECT_FALSE(status);
+        EXPECT_EQ(status.error, po2::parse_option_error::no_such_choice);
+    }
+
+    // A slot that is not a std::optional is present only once it has been
+    // assigned, and is not saved before then.
+    {
+        po2::typed_options result(MIXED(int, 4, 5, 6, 42));
+        EXPECT_FALSE(result.contains("cataphract"));
+        EXPECT_FALSE(result.contains("args"));
+
+        std::vector<std::string_view> const some_args{
+            "prog", "-a", "1", "2", "3"};
+        auto const status = po2::try_parse_command_line(
+            some_args, result, MIXED(int, 4, 5, 6, 42));
+        EXPECT_TRUE(status) << (int)status.error;
+        EXPECT_TRUE(result.contains("abacus"));
+        EXPECT_TRUE(result.contains("bobcat"));
+        EXPECT_TRUE(result.contains("cataphract"));
+        EXPECT_FALSE(result.contains("dolemite"));
+        EXPECT_FALSE(result.contains("args"));
+
+        po2::save_json_file(
+            "unassigned_typed_map", result, MIXED(int, 4, 5, 6, 42));
+        po2::string_any_map m;
+        po2::load_json_file("unassigned_typed_map", m, MIXED(int, 4, 5, 6, 42));
+        EXPECT_EQ(m.size(), 3u);
+        EXPECT_EQ(m.count("args"), 0u);
+
+        po2::save_binary_file(
+            "unassigned_typed_map", result, MIXED(int, 4, 5, 6, 42));
+        po2::typed_options loaded(MIXED(int, 4, 5, 6, 42));
+        po2::load_binary_file(
+            "unassigned_typed_map", loaded, MIXED(int, 4, 5, 6, 42));
+        EXPECT_TRUE(loaded.contains("cataphract"));
+        EXPECT_FALSE(loaded.contains("args"));
+
+        // Assigning through values does not count; operator[] does.
+        result.values[4_c] = std::vector<std::string>{"x"};
+        EXPECT_FALSE(result.contains("args"));
+        result[4_c] = std::vector<std::string>{"x"};
+        EXPECT_TRUE(result.contains("args"));
+
+        std::remove("unassigned_typed_map");
+    }
+}
+
+TEST(storage, string_view_results_from_response_files)
+{
+    using namespace boost::hana::literals;
+
+    {
+        std::ofstream ofs("string_view_response_file");
+        ofs << "--abacus \"an \\\"escaped\\\" arg\" plain ";
+        ofs << "\"also plain\"";
+    }
+    std::vector<std::string_view> const args{
+        "prog", "@string_view_response_file"};
+
+    auto check = [](std::string_view abacus,
+                    std::vector<std::string_view> const & cataphract) {
+        EXPECT_EQ(abacus, "an \"escaped\" arg");
+        EXPECT_EQ(
+            cataphract,
+            std::vector<std::string_view>({"plain", "also plain"}));
+    };
+
+    // A typed_options keeps the files it was parsed from, and so do its
+    // copies.
+    {
+        std::optional<decltype(po2::typed_options(STRING_VIEWS))> copy;
+        {
+            po2::typed_options result(STRING_VIEWS);
+            std::ostringstream os;
+            po2::parse_command_line(
+                args, result, "A program.", os, STRING_VIEWS);
+            EXPECT_EQ(result.response_files.size(), 1u);
+            check(*result[0_c], result[1_c]);
+            copy = result;
+        }
+        check(*(*copy)[0_c], (*copy)[1_c]);
+
+        // An empty cache is reused by the next parse.
+        auto const parser =
+            po2::make_parser("A program.", std::cout, STRING_VIEWS);
+        EXPECT_TRUE(parser.try_parse(
+            std::vector<std::string_view>{"prog", "x", "y"}, *copy));
+        EXPECT_EQ(copy->response_files.size(), 1u);
+        copy->response_files.clear();
+        EXPECT_TRUE(copy->response_files.empty());
+    }
+    {
+        po2::typed_options result(STRING_VIEWS);
+        po2::load_response_file(
+            "string_view_response_file", result, STRING_VIEWS);
+        EXPECT_EQ(result.response_files.size(), 1u);
+        check(*result[0_c], result[1_c]);
+    }
+
+    // Files that no value refers to any longer are released.
+    {
+        {
+            std::ofstream ofs("string_view_response_file_2");
+            ofs << "--abacus \"an \\\"escaped\\\" arg\"";
+        }
+        auto const abacus = po2::argument("-a,--abacus", "The abacus.");
+        po2::typed_options result(abacus);
+        std::ostringstream os;
+        for (int i = 0; i < 3; ++i) {
+            po2::parse_command_line(
+                std::vector<std::string_view>{
+                    "prog", "@string_view_response_file_2"},
+                result,
+                "A program.",
+                os,
+                abacus);
+            EXPECT_EQ(result.response_files.size(), 1u);
+            EXPECT_EQ(*result[0_c], "an \"escaped\" arg");
+        }
+        for (int i = 0; i < 3; ++i) {
+            po2::load_response_file(
+                "string_view_response_file_2", result, abacus);
+            EXPECT_EQ(result.response_files.size(), 1u);
+            EXPECT_EQ(*result[0_c], "an \"escaped\" arg");
+        }
+        po2::parse_command_line(
+            std::vector<std::string_view>{"prog", "-a", "b"},
+            result,
+            "A program.",
+            os,
+            abacus);
+        EXPECT_TRUE(result.response_files.empty());
+        EXPECT_EQ(*result[0_c], "b");
+        std::remove("string_view_response_file_2");
+    }
+
+    // A map can use response_file_buffers of its own.
+    {
+        std::ostringstream os;
+        auto const parser = po2::make_parser("A program.", os, STRING_VIEWS);
+        po2::response_file_buffers buffers;
+        po2::string_view_any_map m;
+        parser.parse(args, m, buffers);
+        EXPECT_EQ(buffers.size(), 1u);
+
+        po2::string_view_any_map m2;
+        EXPECT_TRUE(parser.try_parse(args, m2, buffers));
+        EXPECT_EQ(buffers.size(), 2u);
+
+        std::remove("string_view_response_file");
+        check(
+            std::any_cast<std::string_view>(m["abacus"]),
+            std::any_cast<std::vector<std::string_view>>(m["cataphract"]));
+        check(
+            std::any_cast<std::string_view>(m2["abacus"]),
+            std::any_cast<std::vector<std::string_view>>(m2["cataphract"]));
+    }
+
+}
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_POSIX
+TEST(storage, save_keeps_file_mode_and_links)
+{
+    po2::string_any_map m;
+    m["abacus"] = 42;
+    auto const load = [](char const * filename) {
+        po2::string_any_map loaded;
+        po2::load_json_file(
+            filename, loaded, po2::argument<int>("-a,--abacus", "The abacus."));
+        return std::any_cast<int>(loaded["abacus"]);
+    };
+
+    // Saving over a private file leaves it private.
+    {
+        {
+            std::ofstream ofs("private_json_map");
+            ofs << "{}\n";
+        }
+        ASSERT_EQ(::chmod("private_json_map", 0600), 0);
+
+        po2::save_json_file(
+            "private_json_map",
+            m,
+            po2::argument<int>("-a,--abacus", "The abacus."));
+
+        struct stat st;
+        ASSERT_EQ(::stat("private_json_map", &st), 0);
+        EXPECT_EQ(st.st_mode & 07777, 0600u);
+        EXPECT_EQ(st.st_uid, ::getuid());
+        EXPECT_EQ(load("private_json_map"), 42);
+
+        std::remove("private_json_map");
+    }
+
+    // Saving through a symlink replaces the file it refers to, and keeps
+    // the link.
+    {
+        {
+            std::ofstream ofs("linked_json_map");
+            ofs << "{}\n";
+        }
+        ASSERT_EQ(::chmod("linked_json_map", 0640), 0);
+        std::remove("json_map_link");
+        ASSERT_EQ(::symlink("linked_json_map", "json_map_link"), 0);
+
+        po2::save_json_file(
+            "json_map_link",
+            m,
+            po2::argument<int>("-a,--abacus", "The abacus."));
+
+        struct stat st;
+        ASSERT_EQ(::lstat("json_map_link", &st), 0);
+        EXPECT_TRUE(S_ISLNK(st.st_mode));
+        ASSERT_EQ(::stat("linked_json_map", &st), 0);
+        EXPECT_EQ(st.st_mode & 07777, 0640u);
+        EXPECT_EQ(load("linked_json_map"), 42);
+
+        std::remove("json_map_link");
+        std::remove("linked_json_map");
+    }
+}
+#endif
+
+TEST(storage, watched_options)
+{
+    // Written atomically, so that a reload never sees a partial file.
+    auto const write = [](std::string_view contents) {
+        ASSERT_TRUE(
+            po2::detail::write_file_atomically("watched_map", contents));
+    };
+    auto const abacus = [](auto const & options) {
+        return std::any_cast<int>(options.read()->at("abacus"));
+    };
+    auto const wait_for_generation = [](auto const & options, auto n) {
+        for (int i = 0; i < 1000 && options.generation() < n; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return n <= options.generation();
+    };
+
+    write("--abacus 1\n--bobcat bob\n");
+    {
+        po2::watched_options<> options(
+            "watched_map",
+            po2::file_format::response_file,
+            std::chrono::milliseconds(10),
+            po2::argument<int>("-a,--abacus", "The abacus."),
+            po2::argument<std::string>("-b,--bobcat", "The bobcat."));
+        EXPECT_EQ(options.generation(), 1u);
+        EXPECT_EQ(options.last_result(), po2::load_result::success);
+        {
+            auto const snapshot = options.read();
+            EXPECT_EQ(snapshot->size(), 2u);
+            EXPECT_EQ(std::any_cast<int>(snapshot->at("abacus")), 1);
+            EXPECT_EQ(
+                std::any_cast<std::string>(snapshot->at("bobcat")), "bob");
+        }
+
+        // A change is noticed without any help.
+        write("--abacus 2\n--bobcat bob\n");
+        EXPECT_TRUE(wait_for_generation(options, 2u));
+        EXPECT_EQ(abacus(options), 2);
+
+        write("--abacus 3\n");
+        EXPECT_TRUE(wait_for_generation(options, 3u));
+        EXPECT_EQ(abacus(options), 3);
+        EXPECT_EQ(options.read()->size(), 1u);
+    }
+    {
+        po2::watched_options<> options(
+            "watched_map",
+            po2::file_format::response_file,
+            std::chrono::milliseconds(10),
+            po2::argument<int>("-a,--abacus", "The abacus."));
+        EXPECT_EQ(abacus(options), 3);
+
+        // A file that does not load leaves the options as they were.
+        write("--abacus three\n");
+        EXPECT_FALSE(options.reload());
+        EXPECT_EQ(options.last_result(), po2::load_result::cannot_parse_arg);
+        EXPECT_EQ(abacus(options), 3);
+
+        std::remove("watched_map");
+        EXPECT_FALSE(options.reload());
+        EXPECT_EQ(
+            options.last_result(),
+            po2::load_result::could_not_open_file_for_reading);
+        EXPECT_EQ(abacus(options), 3);
+
+        // Neither does a file that is replaced by one that does.
+        write("--abacus 4\n");
+        EXPECT_TRUE(options.reload());
+        EXPECT_EQ(options.last_result(), po2::load_result::success);
+        EXPECT_EQ(abacus(options), 4);
+    }
+    {
+        po2::string_any_map m;
+        m["abacus"] = 5;
+        po2::save_json_file(
+            "watched_map", m, po2::argument<int>("-a,--abacus", "The abacus."));
+        po2::watched_options<> options(
+            "watched_map",
+            po2::file_format::json,
+            po2::argument<int>("-a,--abacus", "The abacus."));
+        EXPECT_EQ(abacus(options), 5);
+    }
+    {
+        try {
+            po2::watched_options<> options(
+                "no_such_watched_map",
+                po2::file_format::json,
+                po2::argument<int>("-a,--abacus", "The abacus."));
+            ADD_FAILURE();
+        } catch (po2::load_error & e) {
+            EXPECT_EQ(
+                e.error(), po2::load_result::could_not_open_file_for_reading);
+        }
+    }
+    std::remove("watched_map");
+}
+
+#if BOOST_PROGRAM_OPTIONS_2_USE_SHARED_MEMORY
+TEST(storage, shared_options)
+{
+    std::ostringstream os;
+    std::vector<std::string_view> args{
+        "prog", "-a", "55", "77", "88", "--dolemite", "5", "x", "yz"};
+
+    // From a map, anonymously.
+    {
+        po2::string_any_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+
+        auto const shared =
+            po2::publish_shared_options("", m, MIXED(int, 4, 5, 6, 42));
+        EXPECT_EQ(shared.size(), 5u);
+        EXPECT_TRUE(shared.contains("abacus"));
+        EXPECT_FALSE(shared.contains("zebra"));
+        EXPECT_EQ(shared.get<int>("abacus"), 55);
+        EXPECT_EQ(shared.get<int>("bobcat"), 42);
+        EXPECT_EQ(shared.get<int>("dolemite"), 5);
+        EXPECT_EQ(shared.get<int>("zebra"), std::nullopt);
+        EXPECT_EQ(
+            shared.get<std::vector<int>>("cataphract"),
+            std::vector<int>({77, 88}));
+        EXPECT_EQ(
+            shared.get<std::vector<std::string>>("args"),
+            std::vector<std::string>({"x", "yz"}));
+        EXPECT_THROW(shared.get<double>("abacus"), std::bad_any_cast);
+
+        // No one can change it.
+        EXPECT_LT(::write(shared.fd(), "x", 1), 0);
+
+        // The spans refer into the shared memory.
+        auto const block = shared.block();
+        auto const span = *shared.get<std::span<int const>>("cataphract");
+        EXPECT_EQ(span.size(), 2u);
+        EXPECT_EQ(span[0], 77);
+        EXPECT_EQ(span[1], 88);
+        EXPECT_TRUE(
+            block.data() <= (char const *)span.data() &&
+            (char const *)(span.data() + span.size()) <=
+                block.data() + block.size());
+
+        // As an exec()ed process would, map it from a copy of the
+        // descriptor.
+        pid_t const pid = ::fork();
+        if (pid == 0) {
+            po2::shared_options const child(::dup(shared.fd()));
+            bool const ok = child.block().data() != block.data() &&
+                            child.get<int>("abacus") == 55 &&
+                            child.get<std::vector<int>>("cataphract") ==
+                                std::vector<int>({77, 88});
+            ::_exit(ok ? 0 : 1);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+
+    // From a typed_options.
+    {
+        po2::typed_options result(MIXED(int, 4, 5, 6, 42));
+        po2::parse_command_line(
+            args, result, "A program.", os, MIXED(int, 4, 5, 6, 42));
+
+        auto const shared =
+            po2::publish_shared_options("", result, MIXED(int, 4, 5, 6, 42));
+        EXPECT_EQ(shared.size(), 5u);
+        EXPECT_EQ(shared.get<int>("abacus"), 55);
+        EXPECT_EQ(shared.get<int>("bobcat"), 42);
+        EXPECT_EQ(
+            shared.get<std::vector<int>>("cataphract"),
+            std::vector<int>({77, 88}));
+    }
+
+    // From a tuple, by name.
+    {
+        std::string const name =
+            "/po2_storage_test_" + std::to_string(::getpid());
+        po2::remove_shared_options(name);
+
+        auto const a = po2::argument<int>("-a,--abacus", "The abacus.");
+        auto const b = po2::argument<int>("-b,--bobcat", "The bobcat.");
+        auto const c = po2::positional<std::vector<int>>(
+            "cataphract", "The cataphract", 2);
+        auto const d = po2::argument<std::string>("--dolemite", "Dolemite.");
+        auto const rest = po2::remainder<std::vector<std::string>>(
+            "args", "other args at the end");
+        auto const result =
+            po2::parse_command_line(args, "A program.", os, a, b, c, d, rest);
+
+        {
+            auto const shared =
+                po2::publish_shared_options(name, result, a, b, c, d, rest);
+            EXPECT_EQ(shared.size(), 4u);
+        }
+
+        EXPECT_THROW(
+            po2::publish_shared_options(name, result, a, b, c, d, rest),
+            po2::save_error);
+
+        auto const shared = po2::open_shared_options(name);
+        EXPECT_EQ(shared.size(), 4u);
+        EXPECT_EQ(shared.get<int>("abacus"), 55);
+        EXPECT_FALSE(shared.contains("bobcat"));
+        EXPECT_EQ(
+            shared.get<std::vector<int>>("cataphract"),
+            std::vector<int>({77, 88}));
+        EXPECT_EQ(shared.get<std::string>("dolemite"), "5");
+        EXPECT_EQ(shared.get<std::string_view>("dolemite"), "5");
+
+        EXPECT_TRUE(po2::remove_shared_options(name));
+        EXPECT_EQ(shared.get<int>("abacus"), 55);
+        EXPECT_THROW(po2::open_shared_options(name), po2::load_error);
+    }
+
+    // An option of the same type as the options in a mutually exclusive
+    // group that follows it.
+    {
+        auto const x = po2::argument<int>("--x", "X.");
+        auto const group = po2::exclusive(
+            po2::argument<int>("--a", "A."), po2::argument<int>("--b", "B."));
+        po2::string_any_map m;
+        m["x"] = 1;
+        m["a"] = 2;
+
+        auto const shared = po2::publish_shared_options("", m, x, group);
+        EXPECT_EQ(shared.size(), 2u);
+        EXPECT_EQ(shared.get<int>("x"), 1);
+        EXPECT_EQ(shared.get<int>("a"), 2);
+        EXPECT_FALSE(shared.contains("b"));
+    }
+
+    // Something other than published options.
+    {
+        std::ofstream ofs("not_shared_options");
+        ofs << "PO2S, but no more than that";
+        ofs.close();
+        try {
+            po2::shared_options const shared(
+                ::open("not_shared_options", O_RDONLY));
+            ADD_FAILURE();
+        } catch (po2::load_error & e) {
+            EXPECT_EQ(e.error(), po2::load_result::malformed_binary);
+        }
+        std::remove("not_shared_options");
+    }
+
+    // Published options with a span whose element count runs past the end
+    // of its value.
+    {
+        po2::string_any_map m;
+        po2::parse_command_line(
+            args, m, "A program.", os, MIXED(int, 4, 5, 6, 42));
+        auto const shared =
+            po2::publish_shared_options("", m, MIXED(int, 4, 5, 6, 42));
+        std::string block(shared.block());
+        auto const span = *shared.get<std::span<int const>>("cataphract");
+        auto const count_offset = (char const *)span.data() -
+                                  shared.block().data() - sizeof(std::uint64_t);
+        std::uint64_t const n = 1000;
+        std::memcpy(block.data() + count_offset, &n, sizeof(n));
+
+        {
+            std::ofstream ofs("corrupt_shared_options", std::ios::binary);
+            ofs << block;
+        }
+        po2::shared_options const corrupt(
+            ::open("corrupt_shared_options", O_RDONLY));
+        EXPECT_EQ(corrupt.get<int>("abacus"), 55);
+        try {
+            corrupt.get<std::span<int const>>("cataphract");
+            ADD_FAILURE();
+        } catch (po2::load_error & e) {
+            EXPECT_EQ(e.error(), po2::load_result::malformed_binary);
+        }
+        std::remove("corrupt_shared_options");
+    }
+}
+#endif
+
 #undef ARGUMENTS
 #undef MIXED
+#undef STRING_VIEWS